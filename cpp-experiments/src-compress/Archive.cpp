@@ -0,0 +1,175 @@
+#include "Archive.h"
+
+#include "Compressor.h"
+#include "LittleEndian.h"
+#include "ThreadPool.h"
+#include "string_view.h"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+static const char ARCHIVE_MAGIC[4] = { 'S', 'R', 'C', 'A' };
+static const size_t INDEX_ENTRY_SIZE = 8 + 8 + 4;
+static const size_t FOOTER_SIZE = 8 + 4 + sizeof(ARCHIVE_MAGIC);
+
+struct ArchiveBlock {
+	uint64_t offset;
+	uint64_t size_in_bits;
+	uint32_t source_length;
+};
+
+// Blocks end after the last line end of the block_size first bytes, or are cut at block_size
+// when there is none.
+static std::vector<string_view> split_blocks(const char * source, size_t size, unsigned int block_size) {
+	std::vector<string_view> blocks;
+	while (size > 0) {
+		size_t length = size;
+		if (length > block_size) {
+			length = block_size;
+			while (length > 0 && source[length - 1] != '\n') {
+				--length;
+			}
+			if (length == 0) {
+				length = block_size;
+			}
+		}
+		blocks.push_back(string_view(source, static_cast<int>(length)));
+		source += length;
+		size -= length;
+	}
+	return blocks;
+}
+
+namespace Archive {
+	std::string compress(const char * source, size_t size, ThreadPool & pool, unsigned int block_size) {
+		if (block_size == 0 || block_size > (1u << 30))
+			throw make_logic_error("Invalid block size!");
+
+		const std::vector<string_view> blocks = split_blocks(source, size, block_size);
+		std::vector<PackedBits> compressed(blocks.size());
+		pool.parallelFor(blocks.size(), [&blocks, &compressed](size_t i) {
+			compressed[i] = Compressor::compress(blocks[i]);
+		});
+
+		std::string archive(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+		std::vector<ArchiveBlock> index(blocks.size());
+		for (size_t i = 0; i < blocks.size(); ++i) {
+			index[i].offset = archive.size();
+			index[i].size_in_bits = compressed[i].sizeInBits;
+			index[i].source_length = static_cast<uint32_t>(blocks[i].length());
+			archive.append(reinterpret_cast<const char *>(compressed[i].data.data()), compressed[i].data.size());
+			compressed[i] = PackedBits();
+		}
+
+		const uint64_t index_offset = archive.size();
+		for (const ArchiveBlock & block : index) {
+			append_little_endian(archive, block.offset, 8);
+			append_little_endian(archive, block.size_in_bits, 8);
+			append_little_endian(archive, block.source_length, 4);
+		}
+		append_little_endian(archive, index_offset, 8);
+		append_little_endian(archive, blocks.size(), 4);
+		archive.append(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+		return archive;
+	}
+
+	std::string decompress(const unsigned char * data, size_t size, ThreadPool & pool) {
+		if (size < sizeof(ARCHIVE_MAGIC) + FOOTER_SIZE ||
+			std::memcmp(data, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 ||
+			std::memcmp(data + size - sizeof(ARCHIVE_MAGIC), ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0)
+			throw make_logic_error("Not an archive!");
+
+		const unsigned char * footer = data + size - FOOTER_SIZE;
+		const uint64_t index_offset = read_little_endian(footer, 8);
+		const uint64_t nb_blocks = read_little_endian(footer + 8, 4);
+		if (index_offset < sizeof(ARCHIVE_MAGIC) || index_offset > size - FOOTER_SIZE ||
+			(size - FOOTER_SIZE - index_offset) != nb_blocks * INDEX_ENTRY_SIZE)
+			throw make_logic_error("Invalid archive index!");
+
+		std::vector<ArchiveBlock> index(static_cast<size_t>(nb_blocks));
+		std::vector<size_t> source_offsets(index.size());
+		size_t source_size = 0;
+		for (size_t i = 0; i < index.size(); ++i) {
+			const unsigned char * entry = data + index_offset + i * INDEX_ENTRY_SIZE;
+			index[i].offset = read_little_endian(entry, 8);
+			index[i].size_in_bits = read_little_endian(entry + 8, 8);
+			index[i].source_length = static_cast<uint32_t>(read_little_endian(entry + 16, 4));
+			if (index[i].offset < sizeof(ARCHIVE_MAGIC) || index[i].offset > index_offset ||
+				(index[i].size_in_bits + 7) / 8 > index_offset - index[i].offset ||
+				index[i].size_in_bits > 0xFFFFFFFFu)
+				throw make_logic_error("Invalid archive block!");
+			source_offsets[i] = source_size;
+			source_size += index[i].source_length;
+		}
+
+		// blocks are decompressed in place in the final string
+		std::string source(source_size, '\0');
+		pool.parallelFor(index.size(), [&](size_t i) {
+			InputBitStream stream(data + index[i].offset, static_cast<unsigned int>(index[i].size_in_bits));
+			const std::string block = Compressor::decompress(stream);
+			if (block.size() != index[i].source_length)
+				throw make_logic_error("Archive block length mismatch!");
+			std::memcpy(&source[source_offsets[i]], block.data(), block.size());
+		});
+		return source;
+	}
+
+	void compressFile(const std::string & source_path, const std::string & archive_path) {
+		const std::string source = Compressor::readFile(source_path);
+		ThreadPool pool;
+		const std::string archive = compress(source.data(), source.size(), pool);
+		Compressor::writeFile(archive_path, archive.data(), archive.size());
+	}
+
+	void decompressFile(const std::string & archive_path, const std::string & source_path) {
+		const std::string archive = Compressor::readFile(archive_path);
+		ThreadPool pool;
+		const std::string source = decompress(reinterpret_cast<const unsigned char *>(archive.data()), archive.size(), pool);
+		Compressor::writeFile(source_path, source.data(), source.size());
+	}
+}
+
+// ----------------------------------------------------------------
+
+static void test_archive_round_trip(const std::string & source, unsigned int block_size) {
+	for (unsigned int nb_threads : { 1, 3 }) {
+		ThreadPool pool(nb_threads);
+		const std::string archive = Archive::compress(source.data(), source.size(), pool, block_size);
+		assert(Archive::decompress(reinterpret_cast<const unsigned char *>(archive.data()), archive.size(), pool) == source);
+	}
+}
+
+void test_Archive() {
+	test_archive_round_trip("", 16);
+	test_archive_round_trip("x", 16);
+	test_archive_round_trip("int main() {\n\treturn 0;\n}\n", 1);
+
+	std::string source;
+	for (int i = 0; i < 300; ++i) {
+		source += "int Value_" + std::to_string(i) + " = compute(value_" + std::to_string(i % 7) + ");\n";
+	}
+	source += "aVeryLongIdentifierWithoutAnyLineEnd";
+	for (unsigned int block_size : { 7u, 64u, 1000u, Archive::DEFAULT_BLOCK_SIZE }) {
+		test_archive_round_trip(source, block_size);
+	}
+
+	// blocks are cut after line ends
+	const std::string lines = "first line\nsecond line\nthird\n";
+	const std::vector<string_view> blocks = split_blocks(lines.data(), lines.size(), 25);
+	assert(blocks.size() == 2);
+	assert(blocks[0] == string_view("first line\nsecond line\n"));
+	assert(blocks[1] == string_view("third\n"));
+
+	ThreadPool pool(2);
+	std::string archive = Archive::compress(source.data(), source.size(), pool, 256);
+	bool thrown = false;
+	try {
+		archive[archive.size() - 1] = 'X';
+		Archive::decompress(reinterpret_cast<const unsigned char *>(archive.data()), archive.size(), pool);
+	} catch (const std::logic_error &) {
+		thrown = true;
+	}
+	assert(thrown);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+class ThreadPool;
+
+// Chunked container for large sources: the source is cut into blocks (at line ends when possible)
+// compressed independently by Compressor::compress(), so that blocks are compressed and decompressed
+// in parallel. Each block starts with a fresh stream: case state, symbol dictionaries and symbol coding
+// don't cross block boundaries.
+//
+// Layout (integers are little endian):
+//   "SRCA"
+//   compressed blocks, each one starting on a byte boundary
+//   block index: for each block, byte offset (64 bits), size in bits (64 bits), source length (32 bits)
+//   index byte offset (64 bits), number of blocks (32 bits), "SRCA"
+namespace Archive {
+	static const unsigned int DEFAULT_BLOCK_SIZE = 1 << 20;
+
+	std::string compress(const char * source, size_t size, ThreadPool & pool, unsigned int block_size = DEFAULT_BLOCK_SIZE);
+	std::string decompress(const unsigned char * data, size_t size, ThreadPool & pool);
+
+	void compressFile(const std::string & source_path, const std::string & archive_path);
+	void decompressFile(const std::string & archive_path, const std::string & source_path);
+}
+
+void test_Archive();
@@ -0,0 +1,386 @@
+#include "Benchmark.h"
+
+#include "BitStream.h"
+#include "Encoder.h"
+#include "Decoder.h"
+#include "SymbolCodeUnpacker.h"
+#include "CharClassifier.h"
+#include "Compressor.h"
+#include "ThreadPool.h"
+#include "Archive.h"
+#include "SymbolDictionary.h"
+#include "MappedArchive.h"
+#include "string_view.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Builds identifiers such as "getValue", "m_node_count" or "Buffer32" from a small word list.
+static std::vector<std::string> generate_symbol_names(unsigned int nb_names) {
+	static const char * words[] = {
+		"get", "set", "value", "index", "count", "buffer", "stream", "encoder", "decoder", "size",
+		"data", "node", "item", "begin", "end", "first", "last", "next", "string", "view",
+		"table", "entry", "symbol", "name", "length", "bits", "input", "output", "result", "context",
+	};
+	const unsigned int nb_words = sizeof(words) / sizeof(words[0]);
+
+	std::vector<std::string> names;
+	names.reserve(nb_names);
+	unsigned int seed = 12345;
+	auto next_random = [&seed]() {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 16) & 0x7FFF;
+	};
+	for (unsigned int i = 0; i < nb_names; ++i) {
+		const unsigned int style = next_random() % 4;
+		const unsigned int nb_parts = 1 + next_random() % 3;
+		std::string name = (style == 3) ? "m_" : "";
+		for (unsigned int part = 0; part < nb_parts; ++part) {
+			std::string word = words[next_random() % nb_words];
+			if (style == 0 && part > 0) {
+				word[0] = static_cast<char>(word[0] - 'a' + 'A');
+			} else if (style == 1) {
+				word[0] = static_cast<char>(word[0] - 'a' + 'A');
+			} else if (style >= 2 && part > 0) {
+				word = "_" + word;
+			}
+			name += word;
+		}
+		if (next_random() % 8 == 0) {
+			name += std::to_string(next_random() % 128);
+		}
+		names.push_back(name);
+	}
+	return names;
+}
+
+template<typename DecodeFunction>
+static void bench_decoder(const char * label, const std::vector<PackedBits> & encoded, DecodeFunction decode) {
+	const int nb_repetitions = 20;
+	size_t nb_chars = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < nb_repetitions; ++i) {
+		for (const PackedBits & bits : encoded) {
+			InputBitStream stream(bits.data.data(), bits.sizeInBits);
+			nb_chars += decode(stream).length();
+		}
+	}
+	auto stop = std::chrono::steady_clock::now();
+
+	const double seconds = std::chrono::duration<double>(stop - start).count();
+	const double nb_symbols = static_cast<double>(encoded.size()) * nb_repetitions;
+	std::cout << label << ": "
+		<< nb_symbols / seconds / 1e6 << " M symbols/s, "
+		<< nb_chars / seconds / 1e6 << " M chars/s\n";
+}
+
+// Sequences of names: one stream decoded a name after the other, against NB_INTERLEAVED_STREAMS
+// streams advanced together.
+static void bench_interleaved_decoder(const std::vector<std::string> & names) {
+	OutputBitStream sequential_output;
+	OutputBitStream interleaved_output[NB_INTERLEAVED_STREAMS];
+	for (size_t i = 0; i < names.size(); ++i) {
+		const string_view name(names[i].data(), static_cast<int>(names[i].size()));
+		sequential_output.appendVarUInt(name.length() - 1);
+		string_view str = name;
+		Encoder::encodeNextSymbolName(sequential_output, str);
+		Encoder::encodeInterleavedSymbolName(interleaved_output, static_cast<unsigned int>(i), name);
+	}
+	const PackedBits sequential = sequential_output.release();
+	PackedBits interleaved[NB_INTERLEAVED_STREAMS];
+	for (unsigned int i = 0; i < NB_INTERLEAVED_STREAMS; ++i) {
+		interleaved[i] = interleaved_output[i].release();
+	}
+
+	const int nb_repetitions = 20;
+	size_t nb_sequential_names = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < nb_repetitions; ++i) {
+		InputBitStream stream(sequential.data.data(), sequential.sizeInBits);
+		SymbolTable table;
+		std::string name;
+		while (!stream.isEmpty()) {
+			name.clear();
+			Decoder::decodeSymbolName(stream, stream.readVarUInt() + 1, name);
+			table.add(name.data(), static_cast<unsigned int>(name.length()));
+		}
+		nb_sequential_names += table.size();
+	}
+	auto middle = std::chrono::steady_clock::now();
+	size_t nb_interleaved_names = 0;
+	for (int i = 0; i < nb_repetitions; ++i) {
+		std::vector<InputBitStream> input;
+		InputBitStream * streams[NB_INTERLEAVED_STREAMS];
+		for (const PackedBits & bits : interleaved) {
+			input.push_back(InputBitStream(bits.data.data(), bits.sizeInBits));
+		}
+		for (unsigned int j = 0; j < NB_INTERLEAVED_STREAMS; ++j) {
+			streams[j] = &input[j];
+		}
+		SymbolTable tables[NB_INTERLEAVED_STREAMS];
+		Decoder::decodeInterleavedSymbolNames(streams, tables);
+		for (const SymbolTable & table : tables) {
+			nb_interleaved_names += table.size();
+		}
+	}
+	auto stop = std::chrono::steady_clock::now();
+
+	std::cout << "- sequence, 1 stream : " << nb_sequential_names / std::chrono::duration<double>(middle - start).count() / 1e6 << " M symbols/s\n"
+		<< "- sequence, " << NB_INTERLEAVED_STREAMS << " streams: " << nb_interleaved_names / std::chrono::duration<double>(stop - middle).count() / 1e6 << " M symbols/s\n";
+}
+
+static void bench_Decoder() {
+	const std::vector<std::string> names = generate_symbol_names(200000);
+	std::vector<PackedBits> encoded;
+	encoded.reserve(names.size());
+	for (const std::string & name : names) {
+		OutputBitStream stream;
+		string_view str(name.c_str());
+		Encoder::encodeNextSymbolName(stream, str);
+		encoded.push_back(stream.release());
+	}
+
+	std::cout << "Decoder (" << names.size() << " symbol names, " << SymbolCodeUnpacker::implementationName() << " unpacker)\n";
+	bench_decoder("- code by code ", encoded, Decoder::decodeNextSymbolNameCodeByCode);
+	bench_decoder("- table driven ", encoded, static_cast<std::string (*)(InputBitStream &)>(Decoder::decodeNextSymbolName));
+	char buffer[256];
+	bench_decoder("- into buffer  ", encoded, [&buffer](InputBitStream & stream) {
+		return string_view(buffer, static_cast<int>(Decoder::decodeNextSymbolName(stream, buffer, sizeof(buffer))));
+	});
+	bench_decoder("- bulk unpacked", encoded, Decoder::decodeNextSymbolNameBulk);
+	bench_interleaved_decoder(names);
+}
+
+// Long camel case identifiers (generated code, mangled names) have a case change every few letters.
+static void bench_Encoder() {
+	const std::vector<std::string> words = generate_symbol_names(20000);
+	std::cout << "Encoder (" << CharClassifier::implementationName() << " classifier)\n";
+	for (size_t length : { 16, 256, 4096, 65536 }) {
+		std::string identifier;
+		for (size_t i = 0; identifier.size() < length; ++i) {
+			std::string word = words[i % words.size()];
+			word[0] = static_cast<char>(std::toupper(word[0]));
+			identifier += word;
+		}
+		identifier.resize(length);
+
+		const size_t nb_chars_per_run = 1 << 21;
+		const size_t nb_repetitions = std::max<size_t>(1, nb_chars_per_run / length);
+		size_t nb_bits = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < nb_repetitions; ++i) {
+			OutputBitStream stream;
+			string_view str(identifier.data(), static_cast<int>(identifier.size()));
+			Encoder::encodeNextSymbolName(stream, str);
+			nb_bits += stream.sizeInBits();
+		}
+		auto stop = std::chrono::steady_clock::now();
+
+		const double seconds = std::chrono::duration<double>(stop - start).count();
+		std::cout << "- " << length << " chars identifiers: "
+			<< static_cast<double>(length) * nb_repetitions / seconds / 1e6 << " M chars/s ("
+			<< static_cast<double>(nb_bits) / nb_repetitions << " bits each)\n";
+	}
+}
+
+static void bench_Compressor(const std::vector<std::string> & corpus_files) {
+	std::vector<std::string> sources;
+	size_t corpus_size = 0;
+	for (const std::string & path : corpus_files) {
+		sources.push_back(Compressor::readFile(path));
+		corpus_size += sources.back().size();
+	}
+	if (corpus_size == 0) {
+		std::cout << "Compressor: no corpus given\n";
+		return;
+	}
+
+	std::cout << "Compressor (" << sources.size() << " files, " << corpus_size << " bytes)\n";
+	const std::pair<Compressor::SYMBOL_CODING, const char *> codings[] = {
+		{ Compressor::SYMBOL_CODING_FIXED, "fixed" },
+		{ Compressor::SYMBOL_CODING_HUFFMAN, "Huffman" },
+		{ Compressor::SYMBOL_CODING_RANS, "rANS" },
+		{ Compressor::SYMBOL_CODING_INTERLEAVED, "interleaved" },
+	};
+	for (const auto & coding : codings) {
+		const int nb_repetitions = 5;
+		std::vector<PackedBits> compressed(sources.size());
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < nb_repetitions; ++i) {
+			for (size_t j = 0; j < sources.size(); ++j) {
+				compressed[j] = Compressor::compress(string_view(sources[j].data(), static_cast<int>(sources[j].size())), coding.first);
+			}
+		}
+		auto middle = std::chrono::steady_clock::now();
+		size_t decompressed_size = 0;
+		for (int i = 0; i < nb_repetitions; ++i) {
+			for (const PackedBits & bits : compressed) {
+				InputBitStream stream(bits.data.data(), bits.sizeInBits);
+				decompressed_size += Compressor::decompress(stream).size();
+			}
+		}
+		auto stop = std::chrono::steady_clock::now();
+
+		size_t compressed_size = 0;
+		for (const PackedBits & bits : compressed) {
+			compressed_size += bits.data.size();
+		}
+		const double total_mb = static_cast<double>(corpus_size) * nb_repetitions / 1e6;
+		std::cout << "- " << coding.second << " symbol codes\n"
+			<< "  - ratio     : " << static_cast<double>(compressed_size) / corpus_size << "\n"
+			<< "  - compress  : " << total_mb / std::chrono::duration<double>(middle - start).count() << " MB/s\n"
+			<< "  - decompress: " << total_mb / std::chrono::duration<double>(stop - middle).count() << " MB/s\n";
+		if (decompressed_size != corpus_size * nb_repetitions) {
+			std::cout << "  decompressed size mismatch!\n";
+		}
+	}
+}
+
+// The whole corpus as a single archive, compressed with one thread then with all of them.
+static void bench_Archive(const std::vector<std::string> & corpus_files) {
+	std::string corpus;
+	for (const std::string & path : corpus_files) {
+		corpus += Compressor::readFile(path);
+	}
+	if (corpus.empty()) {
+		return;
+	}
+
+	std::cout << "Archive (" << corpus.size() << " bytes)\n";
+	for (unsigned int nb_threads : { 1u, std::thread::hardware_concurrency() }) {
+		ThreadPool pool(nb_threads);
+		const int nb_repetitions = 5;
+		std::string archive;
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < nb_repetitions; ++i) {
+			archive = Archive::compress(corpus.data(), corpus.size(), pool);
+		}
+		auto middle = std::chrono::steady_clock::now();
+		bool same = true;
+		for (int i = 0; i < nb_repetitions; ++i) {
+			same &= Archive::decompress(reinterpret_cast<const unsigned char *>(archive.data()), archive.size(), pool) == corpus;
+		}
+		auto stop = std::chrono::steady_clock::now();
+
+		const double total_mb = static_cast<double>(corpus.size()) * nb_repetitions / 1e6;
+		std::cout << "- " << pool.size() << " thread(s)\n"
+			<< "  - ratio     : " << static_cast<double>(archive.size()) / corpus.size() << "\n"
+			<< "  - compress  : " << total_mb / std::chrono::duration<double>(middle - start).count() << " MB/s\n"
+			<< "  - decompress: " << total_mb / std::chrono::duration<double>(stop - middle).count() << " MB/s\n";
+		if (!same) {
+			std::cout << "  decompressed archive mismatch!\n";
+		}
+	}
+}
+
+// Opening a mapped archive of the corpus and decompressing a single file from it.
+static void bench_MappedArchive(const std::vector<std::string> & corpus_files) {
+	if (corpus_files.empty()) {
+		return;
+	}
+	const std::string archive_path = "bench_MappedArchive.tmp";
+	MappedArchive::buildFile(archive_path, corpus_files);
+
+	const int nb_repetitions = 1000;
+	size_t found = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < nb_repetitions; ++i) {
+		const MappedArchive archive(archive_path);
+		found += archive.find(corpus_files[i % corpus_files.size()].c_str()) != MappedArchive::NOT_FOUND;
+	}
+	auto middle = std::chrono::steady_clock::now();
+	size_t decompressed_size = 0;
+	for (int i = 0; i < nb_repetitions; ++i) {
+		const MappedArchive archive(archive_path);
+		decompressed_size += archive.decompress(archive.find(corpus_files[i % corpus_files.size()].c_str())).size();
+	}
+	auto stop = std::chrono::steady_clock::now();
+	std::remove(archive_path.c_str());
+
+	std::cout << "MappedArchive (" << corpus_files.size() << " files)\n"
+		<< "- open + find             : " << std::chrono::duration<double, std::micro>(middle - start).count() / nb_repetitions << " us\n"
+		<< "- open + find + decompress: " << std::chrono::duration<double, std::micro>(stop - middle).count() / nb_repetitions
+		<< " us per file (" << decompressed_size / nb_repetitions << " bytes on average)\n";
+	if (found != nb_repetitions) {
+		std::cout << "  files not found!\n";
+	}
+}
+
+// Full build of a mapped archive of the corpus against an incremental one with a single file changed.
+static void bench_MappedArchive_update(const std::vector<std::string> & corpus_files) {
+	if (corpus_files.empty()) {
+		return;
+	}
+	std::vector<MappedArchive::SourceFile> files;
+	for (const std::string & path : corpus_files) {
+		files.push_back(MappedArchive::SourceFile{ path, Compressor::readFile(path) });
+	}
+	ThreadPool pool;
+	auto start = std::chrono::steady_clock::now();
+	const std::string archive_bytes = MappedArchive::build(files, pool);
+	auto middle = std::chrono::steady_clock::now();
+	files[0].content += "\n";
+	const MappedArchive archive(reinterpret_cast<const unsigned char *>(archive_bytes.data()), archive_bytes.size());
+	size_t nb_reused = 0;
+	MappedArchive::update(archive, files, pool, nullptr, &nb_reused);
+	auto stop = std::chrono::steady_clock::now();
+
+	std::cout << "MappedArchive update (" << pool.size() << " thread(s))\n"
+		<< "- build                 : " << std::chrono::duration<double, std::milli>(middle - start).count() << " ms\n"
+		<< "- update, 1 file changed: " << std::chrono::duration<double, std::milli>(stop - middle).count() << " ms ("
+		<< nb_reused << " files reused)\n";
+}
+
+static void bench_MappedArchive_search(const std::vector<std::string> & corpus_files) {
+	if (corpus_files.empty()) {
+		return;
+	}
+	std::vector<MappedArchive::SourceFile> files;
+	for (const std::string & path : corpus_files) {
+		files.push_back(MappedArchive::SourceFile{ path, Compressor::readFile(path) });
+	}
+	ThreadPool pool;
+	const std::string archive_bytes = MappedArchive::build(files, pool);
+	const MappedArchive archive(reinterpret_cast<const unsigned char *>(archive_bytes.data()), archive_bytes.size());
+
+	// the same query answered from decompressed sources, with a plain text search
+	const string_view name("decodeSymbolName");
+	auto start = std::chrono::steady_clock::now();
+	size_t nb_decompressed_matches = 0;
+	for (size_t i = 0; i < archive.nbFiles(); ++i) {
+		if (archive.decompress(i).find("decodeSymbolName") != std::string::npos) {
+			nb_decompressed_matches += 1;
+		}
+	}
+	auto middle = std::chrono::steady_clock::now();
+	ThreadPool single_thread(1);
+	const size_t nb_matches = archive.findSymbolName(name, single_thread).size();
+	auto middle2 = std::chrono::steady_clock::now();
+	const size_t nb_parallel_matches = archive.findSymbolName(name, pool).size();
+	auto stop = std::chrono::steady_clock::now();
+
+	std::cout << "MappedArchive symbol name search (" << archive.nbFiles() << " files)\n"
+		<< "- decompress and find: " << std::chrono::duration<double, std::milli>(middle - start).count() << " ms ("
+		<< nb_decompressed_matches << " files)\n"
+		<< "- compressed, 1 thread: " << std::chrono::duration<double, std::milli>(middle2 - middle).count() << " ms ("
+		<< nb_matches << " files)\n"
+		<< "- compressed, " << pool.size() << " threads: " << std::chrono::duration<double, std::milli>(stop - middle2).count() << " ms ("
+		<< nb_parallel_matches << " files)\n";
+}
+
+void run_benchmarks(const std::vector<std::string> & corpus_files) {
+	bench_Encoder();
+	bench_Decoder();
+	bench_Compressor(corpus_files);
+	bench_Archive(corpus_files);
+	bench_MappedArchive(corpus_files);
+	bench_MappedArchive_update(corpus_files);
+	bench_MappedArchive_search(corpus_files);
+}
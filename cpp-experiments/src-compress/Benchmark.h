@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Micro-benchmarks, run with "SrcCompress --bench [corpus files...]".
+void run_benchmarks(const std::vector<std::string> & corpus_files);
@@ -1,32 +1,26 @@
 #include "BitStream.h"
 
 #include <cassert>
+#include <cstring>
 #include <algorithm>
 
-static unsigned char extract_char_bits_in_range(unsigned int value, unsigned int first_bit, unsigned int nb_bits) {
-	assert(first_bit <= 31);
-	assert(nb_bits > 0 && nb_bits <= 8);
-	assert(first_bit >= nb_bits - 1);
-	value >>= first_bit - (nb_bits - 1);
-	unsigned int mask = (1 << nb_bits) - 1;
-	return static_cast<unsigned char>(value & mask);
+OutputBitStream::OutputBitStream(ByteSink sink, size_t chunk_size) :
+	m_sink(std::move(sink)),
+	m_sink_chunk_size(chunk_size) {
+	if (!m_sink || chunk_size == 0)
+		throw make_logic_error("invalid sink");
+	m_data.reserve(chunk_size + 4);
 }
 
 std::string OutputBitStream::toString(unsigned int c, unsigned int nb_bits) {
 	assert(nb_bits <= 32);
 
-	std::string str;
-	str.reserve(nb_bits);
-
+	std::string str(nb_bits, '0');
 	for (unsigned int i = 0; i < nb_bits; ++i) {
-		unsigned int mask = 1 << i;
-		if (c & mask) {
-			str = "1" + str;
-		} else {
-			str = "0" + str;
+		if (c & (1u << i)) {
+			str[nb_bits - 1 - i] = '1';
 		}
 	}
-	assert(str.length() == nb_bits);
 	return str;
 }
 
@@ -35,35 +29,94 @@ std::string OutputBitStream::toString() const {
 	str.reserve(m_data.size() * 8 + m_pending_bits);
 
 	for (unsigned char c : m_data) {
-		str += toString(c, 8);
+		for (int i = 7; i >= 0; --i) {
+			str += (c & (1 << i)) ? '1' : '0';
+		}
+	}
+	for (int i = static_cast<int>(m_pending_bits) - 1; i >= 0; --i) {
+		str += (m_pending_data & (uint64_t(1) << i)) ? '1' : '0';
 	}
-	str += toString(m_pending_data, m_pending_bits);
 
 	return str;
 }
 
-void OutputBitStream::appendBits(unsigned int value, unsigned int nb_bits_to_encode) {
-	assert(nb_bits_to_encode <= 32);
-	if (nb_bits_to_encode == 0)
-		return;
+void OutputBitStream::appendBytes(const unsigned char * bytes, size_t nb_bytes) {
+	assert(m_pending_bits % 8 == 0);
+	while (m_pending_bits >= 8) {
+		m_pending_bits -= 8;
+		m_data.push_back(static_cast<unsigned char>(m_pending_data >> m_pending_bits));
+	}
+	m_data.insert(m_data.end(), bytes, bytes + nb_bytes);
+	if (m_sink_chunk_size != 0 && m_data.size() >= m_sink_chunk_size) {
+		flushChunks();
+	}
+}
+
+void OutputBitStream::flushChunks() {
+	size_t offset = 0;
+	while (m_data.size() - offset >= m_sink_chunk_size) {
+		m_sink(m_data.data() + offset, m_sink_chunk_size);
+		offset += m_sink_chunk_size;
+	}
+	m_data.erase(m_data.begin(), m_data.begin() + offset);
+	m_flushed_bytes += offset;
+}
+
+void OutputBitStream::appendPackedBits(const PackedBits & bits) {
+	const size_t nb_full_bytes = bits.sizeInBits / 8;
+	if (m_pending_bits % 8 == 0) {
+		appendBytes(bits.data.data(), nb_full_bytes);
+	} else {
+		for (size_t i = 0; i < nb_full_bytes; ++i) {
+			appendBits(bits.data[i], 8);
+		}
+	}
+	const unsigned int nb_tail_bits = bits.sizeInBits % 8;
+	if (nb_tail_bits > 0) {
+		appendBits(bits.data[nb_full_bytes] >> (8 - nb_tail_bits), nb_tail_bits);
+	}
+}
 
-	assert(m_pending_bits < 8);
-	const unsigned int remaining_bits = 8 - m_pending_bits;
-	const unsigned int nb_bits = std::min(remaining_bits, nb_bits_to_encode);
-	m_pending_data <<= nb_bits;
-	m_pending_data += extract_char_bits_in_range(value, nb_bits_to_encode - 1, nb_bits);
-	m_pending_bits += nb_bits;
-	assert(m_pending_bits <= 8);
+PackedBits OutputBitStream::release() {
+	if (m_sink)
+		throw make_logic_error("the stream writes to a sink");
+	if (sizeInBits() > UINT32_MAX)
+		throw make_logic_error("too many bits for PackedBits");
+	PackedBits bits;
+	bits.sizeInBits = static_cast<unsigned int>(sizeInBits());
 
-	if (m_pending_bits == 8) {
-		m_data.push_back(m_pending_data);
-		m_pending_data = 0;
-		m_pending_bits = 0;
+	// flush the pending bits, left aligned on byte boundaries
+	while (m_pending_bits >= 8) {
+		m_pending_bits -= 8;
+		m_data.push_back(static_cast<unsigned char>(m_pending_data >> m_pending_bits));
 	}
+	if (m_pending_bits > 0) {
+		m_data.push_back(static_cast<unsigned char>(m_pending_data << (8 - m_pending_bits)));
+	}
+	assert(m_data.size() * 8 >= bits.sizeInBits && m_data.size() * 8 < bits.sizeInBits + 8);
+
+	bits.data = std::move(m_data);
+	m_data.clear();
+	m_pending_data = 0;
+	m_pending_bits = 0;
+	return bits;
+}
 
-	if (nb_bits != nb_bits_to_encode) {
-		return appendBits(value, nb_bits_to_encode - nb_bits);
+uint64_t OutputBitStream::finish() {
+	if (!m_sink)
+		throw make_logic_error("the stream doesn't write to a sink");
+	alignToByte();
+	while (m_pending_bits >= 8) {
+		m_pending_bits -= 8;
+		m_data.push_back(static_cast<unsigned char>(m_pending_data >> m_pending_bits));
 	}
+	flushChunks();
+	if (!m_data.empty()) {
+		m_sink(m_data.data(), m_data.size());
+		m_flushed_bytes += m_data.size();
+		m_data.clear();
+	}
+	return m_flushed_bytes;
 }
 
 // ----------------------------------------------------------------
@@ -74,6 +127,7 @@ bool InputBitStream::isEmpty() const {
 }
 
 InputBitStream::InputBitStream(std::string stream) {
+	m_storage.reserve((stream.length() + 7) / 8);
 	unsigned char value = 0;
 	for (char c : stream) {
 		assert(c == '0' || c == '1');
@@ -82,7 +136,7 @@ InputBitStream::InputBitStream(std::string stream) {
 			value += 1;
 		m_size_in_bits += 1;
 		if (m_size_in_bits % 8 == 0) {
-			m_data.push_back(value);
+			m_storage.push_back(value);
 			value = 0;
 		}
 	}
@@ -91,37 +145,171 @@ InputBitStream::InputBitStream(std::string stream) {
 			int padding_size = 8 - (m_size_in_bits % 8);
 			value <<= padding_size;
 		}
-		m_data.push_back(value);
+		m_storage.push_back(value);
 	}
+	m_data = m_storage.data();
+	m_nb_bytes = static_cast<unsigned int>(m_storage.size());
 }
 
-bool InputBitStream::readSymbolCode(SYMBOL_NAME_CODES::ENUM & code) {
-	unsigned int value;
-	if (!readBits(SYMBOL_NAME_CODES::BIT_WIDTH, value)) {
-		return false;
+InputBitStream::InputBitStream(PackedBits bits) :
+	m_size_in_bits(bits.sizeInBits),
+	m_storage(std::move(bits.data)) {
+	if (m_storage.size() * 8 < m_size_in_bits)
+		throw make_logic_error("not enough data for the given bit length");
+	m_data = m_storage.data();
+	m_nb_bytes = (m_size_in_bits + 7) / 8;
+}
+
+InputBitStream::InputBitStream(const unsigned char * data, unsigned int size_in_bits) :
+	m_size_in_bits(size_in_bits),
+	m_data(data),
+	m_nb_bytes((size_in_bits + 7) / 8) {
+	assert(data != nullptr || size_in_bits == 0);
+}
+
+InputBitStream::InputBitStream(ByteSource source, unsigned int size_in_bits, size_t window_size) :
+	m_size_in_bits(size_in_bits),
+	// the window must at least hold the 8 bytes of a refill
+	m_storage(std::max<size_t>(window_size, 16)),
+	m_source(std::move(source)),
+	m_source_bytes_left((size_in_bits + 7) / 8) {
+	if (!m_source)
+		throw make_logic_error("invalid source");
+	m_data = m_storage.data();
+}
+
+InputBitStream::InputBitStream(InputBitStream && other) {
+	*this = std::move(other);
+}
+
+InputBitStream & InputBitStream::operator=(InputBitStream && other) {
+	if (this != &other) {
+		BitStream::operator=(other);
+		const bool owns_data = (other.m_data == other.m_storage.data());
+		m_size_in_bits = other.m_size_in_bits;
+		m_current_bit = other.m_current_bit;
+		m_window_offset = other.m_window_offset;
+		m_nb_bytes = other.m_nb_bytes;
+		m_next_byte = other.m_next_byte;
+		m_bit_buffer = other.m_bit_buffer;
+		m_buffered_bits = other.m_buffered_bits;
+		m_storage = std::move(other.m_storage);
+		m_data = owns_data ? m_storage.data() : other.m_data;
+		m_source = std::move(other.m_source);
+		m_source_bytes_left = other.m_source_bytes_left;
+		m_read_bytes = std::move(other.m_read_bytes);
+		m_symbol_code_source = other.m_symbol_code_source;
+		other.m_size_in_bits = 0;
+		other.m_current_bit = 0;
+		other.m_data = nullptr;
+		other.m_window_offset = 0;
+		other.m_source = nullptr;
+		other.m_source_bytes_left = 0;
+		other.m_nb_bytes = 0;
+		other.m_next_byte = 0;
+		other.m_bit_buffer = 0;
+		other.m_buffered_bits = 0;
+		other.m_symbol_code_source = nullptr;
 	}
-	code = static_cast<SYMBOL_NAME_CODES::ENUM>(value);
-	return true;
+	return *this;
 }
 
-bool InputBitStream::readBits(unsigned int nb_bits, unsigned int & result) {
-	assert(nb_bits > 0 && nb_bits <= 32);
-	if (m_current_bit + nb_bits > m_size_in_bits)
-		return false;
+void InputBitStream::refill() {
+	if (likely(m_next_byte + 8 <= m_nb_bytes)) {
+		// Load a whole word and keep as many complete bytes as fit in the buffer.
+		// The bits loaded past those bytes are the same that will be or-ed by the next refill.
+		m_bit_buffer |= load_big_endian_64(m_data + m_next_byte) >> m_buffered_bits;
+		m_next_byte += (63 - m_buffered_bits) >> 3;
+		m_buffered_bits |= 56;
+	} else if (m_source_bytes_left > 0) {
+		// the window now holds at least 8 more bytes, or all the remaining ones
+		pullFromSource();
+		refill();
+	} else {
+		while (m_buffered_bits <= 56 && m_next_byte < m_nb_bytes) {
+			m_bit_buffer |= static_cast<uint64_t>(m_data[m_next_byte]) << (56 - m_buffered_bits);
+			m_next_byte += 1;
+			m_buffered_bits += 8;
+		}
+	}
+	// the last byte of a caller-owned buffer may hold bits past the end of the stream
+	const unsigned int remaining_bits = m_size_in_bits - m_current_bit;
+	if (unlikely(remaining_bits < 64)) {
+		m_bit_buffer &= (remaining_bits == 0) ? 0 : ~uint64_t(0) << (64 - remaining_bits);
+	}
+}
 
-	result = 0;
-	for (unsigned int i = 0; i < nb_bits; ++i) {
-		int char_pos = m_current_bit / 8;
-		int bit_pos = 7 - (m_current_bit % 8);
-		auto data = m_data[char_pos];
-		int bit_value = data & (1 << bit_pos) ? 1 : 0;
-		result <<= 1;
-		if (bit_value == 1)
-			result += 1;
-		m_current_bit += 1;
+void InputBitStream::skipBits(unsigned int nb_bits) {
+	assert(m_current_bit + nb_bits <= m_size_in_bits);
+	if (nb_bits <= m_buffered_bits) {
+		consume(nb_bits);
+		return;
 	}
-	assert(m_current_bit <= m_size_in_bits);
-	return true;
+	m_current_bit += nb_bits;
+	// the bytes up to m_next_byte are in the bit buffer, so the new position is past them
+	m_next_byte = m_current_bit / 8 - m_window_offset;
+	if (m_next_byte > m_nb_bytes) {
+		discardSourceBytes(m_next_byte - m_nb_bytes);
+	}
+	// refilled from the start of the byte, as the bit buffer is aligned on m_current_bit
+	const unsigned int bit_in_byte = m_current_bit % 8;
+	m_current_bit -= bit_in_byte;
+	m_bit_buffer = 0;
+	m_buffered_bits = 0;
+	refill();
+	m_current_bit += bit_in_byte;
+	m_bit_buffer <<= bit_in_byte;
+	m_buffered_bits -= std::min(m_buffered_bits, bit_in_byte);
+}
+
+void InputBitStream::pullFromSource() {
+	assert(m_source && m_next_byte <= m_nb_bytes);
+	const unsigned int nb_kept_bytes = m_nb_bytes - m_next_byte;
+	std::memmove(m_storage.data(), m_storage.data() + m_next_byte, nb_kept_bytes);
+	m_window_offset += m_next_byte;
+	m_next_byte = 0;
+	m_nb_bytes = nb_kept_bytes;
+
+	const unsigned int nb_wanted_bytes = std::min(m_source_bytes_left, static_cast<unsigned int>(m_storage.size()) - nb_kept_bytes);
+	for (unsigned int nb_read_bytes = 0; nb_read_bytes < nb_wanted_bytes; ) {
+		const size_t n = m_source(m_storage.data() + m_nb_bytes, nb_wanted_bytes - nb_read_bytes);
+		if (n == 0 || n > nb_wanted_bytes - nb_read_bytes)
+			throw std::runtime_error("Unexpected end of input");
+		nb_read_bytes += static_cast<unsigned int>(n);
+		m_nb_bytes += static_cast<unsigned int>(n);
+	}
+	m_source_bytes_left -= nb_wanted_bytes;
+}
+
+void InputBitStream::discardSourceBytes(unsigned int nb_bytes) {
+	assert(m_source && nb_bytes <= m_source_bytes_left);
+	m_window_offset += m_nb_bytes;
+	m_next_byte = 0;
+	m_nb_bytes = 0;
+	while (nb_bytes > 0) {
+		const size_t n = m_source(m_storage.data(), std::min<size_t>(nb_bytes, m_storage.size()));
+		if (n == 0 || n > nb_bytes)
+			throw std::runtime_error("Unexpected end of input");
+		nb_bytes -= static_cast<unsigned int>(n);
+		m_source_bytes_left -= static_cast<unsigned int>(n);
+		m_window_offset += static_cast<unsigned int>(n);
+	}
+}
+
+const unsigned char * InputBitStream::readBytes(size_t nb_bytes) {
+	assert(m_current_bit % 8 == 0);
+	if (nb_bytes * 8 > remainingBits())
+		throw make_logic_error("can't read bytes");
+	if (m_source) {
+		m_read_bytes.resize(nb_bytes);
+		for (unsigned char & byte : m_read_bytes) {
+			byte = static_cast<unsigned char>(readBits(8));
+		}
+		return m_read_bytes.data();
+	}
+	const unsigned char * bytes = m_data + m_current_bit / 8;
+	skipBits(static_cast<unsigned int>(nb_bytes * 8));
+	return bytes;
 }
 
 // ----------------------------------------------------------------
@@ -140,18 +328,26 @@ static void test_appendBits() {
 	stream.appendBits(0b1011001, 7);
 	assert(stream.sizeInBits() == 24);
 	assert(stream.toString() == "100101011101100101011001");
+	stream.appendBits(0b1110001, 7);
+	assert(stream.sizeInBits() == 31);
+	assert(stream.toString() == "1001010111011001010110011110001");
+	stream.appendBits(0xFFFFFFFF, 32);
+	assert(stream.sizeInBits() == 63);
+	assert(stream.toString() == "1001010111011001010110011110001" + std::string(32, '1'));
+	stream.appendBits(0, 0);
+	assert(stream.sizeInBits() == 63);
 }
 
-void test_OutputBitStream() {
-	assert(extract_char_bits_in_range(0b1010, 0, 1) == 0);
-	assert(extract_char_bits_in_range(0b1011, 0, 1) == 1);
-	assert(extract_char_bits_in_range(0b1010, 1, 1) == 1);
-	assert(extract_char_bits_in_range(0b1001, 1, 1) == 0);
-	assert(extract_char_bits_in_range(0b1001, 2, 2) == 0);
-	assert(extract_char_bits_in_range(0b1001, 2, 3) == 1);
-	assert(extract_char_bits_in_range(0b1001, 3, 2) == 0b10);
-	assert(extract_char_bits_in_range(0b1001, 3, 4) == 0b1001);
+static void test_appendBits_ignores_high_bits() {
+	OutputBitStream stream;
+	stream.appendBits(0xFFFFFFF2, 3);
+	assert(stream.toString() == "010");
+	stream.appendBits(0xFFFFFFF0, 31);
+	assert(stream.sizeInBits() == 34);
+	assert(stream.toString() == "010" + std::string(27, '1') + "0000");
+}
 
+void test_OutputBitStream() {
 	assert(OutputBitStream::toString(0, 0) == "");
 	assert(OutputBitStream::toString(0, 3) == "000");
 	assert(OutputBitStream::toString(0b100, 3) == "100");
@@ -160,6 +356,256 @@ void test_OutputBitStream() {
 	assert(OutputBitStream::toString(0b1110110000110001110, 19) == "1110110000110001110");
 
 	test_appendBits();
+	test_appendBits_ignores_high_bits();
+}
+
+static void test_release() {
+	OutputBitStream output;
+	output.appendBits(0b10010, 5);
+	output.appendBits(0xABCDEF12, 32);
+	output.appendBits(0b110, 3);
+	const std::string text = output.toString();
+	PackedBits bits = output.release();
+	assert(bits.sizeInBits == 40);
+	assert(bits.data.size() == 5);
+	assert(bits.data[0] == 0b10010101);
+	assert(output.sizeInBits() == 0);
+	assert(output.toString().empty());
+
+	InputBitStream input(std::move(bits));
+	assert(input.remainingBits() == 40);
+	assert(input.readBits(5) == 0b10010);
+	assert(input.readBits(32) == 0xABCDEF12);
+	assert(input.readBits(3) == 0b110);
+	assert(input.isEmpty());
+	assert(text == "10010" + OutputBitStream::toString(0xABCDEF12, 32) + "110");
+
+	// partial last byte
+	output.appendBits(0b1011, 4);
+	bits = output.release();
+	assert(bits.sizeInBits == 4);
+	assert(bits.data.size() == 1 && bits.data[0] == 0b10110000);
+}
+
+static void test_caller_owned_buffer() {
+	const unsigned char data[] = { 0b11010110, 0b01000000 };
+	InputBitStream stream(data, 10);
+	assert(stream.readBits(3) == 0b110);
+	assert(stream.readBits(7) == 0b1011001);
+	assert(stream.isEmpty());
+
+	InputBitStream moved(std::move(stream));
+	assert(moved.isEmpty());
+
+	// the bits of the buffer past the end of the stream are not read
+	const unsigned char ones[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+	InputBitStream truncated(ones, 12);
+	assert(truncated.peekBits(16) == 0xFFF0);
+	truncated.skipBits(5);
+	assert(truncated.peekBits(16) == 0xFE00);
+	assert(truncated.readBits(7) == 0x7F);
+	assert(truncated.peekBits(32) == 0);
+	InputBitStream long_truncated(ones, 70);
+	long_truncated.skipBits(60);
+	assert(long_truncated.peekBits(16) == 0xFFC0);
+}
+
+static void test_peek_and_consume() {
+	OutputBitStream output;
+	for (unsigned int i = 0; i < 100; ++i) {
+		output.appendBits(i % 32, 5);
+		output.appendBits(i, 13);
+	}
+	InputBitStream input(output.release());
+	for (unsigned int i = 0; i < 100; ++i) {
+		assert(input.peekBits(5) == i % 32);
+		assert(input.peekBits(5) == i % 32);
+		input.consume(5);
+		assert(input.readBits(13) == i);
+	}
+	assert(input.isEmpty());
+	unsigned int value;
+	assert(!input.readBits(1, value));
+	assert(input.peekBits(32) == 0);
+}
+
+static void test_read_all_widths() {
+	for (unsigned int width = 1; width <= 32; ++width) {
+		const unsigned int mask = static_cast<unsigned int>((uint64_t(1) << width) - 1);
+		OutputBitStream output;
+		output.appendBits(1, 3);
+		for (unsigned int i = 0; i < 50; ++i) {
+			output.appendBits(0x9E3779B9u * i, width);
+		}
+		InputBitStream input(output.release());
+		assert(input.readBits(3) == 1);
+		for (unsigned int i = 0; i < 50; ++i) {
+			assert(input.readBits(width) == ((0x9E3779B9u * i) & mask));
+		}
+		assert(input.isEmpty());
+	}
+}
+
+static void test_skipBits() {
+	OutputBitStream output;
+	for (unsigned int i = 0; i < 64; ++i) {
+		output.appendBits(i, 7);
+	}
+	InputBitStream input(output.release());
+	assert(input.currentBit() == 0);
+	input.skipBits(3 * 7);
+	assert(input.readBits(7) == 3);
+	input.skipBits(20 * 7);
+	assert(input.currentBit() == 24 * 7);
+	assert(input.readBits(7) == 24);
+	input.skipBits(0);
+	assert(input.peekBits(7) == 25);
+	input.skipBits(38 * 7);
+	assert(input.readBits(7) == 63);
+	assert(input.isEmpty());
+}
+
+static void test_varUInt() {
+	const unsigned int values[] = { 0, 1, 15, 16, 255, 256, 4095, 4096, 123456789, 0xFFFFFFFF };
+	OutputBitStream output;
+	for (unsigned int value : values) {
+		output.appendVarUInt(value);
+	}
+	InputBitStream input(output.release());
+	for (unsigned int value : values) {
+		assert(input.readVarUInt() == value);
+	}
+	assert(input.isEmpty());
+
+	OutputBitStream small;
+	small.appendVarUInt(15);
+	assert(small.toString() == "01111");
+	small.appendVarUInt(16);
+	assert(small.toString() == "01111" "10000" "00001");
+}
+
+static void test_bytes() {
+	const unsigned char bytes[] = { 1, 2, 3 };
+	OutputBitStream output;
+	output.appendBits(0b101, 3);
+	output.alignToByte();
+	assert(output.sizeInBits() == 8);
+	output.alignToByte();
+	assert(output.sizeInBits() == 8);
+	output.appendBits(0xABCD, 16);
+	output.appendBytes(bytes, 3);
+	output.appendBits(1, 1);
+	assert(output.sizeInBits() == 49);
+
+	InputBitStream input(output.release());
+	assert(input.readBits(3) == 0b101);
+	input.alignToByte();
+	assert(input.readBits(16) == 0xABCD);
+	const unsigned char * read = input.readBytes(3);
+	assert(read[0] == 1 && read[1] == 2 && read[2] == 3);
+	assert(input.readBits(1) == 1);
+	assert(input.isEmpty());
+
+	OutputBitStream source;
+	source.appendBits(0x1234567, 27);
+	const PackedBits packed = source.release();
+	for (unsigned int offset : { 0, 3, 8 }) {
+		OutputBitStream target;
+		target.appendBits(0, offset);
+		target.appendPackedBits(packed);
+		assert(target.sizeInBits() == offset + 27);
+		InputBitStream copy(target.release());
+		copy.skipBits(offset);
+		assert(copy.readBits(27) == 0x1234567);
+	}
+}
+
+// Random fields written through a sink in 3-byte chunks and read back through a source returning
+// 1 to 5 bytes at a time: most fields straddle a chunk or a window boundary.
+static void test_streaming() {
+	std::vector<unsigned int> widths;
+	std::vector<unsigned int> values;
+	unsigned int seed = 17;
+	for (int i = 0; i < 2000; ++i) {
+		seed = seed * 1103515245 + 12345;
+		widths.push_back(1 + (seed >> 16) % 32);
+		seed = seed * 1103515245 + 12345;
+		values.push_back(seed & static_cast<unsigned int>((uint64_t(1) << widths.back()) - 1));
+	}
+
+	OutputBitStream reference;
+	std::vector<unsigned char> sunk;
+	std::vector<size_t> chunk_sizes;
+	OutputBitStream output([&sunk, &chunk_sizes](const unsigned char * bytes, size_t nb_bytes) {
+		sunk.insert(sunk.end(), bytes, bytes + nb_bytes);
+		chunk_sizes.push_back(nb_bytes);
+	}, 3);
+	const unsigned char bytes[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0x01, 0x02, 0x03 };
+	for (size_t i = 0; i < widths.size(); ++i) {
+		reference.appendBits(values[i], widths[i]);
+		output.appendBits(values[i], widths[i]);
+		if (i == 1000) {
+			reference.alignToByte();
+			reference.appendBytes(bytes, sizeof(bytes));
+			output.alignToByte();
+			output.appendBytes(bytes, sizeof(bytes));
+		}
+	}
+	const unsigned int size_in_bits = reference.sizeInBits();
+	assert(output.sizeInBits() == size_in_bits);
+	const PackedBits packed = reference.release();
+	assert(output.finish() == packed.data.size());
+	assert(sunk == packed.data);
+	for (size_t i = 0; i + 1 < chunk_sizes.size(); ++i) {
+		assert(chunk_sizes[i] == 3);
+	}
+
+	// the source has a few more bytes than the stream, which must not be read
+	std::vector<unsigned char> source_bytes = packed.data;
+	source_bytes.push_back(0xFF);
+	size_t position = 0;
+	auto source = [&source_bytes, &position, &seed](unsigned char * buffer, size_t nb_bytes) {
+		seed = seed * 1103515245 + 12345;
+		const size_t n = std::min(std::min(nb_bytes, static_cast<size_t>(1 + (seed >> 16) % 5)), source_bytes.size() - position);
+		std::memcpy(buffer, source_bytes.data() + position, n);
+		position += n;
+		return n;
+	};
+	InputBitStream input(source, size_in_bits, 16);
+	assert(input.pullsFromSource());
+	for (size_t i = 0; i < widths.size(); ++i) {
+		if (i % 100 == 7) {
+			input.skipBits(widths[i]);
+		} else {
+			assert(input.readBits(widths[i]) == values[i]);
+		}
+		if (i == 1000) {
+			input.alignToByte();
+			const unsigned char * read = input.readBytes(sizeof(bytes));
+			assert(std::memcmp(read, bytes, sizeof(bytes)) == 0);
+		}
+	}
+	assert(input.isEmpty());
+	assert(position == packed.data.size());
+
+	// long skips are pulled and dropped without going through the bit buffer
+	position = 0;
+	InputBitStream skipping(source, size_in_bits, 16);
+	skipping.skipBits(size_in_bits - widths.back());
+	assert(skipping.readBits(widths.back()) == values.back());
+	assert(position == packed.data.size());
+
+	// a truncated source
+	source_bytes.resize(10);
+	position = 0;
+	InputBitStream truncated(source, size_in_bits, 16);
+	bool thrown = false;
+	try {
+		truncated.skipBits(200);
+	} catch (const std::runtime_error &) {
+		thrown = true;
+	}
+	assert(thrown);
 }
 
 void test_InputBitStream() {
@@ -176,4 +622,38 @@ void test_InputBitStream() {
 		assert(stream.readBits(9) == 0b000011111);
 		assert(stream.isEmpty());
 	}
+	{
+		InputBitStream stream("101");
+		InputBitStream moved(std::move(stream));
+		assert(moved.readBits(3) == 0b101);
+		assert(moved.isEmpty());
+	}
+	{
+		// the rANS source of the symbol codes follows the stream
+		unsigned int counts[SymbolRansModel::NB_SYMBOLS] = {};
+		counts[SYMBOL_NAME_CODES::LETTER_A] = 1;
+		counts[SYMBOL_NAME_CODES::LETTER_B] = 1;
+		const SymbolRansModel model = SymbolRansModel::fromCounts(counts);
+		const std::vector<unsigned char> codes = { SYMBOL_NAME_CODES::LETTER_B, SYMBOL_NAME_CODES::LETTER_A };
+		const std::vector<unsigned char> rans_data = SymbolRans::encode(model, codes);
+		SymbolRansDecoder decoder(model, rans_data.data(), rans_data.size(), static_cast<unsigned int>(codes.size()));
+		InputBitStream stream("1");
+		stream.setSymbolCodeSource(&decoder);
+		InputBitStream moved(std::move(stream));
+		assert(stream.symbolCodeSource() == nullptr);
+		assert(moved.symbolCodeSource() == &decoder);
+		const SYMBOL_NAME_CODES::ENUM first = moved.readSymbolCode();
+		const SYMBOL_NAME_CODES::ENUM second = moved.readSymbolCode();
+		assert(first == SYMBOL_NAME_CODES::LETTER_B && second == SYMBOL_NAME_CODES::LETTER_A);
+		assert(!moved.hasSymbolCode());
+		assert(moved.readBits(1) == 1);
+	}
+	test_release();
+	test_caller_owned_buffer();
+	test_peek_and_consume();
+	test_read_all_widths();
+	test_skipBits();
+	test_varUInt();
+	test_bytes();
+	test_streaming();
 }
\ No newline at end of file
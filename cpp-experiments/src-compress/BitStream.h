@@ -1,15 +1,33 @@
 #pragma once
 
 #include "EncodingTables.h"
+#include "SymbolHuffmanCode.h"
+#include "SymbolRansCoder.h"
 
 #include <vector>
 #include <string>
 #include <stdexcept>
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+#include <functional>
 
 #define make_logic_error(str) std::logic_error(std::string("Error (" __FUNCTION__ ") : ") + str)
 #define likely(x) x
 #define unlikely(x) x
 
+inline uint64_t load_big_endian_64(const unsigned char * p) {
+	return
+		(static_cast<uint64_t>(p[0]) << 56) |
+		(static_cast<uint64_t>(p[1]) << 48) |
+		(static_cast<uint64_t>(p[2]) << 40) |
+		(static_cast<uint64_t>(p[3]) << 32) |
+		(static_cast<uint64_t>(p[4]) << 24) |
+		(static_cast<uint64_t>(p[5]) << 16) |
+		(static_cast<uint64_t>(p[6]) << 8) |
+		(static_cast<uint64_t>(p[7]));
+}
+
 class BitStream {
 public:
 	enum CASE_KIND { CASE_LOWER, CASE_UPPER };
@@ -20,34 +38,179 @@ public:
 	void invertCurrentCase() {
 		m_currentCase = (m_currentCase == CASE_LOWER) ? CASE_UPPER : CASE_LOWER;
 	}
+
+	// SYMBOL_NAME_CODES are written with this code, or on BIT_WIDTH bits if null.
+	// The code must outlive the stream.
+	const SymbolHuffmanCode * symbolHuffmanCode() const {
+		return m_symbolHuffmanCode;
+	}
+	void setSymbolHuffmanCode(const SymbolHuffmanCode * code) {
+		m_symbolHuffmanCode = code;
+	}
 private:
 	CASE_KIND m_currentCase = CASE_LOWER;
+	const SymbolHuffmanCode * m_symbolHuffmanCode = nullptr;
+};
+
+// Streaming: bytes are handed to a sink, or pulled from a source which returns the number of bytes
+// written to the buffer (0 at the end of the input, fewer than asked for otherwise is allowed).
+typedef std::function<void(const unsigned char * bytes, size_t nb_bytes)> ByteSink;
+typedef std::function<size_t(unsigned char * buffer, size_t nb_bytes)> ByteSource;
+
+// Packed bits (most significant bit first) with their exact length.
+// The last byte is padded with zeros when sizeInBits is not a multiple of 8.
+struct PackedBits {
+	std::vector<unsigned char> data;
+	unsigned int sizeInBits = 0;
 };
 
 // Allows to serialize data by adding a few bits (from 1 to 32) at a time.
+// Bits are gathered in a 64-bit accumulator and written out 32 bits at a time,
+// most significant bit first.
 class OutputBitStream : public BitStream {
 public:
 	static std::string toString(unsigned int c, unsigned int nb_bits);
 
+	static const size_t DEFAULT_CHUNK_SIZE = 1 << 16;
+
+	OutputBitStream() = default;
+	// The bytes are handed to sink chunk_size bytes at a time as soon as they are complete, so the
+	// stream only holds about one chunk whatever the size of the output. finish() writes the last one.
+	explicit OutputBitStream(ByteSink sink, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
 public:
-	unsigned int sizeInBits() const {
-		return static_cast<unsigned int>(m_data.size()) * 8 + m_pending_bits;
+	// 64 bits: a stream writing to a sink can go past 4 Gbits.
+	uint64_t sizeInBits() const {
+		return (m_flushed_bytes + m_data.size()) * 8 + m_pending_bits;
+	}
+
+	// Pre-allocates the output buffer so that nb_bits can be appended without reallocation.
+	void reserve(unsigned int nb_bits) {
+		m_data.reserve(nb_bits / 8 + 4);
 	}
 
-	void appendBits(unsigned int value, unsigned int nb_bits);
+	void appendBits(unsigned int value, unsigned int nb_bits) {
+		assert(nb_bits <= 32);
+		assert(m_pending_bits < 32);
+		const uint64_t mask = (uint64_t(1) << nb_bits) - 1;
+		m_pending_data = (m_pending_data << nb_bits) | (value & mask);
+		m_pending_bits += nb_bits;
+		if (m_pending_bits >= 32) {
+			m_pending_bits -= 32;
+			flushWord(static_cast<uint32_t>(m_pending_data >> m_pending_bits));
+		}
+	}
+
+	void appendSymbolCode(SYMBOL_NAME_CODES::ENUM code) {
+		if (unlikely(m_count_symbol_codes)) {
+			m_symbol_code_frequencies[code] += 1;
+		}
+		const SymbolHuffmanCode * huffman = symbolHuffmanCode();
+		if (likely(huffman == nullptr && m_deferred_symbol_codes == nullptr)) {
+			appendBits(code, SYMBOL_NAME_CODES::BIT_WIDTH);
+		} else if (m_deferred_symbol_codes != nullptr) {
+			m_deferred_symbol_codes->push_back(static_cast<unsigned char>(code));
+		} else {
+			if (unlikely(huffman->codeLength(code) == 0))
+				throw make_logic_error("no Huffman code for this symbol code");
+			appendBits(huffman->code(code), huffman->codeLength(code));
+		}
+	}
+
+	// Symbol codes are stored in codes instead of the stream (to be entropy coded separately)
+	// while codes is not null.
+	void deferSymbolCodes(std::vector<unsigned char> * codes) {
+		m_deferred_symbol_codes = codes;
+	}
+
+	// Counts the symbol codes appended while enabled (off by default): only the passes that need the
+	// frequencies (Huffman code, rANS model, statistics) pay for it.
+	void countSymbolCodes(bool enabled) {
+		m_count_symbol_codes = enabled;
+	}
+
+	// Number of times each SYMBOL_NAME_CODES has been appended while counted.
+	const unsigned int (&symbolCodeFrequencies() const)[SymbolHuffmanCode::NB_SYMBOLS] {
+		return m_symbol_code_frequencies;
+	}
+
+	// Variable length unsigned integer: groups of 4 bits (least significant first), each one
+	// preceded by a bit telling if another group follows.
+	void appendVarUInt(unsigned int value) {
+		while (value >= 16) {
+			appendBits(0x10 | (value & 0xF), 5);
+			value >>= 4;
+		}
+		appendBits(value, 5);
+	}
+
+	// Pads with zeros up to the next byte boundary.
+	void alignToByte() {
+		appendBits(0, (8 - m_pending_bits % 8) % 8);
+	}
+
+	// The stream must be aligned on a byte boundary.
+	void appendBytes(const unsigned char * bytes, size_t nb_bytes);
+	void appendPackedBits(const PackedBits & bits);
 
 	std::string toString() const;
 
+	// Moves the packed bits out of the stream, which is left empty.
+	// Not available when the stream writes to a sink.
+	PackedBits release();
+
+	// Pads the last byte with zeros and hands the remaining bytes to the sink.
+	// Returns the number of bytes written to the sink since the construction of the stream.
+	uint64_t finish();
+
 private:
-	unsigned char m_pending_data = 0;
+	void flushWord(uint32_t word) {
+		const unsigned char bytes[4] = {
+			static_cast<unsigned char>(word >> 24),
+			static_cast<unsigned char>(word >> 16),
+			static_cast<unsigned char>(word >> 8),
+			static_cast<unsigned char>(word)
+		};
+		m_data.insert(m_data.end(), bytes, bytes + 4);
+		if (unlikely(m_sink_chunk_size != 0 && m_data.size() >= m_sink_chunk_size)) {
+			flushChunks();
+		}
+	}
+
+	// Hands the complete chunks of m_data to the sink.
+	void flushChunks();
+
+	// only the m_pending_bits lowest bits are meaningful
+	uint64_t m_pending_data = 0;
 	unsigned int m_pending_bits = 0;
 	std::vector<unsigned char> m_data;
+	unsigned int m_symbol_code_frequencies[SymbolHuffmanCode::NB_SYMBOLS] = {};
+	bool m_count_symbol_codes = false;
+	std::vector<unsigned char> * m_deferred_symbol_codes = nullptr;
+	ByteSink m_sink;
+	size_t m_sink_chunk_size = 0;
+	uint64_t m_flushed_bytes = 0;
 };
 
 // Allows to de-serialize (extract) data from a flow a few bits at a time.
 class InputBitStream : public BitStream {
 public:
+	// Parses a '0'/'1' text representation (see OutputBitStream::toString()).
 	InputBitStream(std::string stream);
+	// Takes ownership of the packed bits.
+	explicit InputBitStream(PackedBits bits);
+	// Reads from a caller-owned buffer that must outlive the stream.
+	InputBitStream(const unsigned char * data, unsigned int size_in_bits);
+	// Pulls the (size_in_bits + 7) / 8 bytes of the stream from source as they are needed, through a
+	// window of window_size bytes: no more bytes are read from the source.
+	InputBitStream(ByteSource source, unsigned int size_in_bits, size_t window_size = DEFAULT_WINDOW_SIZE);
+
+	static const size_t DEFAULT_WINDOW_SIZE = 1 << 16;
+
+	InputBitStream(const InputBitStream &) = delete;
+	InputBitStream & operator=(const InputBitStream &) = delete;
+	InputBitStream(InputBitStream && other);
+	InputBitStream & operator=(InputBitStream && other);
 
 	unsigned int remainingBits() const {
 		return m_size_in_bits - m_current_bit;
@@ -55,8 +218,76 @@ public:
 
 	bool isEmpty() const;
 
-	bool readSymbolCode(SYMBOL_NAME_CODES::ENUM & code);
-	
+	bool pullsFromSource() const {
+		return static_cast<bool>(m_source);
+	}
+
+	// Raw access to the underlying bytes, for bulk readers (not when pulling from a source).
+	const unsigned char * data() const {
+		return m_data;
+	}
+	unsigned int dataSizeInBytes() const {
+		return m_nb_bytes;
+	}
+	// Position of the next bit to read.
+	unsigned int currentBit() const {
+		return m_current_bit;
+	}
+
+	bool readSymbolCode(SYMBOL_NAME_CODES::ENUM & code) {
+		const SymbolHuffmanCode * huffman = symbolHuffmanCode();
+		if (likely(huffman == nullptr && m_symbol_code_source == nullptr)) {
+			unsigned int value;
+			if (!readBits(SYMBOL_NAME_CODES::BIT_WIDTH, value)) {
+				return false;
+			}
+			code = static_cast<SYMBOL_NAME_CODES::ENUM>(value);
+			return true;
+		}
+		if (m_symbol_code_source != nullptr) {
+			if (m_symbol_code_source->remainingSymbols() == 0) {
+				return false;
+			}
+			code = static_cast<SYMBOL_NAME_CODES::ENUM>(m_symbol_code_source->decodeSymbol());
+			return true;
+		}
+		const SymbolHuffmanCode::DecodingEntry entry = huffman->decode(peekBits(SymbolHuffmanCode::MAX_CODE_LENGTH));
+		if (unlikely(entry.length == 0 || entry.length > remainingBits())) {
+			return false;
+		}
+		consume(entry.length);
+		code = static_cast<SYMBOL_NAME_CODES::ENUM>(entry.symbol);
+		return true;
+	}
+
+	// Tells if a symbol code may follow: symbol names spanning the rest of the stream end otherwise.
+	bool hasSymbolCode() const {
+		if (m_symbol_code_source != nullptr) {
+			return m_symbol_code_source->remainingSymbols() > 0;
+		}
+		const SymbolHuffmanCode * huffman = symbolHuffmanCode();
+		return remainingBits() >= ((huffman == nullptr) ? SYMBOL_NAME_CODES::BIT_WIDTH : huffman->minCodeLength());
+	}
+
+	// Symbol codes are read from source instead of the stream while source is not null.
+	// The source must outlive the stream.
+	void setSymbolCodeSource(SymbolRansDecoder * source) {
+		m_symbol_code_source = source;
+	}
+	const SymbolRansDecoder * symbolCodeSource() const {
+		return m_symbol_code_source;
+	}
+
+	// Skips the padding up to the next byte boundary.
+	void alignToByte() {
+		skipBits(std::min(remainingBits(), (8 - m_current_bit % 8) % 8));
+	}
+
+	// Returns a pointer to the next nb_bytes bytes (in place, not copied) and skips them.
+	// When pulling from a source, the bytes are copied and the pointer is valid until the next call.
+	// The stream must be aligned on a byte boundary.
+	const unsigned char * readBytes(size_t nb_bytes);
+
 	SYMBOL_NAME_CODES::ENUM readSymbolCode() {
 		SYMBOL_NAME_CODES::ENUM e;
 		if (!readSymbolCode(e))
@@ -71,12 +302,74 @@ public:
 		return value;
 	}
 
-	bool readBits(unsigned int nb_bits, unsigned int & result);
+	bool readBits(unsigned int nb_bits, unsigned int & result) {
+		assert(nb_bits > 0 && nb_bits <= 32);
+		if (unlikely(m_current_bit + nb_bits > m_size_in_bits))
+			return false;
+		result = peekBits(nb_bits);
+		consume(nb_bits);
+		return true;
+	}
+
+	// See OutputBitStream::appendVarUInt().
+	unsigned int readVarUInt() {
+		unsigned int value = 0;
+		for (unsigned int shift = 0; shift < 32; shift += 4) {
+			const unsigned int group = readBits(5);
+			value |= (group & 0xF) << shift;
+			if ((group & 0x10) == 0)
+				return value;
+		}
+		throw make_logic_error("invalid variable length integer");
+	}
+
+	// Returns the next nb_bits bits (from 1 to 32) without consuming them.
+	// Bits past the end of the stream are read as zeros, even if the buffer holds more.
+	unsigned int peekBits(unsigned int nb_bits) {
+		assert(nb_bits > 0 && nb_bits <= 32);
+		if (m_buffered_bits < nb_bits)
+			refill();
+		return static_cast<unsigned int>(m_bit_buffer >> (64 - nb_bits));
+	}
+
+	// Skips nb_bits bits that have been peeked.
+	void consume(unsigned int nb_bits) {
+		assert(nb_bits <= m_buffered_bits);
+		assert(m_current_bit + nb_bits <= m_size_in_bits);
+		m_bit_buffer <<= nb_bits;
+		m_buffered_bits -= nb_bits;
+		m_current_bit += nb_bits;
+	}
+
+	// Skips any number of bits, peeked or not.
+	void skipBits(unsigned int nb_bits);
 
 private:
+	// Tops up the bit buffer so that it holds at least 56 bits (unless the end of data is reached).
+	void refill();
+	// Moves the unread bytes of the window to its start and fills the rest from the source.
+	void pullFromSource();
+	// Drops nb_bytes bytes of the source, past the window.
+	void discardSourceBytes(unsigned int nb_bytes);
+
 	unsigned int m_size_in_bits = 0;
 	unsigned int m_current_bit = 0;
-	std::vector<unsigned char> m_data;
+	// points either to m_storage or to a caller-owned buffer
+	const unsigned char * m_data = nullptr;
+	// m_data holds the bytes from m_window_offset to m_window_offset + m_nb_bytes of the stream
+	// (all of them unless pulling from a source)
+	unsigned int m_window_offset = 0;
+	unsigned int m_nb_bytes = 0;
+	unsigned int m_next_byte = 0;
+	// the next bits to read, left aligned (most significant bit first)
+	uint64_t m_bit_buffer = 0;
+	unsigned int m_buffered_bits = 0;
+	std::vector<unsigned char> m_storage;
+	SymbolRansDecoder * m_symbol_code_source = nullptr;
+	ByteSource m_source;
+	// bytes of the stream not pulled from the source yet
+	unsigned int m_source_bytes_left = 0;
+	std::vector<unsigned char> m_read_bytes;
 };
 
 void test_OutputBitStream();
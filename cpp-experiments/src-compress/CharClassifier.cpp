@@ -0,0 +1,181 @@
+#include "CharClassifier.h"
+
+#include <cassert>
+#include <cstring>
+
+// SSE2 is always there on x64, and on x86 when the compiler targets it (MSVC /arch:SSE2, the default)
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || (defined(__i386__) && defined(__SSE2__))
+#define CHAR_CLASSIFIER_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define TARGET_AVX2
+#else
+#include <cpuid.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+static CharClassMasks classify_block_scalar(const char * chars) {
+	CharClassMasks masks = {};
+	for (int i = 0; i < CharClassifier::BLOCK_SIZE; ++i) {
+		const char c = chars[i];
+		const uint32_t bit = 1u << i;
+		if (c >= 'a' && c <= 'z') {
+			masks.lower |= bit;
+		} else if (c >= 'A' && c <= 'Z') {
+			masks.upper |= bit;
+		} else if (c >= '0' && c <= '9') {
+			masks.digit |= bit;
+		} else if (c == '_') {
+			masks.underscore |= bit;
+		}
+	}
+	return masks;
+}
+
+#ifdef CHAR_CLASSIFIER_SIMD
+// Signed byte comparisons: the chars >= 0x80 are negative and never in a range.
+static uint32_t in_range_sse2(__m128i chars, char first, char last) {
+	const __m128i above = _mm_cmpgt_epi8(chars, _mm_set1_epi8(static_cast<char>(first - 1)));
+	const __m128i below = _mm_cmplt_epi8(chars, _mm_set1_epi8(static_cast<char>(last + 1)));
+	return static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(above, below)));
+}
+
+static CharClassMasks classify_block_sse2(const char * chars) {
+	CharClassMasks masks = {};
+	for (int half = 0; half < 2; ++half) {
+		const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(chars + 16 * half));
+		const int shift = 16 * half;
+		masks.lower |= in_range_sse2(block, 'a', 'z') << shift;
+		masks.upper |= in_range_sse2(block, 'A', 'Z') << shift;
+		masks.digit |= in_range_sse2(block, '0', '9') << shift;
+		masks.underscore |= static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('_')))) << shift;
+	}
+	return masks;
+}
+
+TARGET_AVX2 static uint32_t in_range_avx2(__m256i chars, char first, char last) {
+	const __m256i above = _mm256_cmpgt_epi8(chars, _mm256_set1_epi8(static_cast<char>(first - 1)));
+	const __m256i below = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(last + 1)), chars);
+	return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(above, below)));
+}
+
+TARGET_AVX2 static CharClassMasks classify_block_avx2(const char * chars) {
+	const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(chars));
+	CharClassMasks masks;
+	masks.lower = in_range_avx2(block, 'a', 'z');
+	masks.upper = in_range_avx2(block, 'A', 'Z');
+	masks.digit = in_range_avx2(block, '0', '9');
+	masks.underscore = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('_'))));
+	return masks;
+}
+
+static bool cpu_has_avx2() {
+	// CPUID leaf 1: ECX bit 27 (OSXSAVE), XCR0 bits 1-2 (SSE and AVX states saved by the OS),
+	// leaf 7, sub-leaf 0: EBX bit 5
+#if defined(_MSC_VER)
+	int regs[4];
+	__cpuid(regs, 0);
+	if (regs[0] < 7)
+		return false;
+	__cpuid(regs, 1);
+	if ((regs[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+		return false;
+	__cpuidex(regs, 7, 0);
+	return (regs[1] & (1 << 5)) != 0;
+#else
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || (ecx & (1 << 27)) == 0)
+		return false;
+	unsigned int xcr0_low, xcr0_high;
+	__asm__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+	if ((xcr0_low & 6) != 6)
+		return false;
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+		return false;
+	return (ebx & (1 << 5)) != 0;
+#endif
+}
+#endif
+
+typedef CharClassMasks (*ClassifyBlockFunction)(const char *);
+
+static ClassifyBlockFunction select_classify_block_function() {
+#ifdef CHAR_CLASSIFIER_SIMD
+	if (cpu_has_avx2())
+		return classify_block_avx2;
+	return classify_block_sse2;
+#else
+	return classify_block_scalar;
+#endif
+}
+
+static const ClassifyBlockFunction selected_classify_block_function = select_classify_block_function();
+
+// Blocks shorter than BLOCK_SIZE are copied to a zero padded buffer (0 belongs to no class).
+static CharClassMasks classify_with(ClassifyBlockFunction classify_block, const char * chars, int nb_chars) {
+	assert(nb_chars >= 0 && nb_chars <= CharClassifier::BLOCK_SIZE);
+	if (nb_chars == CharClassifier::BLOCK_SIZE)
+		return classify_block(chars);
+	char block[CharClassifier::BLOCK_SIZE] = {};
+	std::memcpy(block, chars, nb_chars);
+	return classify_block(block);
+}
+
+namespace CharClassifier {
+	CharClassMasks classify(const char * chars, int nb_chars) {
+		return classify_with(selected_classify_block_function, chars, nb_chars);
+	}
+
+	const char * implementationName() {
+		if (selected_classify_block_function == classify_block_scalar)
+			return "scalar";
+#ifdef CHAR_CLASSIFIER_SIMD
+		if (selected_classify_block_function == classify_block_avx2)
+			return "avx2";
+#endif
+		return "sse2";
+	}
+}
+
+// ----------------------------------------------------------------
+
+static void test_classify_block_function(ClassifyBlockFunction classify_block) {
+	char chars[CharClassifier::BLOCK_SIZE * 2];
+	unsigned int seed = 7;
+	for (int n = 0; n < 500; ++n) {
+		for (char & c : chars) {
+			seed = seed * 1103515245 + 12345;
+			c = static_cast<char>(seed >> 16);
+		}
+		for (int nb_chars = 0; nb_chars <= CharClassifier::BLOCK_SIZE; ++nb_chars) {
+			const CharClassMasks masks = classify_with(classify_block, chars + n % 8, nb_chars);
+			const CharClassMasks expected = classify_with(classify_block_scalar, chars + n % 8, nb_chars);
+			assert(masks.lower == expected.lower);
+			assert(masks.upper == expected.upper);
+			assert(masks.digit == expected.digit);
+			assert(masks.underscore == expected.underscore);
+		}
+	}
+
+	const char * text = "aZ_9 `{@[/:\x80\xFF" "abcdefghijklmnopqrs";
+	const CharClassMasks masks = classify_with(classify_block, text, 32);
+	assert(masks.lower == (1u | (0x7FFFFu << 13)));
+	assert(masks.upper == 2u);
+	assert(masks.underscore == 4u);
+	assert(masks.digit == 8u);
+}
+
+void test_CharClassifier() {
+	test_classify_block_function(classify_block_scalar);
+#ifdef CHAR_CLASSIFIER_SIMD
+	test_classify_block_function(classify_block_sse2);
+	if (cpu_has_avx2())
+		test_classify_block_function(classify_block_avx2);
+#endif
+
+	const CharClassMasks masks = CharClassifier::classify("x_1", 3);
+	assert(masks.lower == 1u && masks.underscore == 2u && masks.digit == 4u && masks.upper == 0u);
+	assert(count_trailing_zeros(1u) == 0);
+	assert(count_trailing_zeros(0x80000000u) == 31);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Classes of up to CharClassifier::BLOCK_SIZE consecutive chars, bit i standing for the i-th char.
+// ASCII only: the same results as std::islower/isupper/isdigit in the "C" locale.
+struct CharClassMasks {
+	uint32_t lower;
+	uint32_t upper;
+	uint32_t digit;
+	uint32_t underscore;
+};
+
+// Classification of symbol name chars 32 at a time, with AVX2 when the CPU supports it, SSE2
+// (always available on x64) or a portable implementation otherwise. The choice is made once at
+// runtime with CPUID.
+namespace CharClassifier {
+	static const int BLOCK_SIZE = 32;
+
+	// Classifies the nb_chars (at most BLOCK_SIZE) first chars: the bits past nb_chars are 0.
+	// Only the nb_chars first chars are read.
+	CharClassMasks classify(const char * chars, int nb_chars);
+
+	// Name of the implementation selected at runtime ("avx2", "sse2" or "scalar").
+	const char * implementationName();
+}
+
+// value must not be 0
+inline int count_trailing_zeros(uint32_t value) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctz(value);
+#endif
+}
+
+void test_CharClassifier();
@@ -0,0 +1,206 @@
+#include "CompressionStatistics.h"
+
+#include "Compressor.h"
+#include "string_view.h"
+
+#include <cassert>
+#include <sstream>
+
+static const char * const BLOCK_TYPE_NAMES[CompressionStatistics::NB_BLOCK_TYPES] = {
+	"NEW_SYMBOL_NAME_LOCAL_SCOPE", "NEW_SYMBOL_NAME_GLOBAL_SCOPE", "SYMBOL_NAME_REFERENCE_LOCAL", "SYMBOL_NAME_REFERENCE_GLOBAL",
+	"COMMENT_BLOCK", "SEPARATOR", "ENCODED_NUMBER", "STRING_BLOCK", "SPECIAL_CHAR_BLOCK", "UNDETERMINED_BLOCK",
+	"INDENT_BLOCK", "NEW_LINE", "KEYWORD", "SYMBOL_NAME_REFERENCE_SHARED", "BLOCK_TYPE_14", "BLOCK_TYPE_15",
+};
+
+static const char * const SYMBOL_CODE_NAMES[CompressionStatistics::NB_SYMBOL_CODES] = {
+	"LETTER_A", "LETTER_B", "LETTER_C", "LETTER_D", "LETTER_E", "LETTER_F", "LETTER_G", "LETTER_H", "LETTER_I",
+	"LETTER_J", "LETTER_K", "LETTER_L", "LETTER_M", "LETTER_N", "LETTER_O", "LETTER_P", "LETTER_Q", "LETTER_R",
+	"LETTER_S", "LETTER_T", "LETTER_U", "LETTER_V", "LETTER_W", "LETTER_X", "LETTER_Y", "LETTER_Z",
+	"UNDERSCORE", "CASE_INVERSE_ONCE", "CASE_INVERSE_PERMANENT", "DIGITS_2BITS", "DIGITS_6BITS", "DIGITS_10BITS",
+};
+
+static const char * const PHASE_NAMES[CompressionStatistics::NB_PHASES] = {
+	"symbol_code_counting", "blocks", "entropy_coding", "interleaved_names",
+};
+
+static const char * const CODING_NAMES[] = { "fixed", "huffman", "rans", "interleaved", "mixed" };
+static const unsigned int MIXED_CODINGS = 4;
+
+void CompressionStatistics::addStream(unsigned int coding, uint64_t source_length, uint64_t size_in_bits) {
+	assert(coding < MIXED_CODINGS);
+	m_coding = (m_nb_streams == 0 || m_coding == coding) ? coding : MIXED_CODINGS;
+	m_nb_streams += 1;
+	m_source_length += source_length;
+	m_size_in_bits += size_in_bits;
+}
+
+void CompressionStatistics::addBlock(BLOCK_TYPE type, uint64_t nb_bits, uint64_t nb_chars) {
+	Counts & counts = m_blocks[type];
+	counts.count += 1;
+	counts.bits += nb_bits;
+	counts.chars += nb_chars;
+}
+
+void CompressionStatistics::addSymbolCodes(const unsigned int (&frequencies)[NB_SYMBOL_CODES], const unsigned int (&code_lengths)[NB_SYMBOL_CODES]) {
+	for (unsigned int code = 0; code < NB_SYMBOL_CODES; ++code) {
+		m_symbol_codes[code].count += frequencies[code];
+		m_symbol_codes[code].bits += static_cast<uint64_t>(frequencies[code]) * code_lengths[code];
+	}
+}
+
+void CompressionStatistics::addEntropyCodedBits(uint64_t nb_bits) {
+	m_entropy_coded_bits += nb_bits;
+}
+
+void CompressionStatistics::addPhaseTime(PHASE phase, double seconds) {
+	m_phase_seconds[phase] += seconds;
+}
+
+CompressionStatistics::Counts CompressionStatistics::symbolNames() const {
+	Counts names;
+	for (BLOCK_TYPE type : { NEW_SYMBOL_NAME_LOCAL_SCOPE, NEW_SYMBOL_NAME_GLOBAL_SCOPE, SYMBOL_NAME_REFERENCE_LOCAL,
+		SYMBOL_NAME_REFERENCE_GLOBAL, SYMBOL_NAME_REFERENCE_SHARED, KEYWORD }) {
+		names.count += m_blocks[type].count;
+		names.bits += m_blocks[type].bits;
+		names.chars += m_blocks[type].chars;
+	}
+	return names;
+}
+
+const char * CompressionStatistics::blockTypeName(BLOCK_TYPE type) {
+	return BLOCK_TYPE_NAMES[type];
+}
+
+const char * CompressionStatistics::symbolCodeName(SYMBOL_NAME_CODES::ENUM code) {
+	return SYMBOL_CODE_NAMES[code];
+}
+
+const char * CompressionStatistics::phaseName(PHASE phase) {
+	return PHASE_NAMES[phase];
+}
+
+static double ratio(uint64_t numerator, uint64_t denominator) {
+	return (denominator == 0) ? 0 : static_cast<double>(numerator) / denominator;
+}
+
+static void write_counts(std::ostringstream & json, const CompressionStatistics::Counts & counts, bool with_chars) {
+	json << "{ \"count\": " << counts.count << ", \"bits\": " << counts.bits;
+	if (with_chars) {
+		json << ", \"chars\": " << counts.chars << ", \"bits_per_block\": " << ratio(counts.bits, counts.count)
+			<< ", \"bits_per_char\": " << ratio(counts.bits, counts.chars);
+	}
+	json << " }";
+}
+
+std::string CompressionStatistics::toJson() const {
+	std::ostringstream json;
+	json << "{\n"
+		<< "  \"coding\": \"" << CODING_NAMES[m_coding] << "\",\n"
+		<< "  \"streams\": " << m_nb_streams << ",\n"
+		<< "  \"source_bytes\": " << m_source_length << ",\n"
+		<< "  \"compressed_bits\": " << m_size_in_bits << ",\n"
+		<< "  \"bits_per_char\": " << ratio(m_size_in_bits, m_source_length) << ",\n"
+		<< "  \"entropy_coded_bits\": " << m_entropy_coded_bits << ",\n";
+
+	json << "  \"blocks\": {\n";
+	bool first = true;
+	for (unsigned int type = 0; type < NB_BLOCK_TYPES; ++type) {
+		if (m_blocks[type].count == 0)
+			continue;
+		json << (first ? "" : ",\n") << "    \"" << BLOCK_TYPE_NAMES[type] << "\": ";
+		write_counts(json, m_blocks[type], true);
+		first = false;
+	}
+	json << "\n  },\n";
+
+	const Counts names = symbolNames();
+	const uint64_t nb_new_names = m_blocks[NEW_SYMBOL_NAME_LOCAL_SCOPE].count + m_blocks[NEW_SYMBOL_NAME_GLOBAL_SCOPE].count;
+	json << "  \"symbol_names\": { \"count\": " << names.count << ", \"bits\": " << names.bits << ", \"chars\": " << names.chars
+		<< ", \"bits_per_name\": " << ratio(names.bits, names.count)
+		<< ", \"new_names\": " << nb_new_names
+		<< ", \"bits_per_new_name\": " << ratio(m_blocks[NEW_SYMBOL_NAME_LOCAL_SCOPE].bits + m_blocks[NEW_SYMBOL_NAME_GLOBAL_SCOPE].bits, nb_new_names)
+		<< " },\n";
+
+	json << "  \"symbol_codes\": {\n";
+	for (unsigned int code = 0; code < NB_SYMBOL_CODES; ++code) {
+		json << "    \"" << SYMBOL_CODE_NAMES[code] << "\": ";
+		write_counts(json, m_symbol_codes[code], false);
+		json << (code + 1 < NB_SYMBOL_CODES ? ",\n" : "\n");
+	}
+	json << "  },\n";
+
+	const uint64_t nb_case_inversions = m_symbol_codes[SYMBOL_NAME_CODES::CASE_INVERSE_ONCE].count +
+		m_symbol_codes[SYMBOL_NAME_CODES::CASE_INVERSE_PERMANENT].count;
+	json << "  \"case_inversions\": { \"count\": " << nb_case_inversions
+		<< ", \"bits\": " << m_symbol_codes[SYMBOL_NAME_CODES::CASE_INVERSE_ONCE].bits + m_symbol_codes[SYMBOL_NAME_CODES::CASE_INVERSE_PERMANENT].bits
+		<< ", \"per_new_name\": " << ratio(nb_case_inversions, nb_new_names) << " },\n";
+	json << "  \"numbers\": { \"DIGITS_2BITS\": " << m_symbol_codes[SYMBOL_NAME_CODES::DIGITS_2BITS].count
+		<< ", \"DIGITS_6BITS\": " << m_symbol_codes[SYMBOL_NAME_CODES::DIGITS_6BITS].count
+		<< ", \"DIGITS_10BITS\": " << m_symbol_codes[SYMBOL_NAME_CODES::DIGITS_10BITS].count << " },\n";
+
+	json << "  \"phases_ms\": {";
+	for (unsigned int phase = 0; phase < NB_PHASES; ++phase) {
+		json << (phase == 0 ? " " : ", ") << "\"" << PHASE_NAMES[phase] << "\": " << m_phase_seconds[phase] * 1000;
+	}
+	json << " }\n}";
+	return json.str();
+}
+
+// ----------------------------------------------------------------
+
+void test_CompressionStatistics() {
+	const std::string source = "class AClass {\n\tint m_value = 0x1F;\n\tint getValue() const { return m_value; }\n};\n"
+		"// comment\nint MAX_SIZE_2 = 1092;\n\nAClass anInstance;\n";
+	const string_view source_view(source.data(), static_cast<int>(source.size()));
+	for (auto coding : { Compressor::SYMBOL_CODING_FIXED, Compressor::SYMBOL_CODING_HUFFMAN, Compressor::SYMBOL_CODING_RANS,
+		Compressor::SYMBOL_CODING_INTERLEAVED }) {
+		// the same stream with or without statistics
+		CompressionStatistics encoding;
+		const PackedBits bits = Compressor::compress(source_view, coding, nullptr, encoding);
+		const PackedBits plain_bits = Compressor::compress(source_view, coding);
+		assert(bits.sizeInBits == plain_bits.sizeInBits && bits.data == plain_bits.data);
+
+		assert(encoding.nbStreams() == 1);
+		// class, int, int, const, return, int
+		assert(encoding.block(KEYWORD).count == 6);
+		// AClass, m_value, getValue, MAX_SIZE_2, anInstance
+		assert(encoding.block(NEW_SYMBOL_NAME_LOCAL_SCOPE).count + encoding.block(NEW_SYMBOL_NAME_GLOBAL_SCOPE).count == 5);
+		assert(encoding.block(SYMBOL_NAME_REFERENCE_LOCAL).count + encoding.block(SYMBOL_NAME_REFERENCE_GLOBAL).count == 2);
+		assert(encoding.block(COMMENT_BLOCK).chars == std::string("// comment").size());
+		assert(encoding.symbolNames().count == 13);
+		// every character of the source belongs to a block
+		uint64_t nb_chars = 0;
+		uint64_t nb_block_bits = 0;
+		for (unsigned int type = 0; type < CompressionStatistics::NB_BLOCK_TYPES; ++type) {
+			nb_chars += encoding.block(static_cast<BLOCK_TYPE>(type)).chars;
+			nb_block_bits += encoding.block(static_cast<BLOCK_TYPE>(type)).bits;
+		}
+		assert(nb_chars == source.size());
+		assert(nb_block_bits < bits.sizeInBits);
+
+		// only the new symbol names and the numbers are made of symbol codes
+		assert(encoding.symbolCode(SYMBOL_NAME_CODES::CASE_INVERSE_ONCE).count == 3);
+		// each stream of interleaved names has its own case state
+		assert(encoding.symbolCode(SYMBOL_NAME_CODES::CASE_INVERSE_PERMANENT).count == (coding == Compressor::SYMBOL_CODING_INTERLEAVED ? 3u : 4u));
+		assert(encoding.symbolCode(SYMBOL_NAME_CODES::DIGITS_2BITS).count == 4);
+		assert(encoding.symbolCode(SYMBOL_NAME_CODES::DIGITS_10BITS).count == 1);
+		assert((encoding.symbolCode(SYMBOL_NAME_CODES::LETTER_A).bits == 0) == (coding == Compressor::SYMBOL_CODING_RANS));
+
+		CompressionStatistics decoding;
+		InputBitStream stream(bits.data.data(), bits.sizeInBits);
+		assert(Compressor::decompress(stream, nullptr, decoding) == source);
+		for (unsigned int type = 0; type < CompressionStatistics::NB_BLOCK_TYPES; ++type) {
+			assert(decoding.block(static_cast<BLOCK_TYPE>(type)).count == encoding.block(static_cast<BLOCK_TYPE>(type)).count);
+			// the decoder doesn't see the bits of the interleaved names
+			const bool interleaved_name = coding == Compressor::SYMBOL_CODING_INTERLEAVED &&
+				(type == NEW_SYMBOL_NAME_LOCAL_SCOPE || type == NEW_SYMBOL_NAME_GLOBAL_SCOPE);
+			assert(interleaved_name || decoding.block(static_cast<BLOCK_TYPE>(type)).bits == encoding.block(static_cast<BLOCK_TYPE>(type)).bits);
+			assert(decoding.block(static_cast<BLOCK_TYPE>(type)).chars == encoding.block(static_cast<BLOCK_TYPE>(type)).chars);
+		}
+
+		const std::string json = encoding.toJson();
+		assert(json.find("\"KEYWORD\": { \"count\": 6,") != std::string::npos);
+		assert(json.find("\"DIGITS_10BITS\": 1 }") != std::string::npos);
+		assert(json.find("\"phases_ms\"") != std::string::npos);
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "EncodingTables.h"
+#include "SymbolHuffmanCode.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Where Compressor::compress() and decompress() spend their bits and their time: blocks by type,
+// symbol codes by value (encoder only) and time by phase. The instrumentation is a template policy
+// of their implementation: the default entry points use NoStatistics, which compiles to nothing,
+// the overloads taking a CompressionStatistics record into it. Counts add up over the streams.
+class CompressionStatistics {
+public:
+	enum PHASE {
+		PHASE_SYMBOL_CODE_COUNTING, // first pass over the blocks, for the Huffman code
+		PHASE_BLOCKS,               // tokenizing and encoding the blocks, or decoding them
+		PHASE_ENTROPY_CODING,       // building and writing the Huffman code or the rANS model and data, or reading them
+		PHASE_INTERLEAVED_NAMES,    // writing or decoding the streams of names of SYMBOL_CODING_INTERLEAVED
+		NB_PHASES
+	};
+	static const unsigned int NB_BLOCK_TYPES = 1 << BLOCK_TYPE_BIT_WIDTH;
+	static const unsigned int NB_SYMBOL_CODES = SymbolHuffmanCode::NB_SYMBOLS;
+	// the streams count their symbol codes for addSymbolCodes()
+	static const bool COUNTS_SYMBOL_CODES = true;
+
+	struct Counts {
+		uint64_t count = 0;
+		uint64_t bits = 0;
+		// source characters, blocks only
+		uint64_t chars = 0;
+	};
+
+	// Adds the time from construction to stop() or destruction to a phase.
+	class PhaseTimer {
+	public:
+		PhaseTimer(CompressionStatistics & statistics, PHASE phase) :
+			m_statistics(statistics), m_phase(phase), m_start(std::chrono::steady_clock::now()) {
+		}
+		~PhaseTimer() {
+			stop();
+		}
+		PhaseTimer(const PhaseTimer &) = delete;
+		PhaseTimer & operator=(const PhaseTimer &) = delete;
+
+		void stop() {
+			if (!m_stopped) {
+				m_statistics.addPhaseTime(m_phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count());
+				m_stopped = true;
+			}
+		}
+
+	private:
+		CompressionStatistics & m_statistics;
+		PHASE m_phase;
+		std::chrono::steady_clock::time_point m_start;
+		bool m_stopped = false;
+	};
+
+	void addStream(unsigned int coding, uint64_t source_length, uint64_t size_in_bits);
+	// nb_bits: bits of the block, including its symbol codes when they are written apart
+	// (SYMBOL_CODING_INTERLEAVED names), excluding them when they are entropy coded together (rANS).
+	void addBlock(BLOCK_TYPE type, uint64_t nb_bits, uint64_t nb_chars);
+	// code_lengths: bits of each code, 0 when they are not known individually (rANS).
+	void addSymbolCodes(const unsigned int (&frequencies)[NB_SYMBOL_CODES], const unsigned int (&code_lengths)[NB_SYMBOL_CODES]);
+	// Symbol codes coded together, outside of the blocks (rANS data).
+	void addEntropyCodedBits(uint64_t nb_bits);
+	void addPhaseTime(PHASE phase, double seconds);
+
+	uint64_t nbStreams() const {
+		return m_nb_streams;
+	}
+	const Counts & block(BLOCK_TYPE type) const {
+		return m_blocks[type];
+	}
+	const Counts & symbolCode(SYMBOL_NAME_CODES::ENUM code) const {
+		return m_symbol_codes[code];
+	}
+	// Symbol names however they are written: keywords, references or new names.
+	Counts symbolNames() const;
+	double phaseSeconds(PHASE phase) const {
+		return m_phase_seconds[phase];
+	}
+
+	static const char * blockTypeName(BLOCK_TYPE type);
+	static const char * symbolCodeName(SYMBOL_NAME_CODES::ENUM code);
+	static const char * phaseName(PHASE phase);
+
+	// One JSON object: totals, blocks, symbol names, symbol codes (with the case inversions and
+	// the numbers summed up) and phases in milliseconds.
+	std::string toJson() const;
+
+private:
+	uint64_t m_nb_streams = 0;
+	unsigned int m_coding = 0;
+	uint64_t m_source_length = 0;
+	uint64_t m_size_in_bits = 0;
+	uint64_t m_entropy_coded_bits = 0;
+	Counts m_blocks[NB_BLOCK_TYPES];
+	Counts m_symbol_codes[NB_SYMBOL_CODES];
+	double m_phase_seconds[NB_PHASES] = {};
+};
+
+// The policy of the uninstrumented code: same interface, does nothing.
+struct NoStatistics {
+	static const bool COUNTS_SYMBOL_CODES = false;
+
+	class PhaseTimer {
+	public:
+		PhaseTimer(NoStatistics &, CompressionStatistics::PHASE) {
+		}
+		void stop() {
+		}
+	};
+
+	void addStream(unsigned int, uint64_t, uint64_t) {
+	}
+	void addBlock(BLOCK_TYPE, uint64_t, uint64_t) {
+	}
+	void addSymbolCodes(const unsigned int (&)[CompressionStatistics::NB_SYMBOL_CODES], const unsigned int (&)[CompressionStatistics::NB_SYMBOL_CODES]) {
+	}
+	void addEntropyCodedBits(uint64_t) {
+	}
+};
+
+void test_CompressionStatistics();
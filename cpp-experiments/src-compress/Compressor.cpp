@@ -0,0 +1,763 @@
+#include "Compressor.h"
+
+#include "CompressionStatistics.h"
+#include "Tokenizer.h"
+#include "Encoder.h"
+#include "Decoder.h"
+#include "SymbolDictionary.h"
+#include "IndentModel.h"
+#include "Keywords.h"
+#include "SharedDictionary.h"
+#include "LittleEndian.h"
+#include "string_view.h"
+
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <memory>
+
+static const char FILE_MAGIC[4] = { 'S', 'R', 'C', 'Z' };
+static const size_t FILE_HEADER_SIZE = 12;
+
+// Keywords are written as such. Other symbol names are interned: the first occurrence is encoded,
+// the next ones are written as the id of the name in the dictionary of the current scope (while
+// inside curly braces) or the global one.
+// The local dictionary is emptied each time the scope depth goes back to 0.
+// The first occurrence of a name of the SharedDictionary is written as its id in the shared
+// dictionary instead, and the name is added to the global dictionary for the next ones.
+static bool is_new_symbol_name(BLOCK_TYPE type) {
+	return type == NEW_SYMBOL_NAME_LOCAL_SCOPE || type == NEW_SYMBOL_NAME_GLOBAL_SCOPE;
+}
+
+// New symbol names of a SYMBOL_CODING_INTERLEAVED stream, written apart from their blocks.
+struct InterleavedNames {
+	OutputBitStream streams[NB_INTERLEAVED_STREAMS];
+	unsigned int nb_names = 0;
+
+	unsigned int sizeInBits() const {
+		unsigned int size_in_bits = 0;
+		for (const OutputBitStream & stream : streams) {
+			size_in_bits += stream.sizeInBits();
+		}
+		return size_in_bits;
+	}
+};
+
+// Bits written so far for the blocks, including the new symbol names written apart.
+static unsigned int encoded_bits(const OutputBitStream & stream, const InterleavedNames * interleaved_names) {
+	return stream.sizeInBits() + ((interleaved_names != nullptr) ? interleaved_names->sizeInBits() : 0);
+}
+
+// Returns the type of the block written.
+static BLOCK_TYPE encode_symbol_name(OutputBitStream & stream, const Block & block, SymbolDictionary & global_symbols, SymbolDictionary & local_symbols,
+	const SharedDictionary * shared_symbols, InterleavedNames * interleaved_names) {
+	// hashed once for the keywords and all the dictionaries
+	const uint32_t hash = SymbolDictionary::hash(block.text);
+	const unsigned int keyword = Keywords::find(block.text, hash);
+	if (keyword != Keywords::NOT_FOUND) {
+		Encoder::encodeKeyword(stream, keyword);
+		return KEYWORD;
+	}
+	unsigned int id = local_symbols.find(block.text, hash);
+	if (id != SymbolDictionary::NOT_FOUND) {
+		Encoder::encodeSymbolReference(stream, SYMBOL_NAME_REFERENCE_LOCAL, id, local_symbols.size());
+		return SYMBOL_NAME_REFERENCE_LOCAL;
+	}
+	id = global_symbols.find(block.text, hash);
+	if (id != SymbolDictionary::NOT_FOUND) {
+		Encoder::encodeSymbolReference(stream, SYMBOL_NAME_REFERENCE_GLOBAL, id, global_symbols.size());
+		return SYMBOL_NAME_REFERENCE_GLOBAL;
+	}
+	if (shared_symbols != nullptr) {
+		id = shared_symbols->find(block.text, hash);
+		if (id != SharedDictionary::NOT_FOUND) {
+			Encoder::encodeSymbolReference(stream, SYMBOL_NAME_REFERENCE_SHARED, id, shared_symbols->size());
+			global_symbols.insert(block.text, hash);
+			return SYMBOL_NAME_REFERENCE_SHARED;
+		}
+	}
+	SymbolDictionary & dictionary = (block.type == NEW_SYMBOL_NAME_LOCAL_SCOPE) ? local_symbols : global_symbols;
+	dictionary.insert(block.text, hash);
+	if (interleaved_names != nullptr) {
+		stream.appendBits(block.type, BLOCK_TYPE_BIT_WIDTH);
+		Encoder::encodeInterleavedSymbolName(interleaved_names->streams, interleaved_names->nb_names++, block.text);
+		return block.type;
+	}
+	Encoder::encodeBlock(stream, block);
+	return block.type;
+}
+
+// Line ends are held back until the next block that is not a line end, to be written with the
+// empty lines that follow them and the indentation of the next line (see IndentModel).
+struct PendingNewLines {
+	bool active = false;
+	bool crlf = false;
+	unsigned int nb_empty_lines = 0;
+};
+
+template<typename Statistics>
+static void encode_new_lines(OutputBitStream & stream, IndentModel & indents, PendingNewLines & pending, string_view next_indent,
+	Statistics & statistics) {
+	const unsigned int start_bit = stream.sizeInBits();
+	stream.appendBits(NEW_LINE, BLOCK_TYPE_BIT_WIDTH);
+	indents.encodeNewLines(stream, pending.crlf, pending.nb_empty_lines, next_indent);
+	statistics.addBlock(NEW_LINE, stream.sizeInBits() - start_bit,
+		(pending.nb_empty_lines + 1) * (pending.crlf ? 2 : 1) + next_indent.length());
+	pending = PendingNewLines();
+}
+
+// With symbol_codes_only, only the blocks made of SYMBOL_NAME_CODES are written (to count them).
+// With interleaved_names, the new symbol names are written there instead of in their blocks.
+template<typename Statistics>
+static void encode_blocks(OutputBitStream & stream, string_view source, bool symbol_codes_only, const SharedDictionary * shared_symbols,
+	InterleavedNames * interleaved_names, Statistics & statistics) {
+	SymbolDictionary global_symbols;
+	SymbolDictionary local_symbols;
+	IndentModel indents;
+	PendingNewLines new_lines;
+	Tokenizer tokenizer(source);
+	Block block;
+	while (tokenizer.getNextBlock(block)) {
+		if (symbol_codes_only && (block.type == NEW_LINE || block.type == INDENT_BLOCK))
+			continue;
+		if (block.type == NEW_LINE) {
+			const bool crlf = (block.text.length() == 2);
+			if (new_lines.active && new_lines.crlf == crlf) {
+				new_lines.nb_empty_lines += 1;
+				continue;
+			}
+			if (new_lines.active) {
+				encode_new_lines(stream, indents, new_lines, string_view(), statistics);
+			}
+			new_lines.active = true;
+			new_lines.crlf = crlf;
+			continue;
+		}
+		if (new_lines.active) {
+			if (block.type == INDENT_BLOCK) {
+				encode_new_lines(stream, indents, new_lines, block.text, statistics);
+				continue;
+			}
+			encode_new_lines(stream, indents, new_lines, string_view(), statistics);
+		} else if (block.type == INDENT_BLOCK) {
+			// first line
+			indents.setIndent(block.text);
+		}
+
+		const unsigned int start_bit = encoded_bits(stream, interleaved_names);
+		BLOCK_TYPE encoded_type = block.type;
+		if (is_new_symbol_name(block.type)) {
+			encoded_type = encode_symbol_name(stream, block, global_symbols, local_symbols, shared_symbols, interleaved_names);
+		} else {
+			if (!symbol_codes_only || block.type == ENCODED_NUMBER) {
+				Encoder::encodeBlock(stream, block);
+			}
+			if (block.type == SPECIAL_CHAR_BLOCK && tokenizer.scopeDepth() == 0) {
+				local_symbols.clear();
+			}
+		}
+		statistics.addBlock(encoded_type, encoded_bits(stream, interleaved_names) - start_bit, block.text.length());
+	}
+	if (new_lines.active) {
+		encode_new_lines(stream, indents, new_lines, string_view(), statistics);
+	}
+}
+
+static const unsigned int SYMBOL_CODING_BIT_WIDTH = 2;
+
+// Reads the header of a stream (see Compressor::compress()) and sets its symbol coding on the
+// stream until destruction: the stream must not keep a pointer to the Huffman code or rANS decoder.
+class StreamHeader {
+public:
+	StreamHeader(InputBitStream & stream, const SharedDictionary * dictionary) : m_stream(stream) {
+		if (stream.readBits(8) != Compressor::FORMAT_VERSION)
+			throw make_logic_error("Unsupported format version!");
+
+		m_coding = static_cast<Compressor::SYMBOL_CODING>(stream.readBits(SYMBOL_CODING_BIT_WIDTH));
+		if (stream.readBits(1) != 0) {
+			if (dictionary == nullptr)
+				throw make_logic_error("The stream requires a shared dictionary!");
+			m_shared_symbols = dictionary;
+		}
+		if (m_coding == Compressor::SYMBOL_CODING_HUFFMAN) {
+			m_huffman.reset(new SymbolHuffmanCode(SymbolHuffmanCode::read(stream)));
+			stream.setSymbolHuffmanCode(m_huffman.get());
+		} else if (m_coding == Compressor::SYMBOL_CODING_RANS) {
+			m_rans_model.reset(new SymbolRansModel(SymbolRansModel::read(stream)));
+			const unsigned int nb_codes = stream.readVarUInt();
+			const unsigned int nb_bytes = stream.readVarUInt();
+			stream.alignToByte();
+			const unsigned char * rans_data = stream.readBytes(nb_bytes);
+			if (stream.pullsFromSource()) {
+				// the bytes are only valid until the next read
+				m_rans_data.assign(rans_data, rans_data + nb_bytes);
+				rans_data = m_rans_data.data();
+			}
+			m_rans_decoder.reset(new SymbolRansDecoder(*m_rans_model, rans_data, nb_bytes, nb_codes));
+			stream.setSymbolCodeSource(m_rans_decoder.get());
+		} else if (m_coding == Compressor::SYMBOL_CODING_INTERLEAVED) {
+			unsigned int sizes_in_bits[NB_INTERLEAVED_STREAMS];
+			for (unsigned int & size_in_bits : sizes_in_bits) {
+				size_in_bits = stream.readVarUInt();
+			}
+			stream.alignToByte();
+			for (unsigned int size_in_bits : sizes_in_bits) {
+				const unsigned char * bytes = stream.readBytes((size_in_bits + 7) / 8);
+				if (stream.pullsFromSource()) {
+					// the bytes are only valid until the next read
+					PackedBits bits;
+					bits.data.assign(bytes, bytes + (size_in_bits + 7) / 8);
+					bits.sizeInBits = size_in_bits;
+					m_name_streams.push_back(InputBitStream(std::move(bits)));
+				} else {
+					m_name_streams.push_back(InputBitStream(bytes, size_in_bits));
+				}
+			}
+		} else if (m_coding != Compressor::SYMBOL_CODING_FIXED) {
+			throw make_logic_error("Unsupported symbol coding!");
+		}
+	}
+
+	~StreamHeader() {
+		m_stream.setSymbolHuffmanCode(nullptr);
+		m_stream.setSymbolCodeSource(nullptr);
+	}
+
+	StreamHeader(const StreamHeader &) = delete;
+	StreamHeader & operator=(const StreamHeader &) = delete;
+
+	Compressor::SYMBOL_CODING coding() const {
+		return m_coding;
+	}
+
+	// null if the stream doesn't use a shared dictionary
+	const SharedDictionary * sharedSymbols() const {
+		return m_shared_symbols;
+	}
+
+	// SYMBOL_CODING_INTERLEAVED: stream of the index-th new symbol name.
+	InputBitStream & nameStream(unsigned int index) {
+		assert(m_coding == Compressor::SYMBOL_CODING_INTERLEAVED);
+		return m_name_streams[index % NB_INTERLEAVED_STREAMS];
+	}
+
+private:
+	InputBitStream & m_stream;
+	Compressor::SYMBOL_CODING m_coding;
+	const SharedDictionary * m_shared_symbols = nullptr;
+	std::unique_ptr<SymbolHuffmanCode> m_huffman;
+	std::unique_ptr<SymbolRansModel> m_rans_model;
+	std::unique_ptr<SymbolRansDecoder> m_rans_decoder;
+	std::vector<unsigned char> m_rans_data;
+	std::vector<InputBitStream> m_name_streams;
+};
+
+// Encodes the name as the payload of a NEW_SYMBOL_NAME_* block (after its length) from each case
+// state, indexed by BitStream::CASE_KIND, with the Huffman code of the stream if any. A symbol code
+// without Huffman code leaves the bits of that case state empty: the name can't start from it.
+// Returns false if the name can't be in the stream at all.
+static bool encode_searched_name(string_view name, const SymbolHuffmanCode * huffman, PackedBits (&encoded)[2]) {
+	if (name.empty() || (name[0] >= '0' && name[0] <= '9'))
+		return false;
+	for (int letter_case = BitStream::CASE_LOWER; letter_case <= BitStream::CASE_UPPER; ++letter_case) {
+		encoded[letter_case] = PackedBits();
+		// the case inversions written depend on the case state
+		OutputBitStream codes;
+		codes.countSymbolCodes(true);
+		if (letter_case == BitStream::CASE_UPPER) {
+			codes.invertCurrentCase();
+		}
+		string_view str = name;
+		Encoder::encodeNextSymbolName(codes, str);
+		if (!str.empty())
+			return false;
+		bool has_codes = true;
+		for (unsigned int code = 0; huffman != nullptr && code < SymbolHuffmanCode::NB_SYMBOLS; ++code) {
+			if (codes.symbolCodeFrequencies()[code] != 0 && huffman->codeLength(code) == 0) {
+				has_codes = false;
+			}
+		}
+		if (has_codes) {
+			OutputBitStream stream;
+			stream.setSymbolHuffmanCode(huffman);
+			if (letter_case == BitStream::CASE_UPPER) {
+				stream.invertCurrentCase();
+			}
+			str = name;
+			Encoder::encodeNextSymbolName(stream, str);
+			encoded[letter_case] = stream.release();
+		}
+	}
+	return encoded[BitStream::CASE_LOWER].sizeInBits != 0 || encoded[BitStream::CASE_UPPER].sizeInBits != 0;
+}
+
+// Do the next bits of the stream start with bits? Compared in place, the stream doesn't move.
+static bool starts_with_bits(const InputBitStream & stream, const PackedBits & bits) {
+	if (bits.sizeInBits > stream.remainingBits())
+		return false;
+	InputBitStream actual(stream.data(), stream.currentBit() + bits.sizeInBits);
+	actual.skipBits(stream.currentBit());
+	InputBitStream expected(bits.data.data(), bits.sizeInBits);
+	while (!expected.isEmpty()) {
+		const unsigned int nb_bits = std::min(32u, expected.remainingBits());
+		if (actual.readBits(nb_bits) != expected.readBits(nb_bits))
+			return false;
+	}
+	return true;
+}
+
+// The symbol codes written to the stream, with the bit length of each code: the one of the Huffman
+// code of the stream if any, fixed_code_length otherwise.
+static void add_symbol_codes(NoStatistics &, const OutputBitStream &, unsigned int) {
+}
+
+static void add_symbol_codes(CompressionStatistics & statistics, const OutputBitStream & stream, unsigned int fixed_code_length) {
+	const SymbolHuffmanCode * huffman = stream.symbolHuffmanCode();
+	unsigned int code_lengths[CompressionStatistics::NB_SYMBOL_CODES];
+	for (unsigned int code = 0; code < CompressionStatistics::NB_SYMBOL_CODES; ++code) {
+		code_lengths[code] = (huffman != nullptr) ? huffman->codeLength(code) : fixed_code_length;
+	}
+	statistics.addSymbolCodes(stream.symbolCodeFrequencies(), code_lengths);
+}
+
+// Adds the bits read and the characters decoded from construction to destruction to the block type.
+template<typename Statistics>
+class DecodedBlock {
+public:
+	DecodedBlock(Statistics & statistics, const InputBitStream & stream, const std::string & source) :
+		m_statistics(statistics), m_stream(stream), m_source(source), m_start_bit(stream.currentBit()), m_start_length(source.length()) {
+	}
+	~DecodedBlock() {
+		m_statistics.addBlock(m_type, m_stream.currentBit() - m_start_bit, m_source.length() - m_start_length);
+	}
+	DecodedBlock(const DecodedBlock &) = delete;
+	DecodedBlock & operator=(const DecodedBlock &) = delete;
+
+	void setType(BLOCK_TYPE type) {
+		m_type = type;
+	}
+
+private:
+	Statistics & m_statistics;
+	const InputBitStream & m_stream;
+	const std::string & m_source;
+	unsigned int m_start_bit;
+	size_t m_start_length;
+	BLOCK_TYPE m_type = UNDETERMINED_BLOCK;
+};
+
+template<>
+class DecodedBlock<NoStatistics> {
+public:
+	DecodedBlock(NoStatistics &, const InputBitStream &, const std::string &) {
+	}
+	void setType(BLOCK_TYPE) {
+	}
+};
+
+namespace Compressor {
+	template<typename Statistics>
+	static PackedBits compress_impl(string_view source, SYMBOL_CODING coding, const SharedDictionary * dictionary, Statistics & statistics) {
+		typedef CompressionStatistics::PHASE PHASE;
+		OutputBitStream stream;
+		// source code is typically compressed to less than half of its size
+		stream.reserve(source.length() * 4);
+		stream.appendBits(FORMAT_VERSION, 8);
+		stream.appendBits(coding, SYMBOL_CODING_BIT_WIDTH);
+		stream.appendBits(dictionary != nullptr ? 1 : 0, 1);
+		stream.countSymbolCodes(Statistics::COUNTS_SYMBOL_CODES);
+
+		if (coding == SYMBOL_CODING_HUFFMAN) {
+			// a first pass gives the frequencies of the symbol codes
+			typename Statistics::PhaseTimer counting_timer(statistics, PHASE::PHASE_SYMBOL_CODE_COUNTING);
+			OutputBitStream counting_stream;
+			counting_stream.countSymbolCodes(true);
+			NoStatistics no_statistics;
+			encode_blocks(counting_stream, source, true, dictionary, nullptr, no_statistics);
+			counting_timer.stop();
+
+			typename Statistics::PhaseTimer huffman_timer(statistics, PHASE::PHASE_ENTROPY_CODING);
+			const SymbolHuffmanCode huffman = SymbolHuffmanCode::fromFrequencies(counting_stream.symbolCodeFrequencies());
+			huffman.write(stream);
+			stream.setSymbolHuffmanCode(&huffman);
+			huffman_timer.stop();
+
+			typename Statistics::PhaseTimer blocks_timer(statistics, PHASE::PHASE_BLOCKS);
+			encode_blocks(stream, source, false, dictionary, nullptr, statistics);
+			blocks_timer.stop();
+			add_symbol_codes(statistics, stream, 0);
+		} else if (coding == SYMBOL_CODING_RANS) {
+			// the blocks are encoded first, without their symbol codes, which are then written in
+			// front of them: model, number of codes, byte length of the rANS data, rANS data (byte aligned)
+			OutputBitStream blocks;
+			blocks.reserve(source.length() * 4);
+			std::vector<unsigned char> symbol_codes;
+			symbol_codes.reserve(source.length());
+			blocks.deferSymbolCodes(&symbol_codes);
+			// for the model
+			blocks.countSymbolCodes(true);
+			typename Statistics::PhaseTimer blocks_timer(statistics, PHASE::PHASE_BLOCKS);
+			encode_blocks(blocks, source, false, dictionary, nullptr, statistics);
+			blocks_timer.stop();
+			add_symbol_codes(statistics, blocks, 0);
+
+			typename Statistics::PhaseTimer rans_timer(statistics, PHASE::PHASE_ENTROPY_CODING);
+			const SymbolRansModel model = SymbolRansModel::fromCounts(blocks.symbolCodeFrequencies());
+			const std::vector<unsigned char> rans_data = SymbolRans::encode(model, symbol_codes);
+			model.write(stream);
+			stream.appendVarUInt(static_cast<unsigned int>(symbol_codes.size()));
+			stream.appendVarUInt(static_cast<unsigned int>(rans_data.size()));
+			stream.alignToByte();
+			stream.appendBytes(rans_data.data(), rans_data.size());
+			rans_timer.stop();
+			statistics.addEntropyCodedBits(rans_data.size() * 8);
+			stream.appendPackedBits(blocks.release());
+		} else if (coding == SYMBOL_CODING_INTERLEAVED) {
+			// the new symbol names are written in front of the blocks: bit length of each stream of
+			// names, then each stream of names (byte aligned)
+			OutputBitStream blocks;
+			blocks.reserve(source.length() * 4);
+			InterleavedNames names;
+			blocks.countSymbolCodes(Statistics::COUNTS_SYMBOL_CODES);
+			for (OutputBitStream & names_stream : names.streams) {
+				names_stream.countSymbolCodes(Statistics::COUNTS_SYMBOL_CODES);
+			}
+			typename Statistics::PhaseTimer blocks_timer(statistics, PHASE::PHASE_BLOCKS);
+			encode_blocks(blocks, source, false, dictionary, &names, statistics);
+			blocks_timer.stop();
+			add_symbol_codes(statistics, blocks, SYMBOL_NAME_CODES::BIT_WIDTH);
+
+			typename Statistics::PhaseTimer names_timer(statistics, PHASE::PHASE_INTERLEAVED_NAMES);
+			for (const OutputBitStream & names_stream : names.streams) {
+				add_symbol_codes(statistics, names_stream, SYMBOL_NAME_CODES::BIT_WIDTH);
+				stream.appendVarUInt(static_cast<unsigned int>(names_stream.sizeInBits()));
+			}
+			stream.alignToByte();
+			for (OutputBitStream & names_stream : names.streams) {
+				stream.appendPackedBits(names_stream.release());
+				stream.alignToByte();
+			}
+			names_timer.stop();
+			stream.appendPackedBits(blocks.release());
+		} else {
+			typename Statistics::PhaseTimer blocks_timer(statistics, PHASE::PHASE_BLOCKS);
+			encode_blocks(stream, source, false, dictionary, nullptr, statistics);
+			blocks_timer.stop();
+			add_symbol_codes(statistics, stream, SYMBOL_NAME_CODES::BIT_WIDTH);
+		}
+		statistics.addStream(coding, source.length(), stream.sizeInBits());
+		return stream.release();
+	}
+
+	template<typename Statistics>
+	static std::string decompress_impl(InputBitStream & stream, const SharedDictionary * dictionary, Statistics & statistics) {
+		typedef CompressionStatistics::PHASE PHASE;
+		typename Statistics::PhaseTimer header_timer(statistics, PHASE::PHASE_ENTROPY_CODING);
+		StreamHeader header(stream, dictionary);
+		header_timer.stop();
+		const SharedDictionary * shared_symbols = header.sharedSymbols();
+
+		// all the new symbol names are decoded first, the streams of names advancing together
+		SymbolTable interleaved_names[NB_INTERLEAVED_STREAMS];
+		unsigned int nb_new_names = 0;
+		if (header.coding() == SYMBOL_CODING_INTERLEAVED) {
+			typename Statistics::PhaseTimer names_timer(statistics, PHASE::PHASE_INTERLEAVED_NAMES);
+			InputBitStream * name_streams[NB_INTERLEAVED_STREAMS];
+			for (unsigned int i = 0; i < NB_INTERLEAVED_STREAMS; ++i) {
+				name_streams[i] = &header.nameStream(i);
+			}
+			Decoder::decodeInterleavedSymbolNames(name_streams, interleaved_names);
+		}
+
+		std::string source;
+		SymbolTable global_symbols;
+		SymbolTable local_symbols;
+		IndentModel indents;
+		int scope_depth = 0;
+		typename Statistics::PhaseTimer blocks_timer(statistics, PHASE::PHASE_BLOCKS);
+		while (!stream.isEmpty()) {
+			DecodedBlock<Statistics> decoded_block(statistics, stream, source);
+			const BLOCK_TYPE type = Decoder::decodeBlockType(stream);
+			decoded_block.setType(type);
+			if (type == NEW_LINE) {
+				indents.decodeNewLines(stream, source);
+				continue;
+			}
+			if (type == SYMBOL_NAME_REFERENCE_LOCAL || type == SYMBOL_NAME_REFERENCE_GLOBAL) {
+				const SymbolTable & table = (type == SYMBOL_NAME_REFERENCE_LOCAL) ? local_symbols : global_symbols;
+				const string_view name = table.name(Decoder::decodeSymbolReference(stream, table.size()));
+				source.append(name.data(), name.length());
+				continue;
+			}
+			if (type == SYMBOL_NAME_REFERENCE_SHARED) {
+				if (shared_symbols == nullptr)
+					throw make_logic_error("Unexpected shared symbol reference!");
+				const string_view name = shared_symbols->name(Decoder::decodeSymbolReference(stream, shared_symbols->size()));
+				source.append(name.data(), name.length());
+				global_symbols.add(name.data(), name.length());
+				continue;
+			}
+			if (is_new_symbol_name(type) && header.coding() == SYMBOL_CODING_INTERLEAVED) {
+				const SymbolTable & names = interleaved_names[nb_new_names % NB_INTERLEAVED_STREAMS];
+				if (nb_new_names / NB_INTERLEAVED_STREAMS >= names.size())
+					throw make_logic_error("Missing interleaved symbol name!");
+				const string_view name = names.name(nb_new_names / NB_INTERLEAVED_STREAMS);
+				nb_new_names += 1;
+				source.append(name.data(), name.length());
+				SymbolTable & table = (type == NEW_SYMBOL_NAME_LOCAL_SCOPE) ? local_symbols : global_symbols;
+				table.add(name.data(), name.length());
+				continue;
+			}
+
+			const size_t block_start = source.length();
+			Decoder::decodeBlockPayload(stream, type, source);
+			const char * text = source.data() + block_start;
+			const int text_length = static_cast<int>(source.length() - block_start);
+			if (is_new_symbol_name(type)) {
+				SymbolTable & table = (type == NEW_SYMBOL_NAME_LOCAL_SCOPE) ? local_symbols : global_symbols;
+				table.add(text, text_length);
+			} else if (type == SPECIAL_CHAR_BLOCK) {
+				scope_depth = Tokenizer::nextScopeDepth(scope_depth, string_view(text, text_length));
+				if (scope_depth == 0) {
+					local_symbols.clear();
+				}
+			} else if (type == INDENT_BLOCK) {
+				indents.setIndent(string_view(text, text_length));
+			}
+		}
+		blocks_timer.stop();
+		statistics.addStream(header.coding(), source.length(), stream.currentBit());
+		return source;
+	}
+
+	bool hasFormat(InputBitStream & stream, SYMBOL_CODING coding) {
+		return stream.remainingBits() >= 8 + SYMBOL_CODING_BIT_WIDTH && stream.readBits(8) == FORMAT_VERSION &&
+			stream.readBits(SYMBOL_CODING_BIT_WIDTH) == static_cast<unsigned int>(coding);
+	}
+
+	PackedBits compress(string_view source, SYMBOL_CODING coding, const SharedDictionary * dictionary) {
+		NoStatistics statistics;
+		return compress_impl(source, coding, dictionary, statistics);
+	}
+
+	PackedBits compress(string_view source, SYMBOL_CODING coding, const SharedDictionary * dictionary, CompressionStatistics & statistics) {
+		return compress_impl(source, coding, dictionary, statistics);
+	}
+
+	std::string decompress(InputBitStream & stream, const SharedDictionary * dictionary) {
+		NoStatistics statistics;
+		return decompress_impl(stream, dictionary, statistics);
+	}
+
+	std::string decompress(InputBitStream & stream, const SharedDictionary * dictionary, CompressionStatistics & statistics) {
+		return decompress_impl(stream, dictionary, statistics);
+	}
+
+	// Only the sizes of the symbol tables are tracked (for the bit width of the references), and the
+	// scope depth and the indentation: the other blocks are skipped without being decoded to text.
+	bool containsSymbolName(InputBitStream & stream, string_view name, const SharedDictionary * dictionary) {
+		if (stream.pullsFromSource())
+			throw make_logic_error("The stream must be in memory!");
+		StreamHeader header(stream, dictionary);
+		const SharedDictionary * shared_symbols = header.sharedSymbols();
+
+		// the first occurrence of the name is either a keyword, a shared reference or a new symbol name
+		const unsigned int keyword = Keywords::find(name);
+		const unsigned int shared_id = (keyword == Keywords::NOT_FOUND && shared_symbols != nullptr) ?
+			shared_symbols->find(name) : SharedDictionary::NOT_FOUND;
+		PackedBits encoded_name[2];
+		const bool may_be_new = keyword == Keywords::NOT_FOUND && shared_id == SharedDictionary::NOT_FOUND &&
+			encode_searched_name(name, stream.symbolHuffmanCode(), encoded_name);
+		if (keyword == Keywords::NOT_FOUND && shared_id == SharedDictionary::NOT_FOUND && !may_be_new)
+			return false;
+		// with rANS, the symbol codes are not in the blocks
+		const bool compare_bits = (header.coding() != SYMBOL_CODING_RANS);
+
+		std::string text;
+		unsigned int nb_new_names = 0;
+		unsigned int nb_global_symbols = 0;
+		unsigned int nb_local_symbols = 0;
+		IndentModel indents;
+		int scope_depth = 0;
+		while (!stream.isEmpty()) {
+			const BLOCK_TYPE type = Decoder::decodeBlockType(stream);
+			if (type == NEW_LINE) {
+				indents.decodeNewLines(stream, text);
+				text.clear();
+				continue;
+			}
+			if (type == KEYWORD) {
+				if (stream.readBits(Keywords::BIT_WIDTH) == keyword)
+					return true;
+				continue;
+			}
+			if (type == SYMBOL_NAME_REFERENCE_LOCAL || type == SYMBOL_NAME_REFERENCE_GLOBAL) {
+				Decoder::decodeSymbolReference(stream, (type == SYMBOL_NAME_REFERENCE_LOCAL) ? nb_local_symbols : nb_global_symbols);
+				continue;
+			}
+			if (type == SYMBOL_NAME_REFERENCE_SHARED) {
+				if (shared_symbols == nullptr)
+					throw make_logic_error("Unexpected shared symbol reference!");
+				if (Decoder::decodeSymbolReference(stream, shared_symbols->size()) == shared_id)
+					return true;
+				nb_global_symbols += 1;
+				continue;
+			}
+			if (is_new_symbol_name(type) || type == ENCODED_NUMBER) {
+				// the payload of new symbol names is in the streams of names if they are interleaved
+				InputBitStream & payload = (is_new_symbol_name(type) && header.coding() == SYMBOL_CODING_INTERLEAVED) ?
+					header.nameStream(nb_new_names++) : stream;
+				const unsigned int length = payload.readVarUInt() + 1;
+				bool candidate = is_new_symbol_name(type) && may_be_new && length == static_cast<unsigned int>(name.length());
+				if (candidate && compare_bits) {
+					const PackedBits & bits = encoded_name[payload.currentCase()];
+					candidate = bits.sizeInBits != 0 && starts_with_bits(payload, bits);
+				}
+				if (candidate) {
+					// a candidate, decoded to be verified
+					text.clear();
+					Decoder::decodeSymbolName(payload, length, text);
+					if (string_view(text.data(), static_cast<int>(text.length())) == name)
+						return true;
+				} else {
+					Decoder::skipSymbolName(payload, length);
+				}
+				if (type == NEW_SYMBOL_NAME_LOCAL_SCOPE) {
+					nb_local_symbols += 1;
+				} else if (type == NEW_SYMBOL_NAME_GLOBAL_SCOPE) {
+					nb_global_symbols += 1;
+				}
+				continue;
+			}
+
+			if (type != SPECIAL_CHAR_BLOCK && type != INDENT_BLOCK) {
+				Decoder::skipBlockPayload(stream, type);
+				continue;
+			}
+			text.clear();
+			Decoder::decodeBlockPayload(stream, type, text);
+			if (type == SPECIAL_CHAR_BLOCK) {
+				scope_depth = Tokenizer::nextScopeDepth(scope_depth, string_view(text.data(), static_cast<int>(text.length())));
+				if (scope_depth == 0) {
+					nb_local_symbols = 0;
+				}
+			} else if (type == INDENT_BLOCK) {
+				indents.setIndent(string_view(text.data(), static_cast<int>(text.length())));
+			}
+		}
+		return false;
+	}
+
+	std::string readFile(const std::string & path) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			throw std::runtime_error("Can't open " + path);
+		std::ostringstream content;
+		content << file.rdbuf();
+		return content.str();
+	}
+
+	void writeFile(const std::string & path, const char * data, size_t size) {
+		std::ofstream file(path, std::ios::binary);
+		file.write(data, size);
+		if (!file)
+			throw std::runtime_error("Can't write " + path);
+	}
+
+	void compressFile(const std::string & source_path, const std::string & compressed_path, const SharedDictionary * dictionary) {
+		const std::string source = readFile(source_path);
+		const PackedBits bits = compress(string_view(source.data(), static_cast<int>(source.length())), DEFAULT_SYMBOL_CODING, dictionary);
+
+		std::string content(FILE_MAGIC, sizeof(FILE_MAGIC));
+		append_little_endian(content, bits.sizeInBits, 4);
+		append_little_endian(content, (dictionary != nullptr) ? dictionary->id() : 0, 4);
+		assert(content.size() == FILE_HEADER_SIZE);
+		content.append(reinterpret_cast<const char *>(bits.data.data()), bits.data.size());
+		writeFile(compressed_path, content.data(), content.size());
+	}
+
+	void decompressFile(const std::string & compressed_path, const std::string & source_path, const SharedDictionary * dictionary) {
+		const std::string content = readFile(compressed_path);
+		if (content.size() < FILE_HEADER_SIZE || content.compare(0, 4, FILE_MAGIC, 4) != 0)
+			throw std::runtime_error(compressed_path + " is not a compressed source file");
+
+		const unsigned char * header = reinterpret_cast<const unsigned char *>(content.data());
+		const unsigned int size_in_bits = static_cast<unsigned int>(read_little_endian(header + 4, 4));
+		if ((content.size() - FILE_HEADER_SIZE) * 8 < size_in_bits)
+			throw std::runtime_error(compressed_path + " is truncated");
+		if (read_little_endian(header + 8, 4) != ((dictionary != nullptr) ? dictionary->id() : 0))
+			throw std::runtime_error(compressed_path + " was compressed with another shared dictionary");
+
+		InputBitStream stream(header + FILE_HEADER_SIZE, size_in_bits);
+		const std::string source = decompress(stream, dictionary);
+		writeFile(source_path, source.data(), source.size());
+	}
+}
+
+// ----------------------------------------------------------------
+
+static void test_compress_decompress(const std::string & source) {
+	for (auto coding : { Compressor::SYMBOL_CODING_FIXED, Compressor::SYMBOL_CODING_HUFFMAN, Compressor::SYMBOL_CODING_RANS,
+		Compressor::SYMBOL_CODING_INTERLEAVED }) {
+		PackedBits bits = Compressor::compress(string_view(source.data(), static_cast<int>(source.length())), coding);
+		InputBitStream stream(std::move(bits));
+		assert(Compressor::decompress(stream) == source);
+	}
+}
+
+void test_Compressor() {
+	test_compress_decompress("");
+	test_compress_decompress("x");
+	test_compress_decompress("#include <vector>\n\nint main() {\n\tstd::vector<int> v = { 1, 2, 3 };\n\treturn v[0];\n}\n");
+	test_compress_decompress("class AClass {\r\n    int m_value0 = 0x1F; // comment\r\n    /* block\r\n       comment */\r\n};\r\n");
+	test_compress_decompress("const char * s = \"escaped \\\" quote\\n\"; char c = '\\'';\n");
+	test_compress_decompress("unterminated \"string\n/* unterminated comment");
+	test_compress_decompress("non ascii: \xC3\xA9\xE2\x82\xAC, controls: \x01\x7F\r\r\n\t \t x\t=\t1;");
+	test_compress_decompress("  first line indented\n\n\n\tx;\r\n\r\n\n\r\n\t\t \n    \n        y;\n\n\n");
+	test_compress_decompress("\n\n\t\n\r\n\r\n");
+	test_compress_decompress("_1091673 uint64_t AClass_1024 ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz_0123456789");
+
+	test_compress_decompress("namespace ns {\nint value;\nint f(int value) {\n\tint local = value;\n\treturn local + value;\n}\n}\n"
+		"int local;\nint value2 = local;\n{ local value2 } { other local other }");
+
+	// repeated names are written as references
+	const std::string repeated = "int aVeryLongName(); int aVeryLongName(); { int aVeryLongName(); }";
+	const std::string distinct = "int aVeryLongName(); int bVeryLongName(); { int cVeryLongName(); }";
+	const PackedBits repeated_bits = Compressor::compress(string_view(repeated.data(), static_cast<int>(repeated.length())));
+	const PackedBits distinct_bits = Compressor::compress(string_view(distinct.data(), static_cast<int>(distinct.length())));
+	assert(repeated_bits.sizeInBits + 2 * 60 < distinct_bits.sizeInBits);
+
+	// the Huffman code pays off on identifier heavy sources
+	std::string identifiers;
+	for (int i = 0; i < 200; ++i) {
+		identifiers += "value_" + std::to_string(i) + " = get_element(index_" + std::to_string(i) + ");\n";
+	}
+	const string_view identifiers_view(identifiers.data(), static_cast<int>(identifiers.length()));
+	assert(Compressor::compress(identifiers_view, Compressor::SYMBOL_CODING_HUFFMAN).sizeInBits <
+		Compressor::compress(identifiers_view, Compressor::SYMBOL_CODING_FIXED).sizeInBits);
+	assert(Compressor::compress(identifiers_view, Compressor::SYMBOL_CODING_RANS).sizeInBits <
+		Compressor::compress(identifiers_view, Compressor::SYMBOL_CODING_FIXED).sizeInBits);
+
+	std::string all_bytes;
+	for (int i = 0; i < 256; ++i) {
+		all_bytes += static_cast<char>(i);
+		all_bytes += "a" + std::to_string(i) + " ";
+	}
+	test_compress_decompress(all_bytes);
+
+	// search in the compressed streams
+	const std::string searched = "// commentName\nclass AClass {\n\tint m_value;\n\tconst char * s = \"stringName\";\n};\n"
+		"{ int LOCAL_NAME = 1; }\n{ float LOCAL_NAME; }\nint AClass_1024 = 0x1F;\nuint64_t m_Value2;\n";
+	for (auto coding : { Compressor::SYMBOL_CODING_FIXED, Compressor::SYMBOL_CODING_HUFFMAN, Compressor::SYMBOL_CODING_RANS,
+		Compressor::SYMBOL_CODING_INTERLEAVED }) {
+		const PackedBits bits = Compressor::compress(string_view(searched.data(), static_cast<int>(searched.length())), coding);
+		for (const char * name : { "AClass", "m_value", "LOCAL_NAME", "AClass_1024", "uint64_t", "m_Value2", "class", "float" }) {
+			InputBitStream stream(bits.data.data(), bits.sizeInBits);
+			assert(Compressor::containsSymbolName(stream, name));
+		}
+		for (const char * name : { "commentName", "stringName", "aclass", "ACLASS", "AClas", "m_value2", "LOCAL", "x1F", "double", "1024", "", "a-b" }) {
+			InputBitStream stream(bits.data.data(), bits.sizeInBits);
+			assert(!Compressor::containsSymbolName(stream, name));
+		}
+	}
+}
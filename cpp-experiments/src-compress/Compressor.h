@@ -0,0 +1,60 @@
+#pragma once
+
+#include "BitStream.h"
+
+#include <string>
+
+class string_view;
+class SharedDictionary;
+class CompressionStatistics;
+
+// Whole source file compression: the source is split into blocks by the Tokenizer and each block
+// is encoded with Encoder::encodeBlock().
+namespace Compressor {
+	// Stored in the first 8 bits of the stream.
+	static const unsigned int FORMAT_VERSION = 7;
+
+	// How the SYMBOL_NAME_CODES are written, recorded in the stream header (2 bits).
+	enum SYMBOL_CODING {
+		SYMBOL_CODING_FIXED,   // SYMBOL_NAME_CODES::BIT_WIDTH bits per code
+		SYMBOL_CODING_HUFFMAN, // canonical Huffman code built for the source, stored in the header
+		SYMBOL_CODING_RANS,    // all the codes rANS coded together after the header, see SymbolRansCoder.h
+		SYMBOL_CODING_INTERLEAVED, // fixed width codes, the new symbol names dealt to NB_INTERLEAVED_STREAMS
+		                           // streams after the header, decoded together (see Decoder::decodeInterleavedSymbolNames())
+	};
+
+	// Huffman codes are a bit smaller, but only the fixed width codes have the multi-symbol decoding
+	// fast paths: they decompress faster.
+	static const SYMBOL_CODING DEFAULT_SYMBOL_CODING = SYMBOL_CODING_FIXED;
+
+	// With a dictionary, the stream can only be decompressed with the same dictionary. Only its use is
+	// recorded in the stream header (1 bit): the containers record its id.
+	PackedBits compress(string_view source, SYMBOL_CODING coding = DEFAULT_SYMBOL_CODING, const SharedDictionary * dictionary = nullptr);
+	std::string decompress(InputBitStream & stream, const SharedDictionary * dictionary = nullptr);
+	// Tells if the stream was written by this version of compress() with coding, from its first bits.
+	bool hasFormat(InputBitStream & stream, SYMBOL_CODING coding);
+	// Same streams, the blocks, symbol codes and phases added to statistics (see CompressionStatistics.h).
+	// Decompression doesn't count the symbol codes nor the bits of interleaved symbol names, and the
+	// stream must be in memory.
+	PackedBits compress(string_view source, SYMBOL_CODING coding, const SharedDictionary * dictionary, CompressionStatistics & statistics);
+	std::string decompress(InputBitStream & stream, const SharedDictionary * dictionary, CompressionStatistics & statistics);
+
+	// Tells if name is a symbol name (or a keyword) of the compressed source, without building its
+	// text: the name is encoded like the Encoder would from both case states and compared with the
+	// bits of the new symbol names of the same length, and only the matching ones are decoded to be
+	// verified. The blocks are still read one by one (the payloads have no stored bit lengths): the
+	// other symbol names, the comments and the strings are skipped code by code, only the special
+	// chars (scopes) and the indentations are decoded.
+	// Names in comments or strings are not found. The stream must not pull from a source.
+	bool containsSymbolName(InputBitStream & stream, string_view name, const SharedDictionary * dictionary = nullptr);
+
+	// Files start with the "SRCZ" magic, the bit length of the stream and the id of the dictionary
+	// or 0 (32 bits each, little endian).
+	void compressFile(const std::string & source_path, const std::string & compressed_path, const SharedDictionary * dictionary = nullptr);
+	void decompressFile(const std::string & compressed_path, const std::string & source_path, const SharedDictionary * dictionary = nullptr);
+
+	std::string readFile(const std::string & path);
+	void writeFile(const std::string & path, const char * data, size_t size);
+}
+
+void test_Compressor();
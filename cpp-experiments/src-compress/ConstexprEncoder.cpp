@@ -0,0 +1,80 @@
+#include "ConstexprEncoder.h"
+#include "Encoder.h"
+#include "Decoder.h"
+
+#include "string_view.h"
+#include <cassert>
+
+// ----------------------------------------------------------------
+
+static constexpr auto A = ConstexprEncoder::encodeSymbolName("a");
+static_assert(A.sizeInBits == 5 && A.data[0] == 0, "a: LETTER_A");
+static constexpr auto B = ConstexprEncoder::encodeSymbolName("b");
+static_assert(B.data[0] == 0b00001000, "b: LETTER_B");
+
+// CASE_INVERSE_ONCE, LETTER_A
+static constexpr auto UPPER_A = ConstexprEncoder::encodeSymbolName("A");
+static_assert(UPPER_A.sizeInBits == 10 && UPPER_A.data[0] == 0b11011000 && UPPER_A.data[1] == 0, "A");
+static_assert(UPPER_A.endCase == BitStream::CASE_LOWER, "A");
+
+// CASE_INVERSE_PERMANENT, LETTER_A, LETTER_Z
+static constexpr auto UPPER_AZ = ConstexprEncoder::encodeSymbolName("AZ");
+static_assert(UPPER_AZ.sizeInBits == 15 && UPPER_AZ.data[0] == 0b11100000 && UPPER_AZ.data[1] == 0b00110010, "AZ");
+static_assert(UPPER_AZ.endCase == BitStream::CASE_UPPER, "AZ");
+
+// UNDERSCORE, DIGITS_2BITS 1
+static constexpr auto UNDERSCORE_1 = ConstexprEncoder::encodeSymbolName("_1");
+static_assert(UNDERSCORE_1.sizeInBits == 12 && UNDERSCORE_1.data[0] == 0b11010111 && UNDERSCORE_1.data[1] == 0b01010000, "_1");
+
+// DIGITS_10BITS 109, DIGITS_2BITS 2
+static_assert(ConstexprEncoder::encodeSymbolName("1092").sizeInBits == 15 + 7, "1092");
+static_assert(ConstexprEncoder::encodeSymbolName("").sizeInBits == 0, "empty name");
+
+template<size_t NB_CHARS>
+static void test_matches_encoder(const char * name, const EncodedSymbolName<NB_CHARS> & encoded) {
+	OutputBitStream stream;
+	string_view str(name);
+	Encoder::encodeNextSymbolName(stream, str);
+	assert(str.empty());
+	assert(encoded.endCase == stream.currentCase());
+	const PackedBits expected = stream.release();
+	const PackedBits bits = encoded.toPackedBits();
+	assert(bits.sizeInBits == expected.sizeInBits);
+	assert(bits.data == expected.data);
+	for (size_t i = bits.data.size(); i < encoded.data.size(); ++i) {
+		assert(encoded.data[i] == 0);
+	}
+}
+
+// the name is encoded at compile time
+#define TEST_MATCHES_ENCODER(name) { \
+		static constexpr auto encoded = ConstexprEncoder::encodeSymbolName(name); \
+		test_matches_encoder(name, encoded); \
+	}
+
+void test_ConstexprEncoder() {
+	TEST_MATCHES_ENCODER("a");
+	TEST_MATCHES_ENCODER("A");
+	TEST_MATCHES_ENCODER("AZ");
+	TEST_MATCHES_ENCODER("A_z");
+	TEST_MATCHES_ENCODER("A_Z");
+	TEST_MATCHES_ENCODER("uint64_t");
+	TEST_MATCHES_ENCODER("aClass");
+	TEST_MATCHES_ENCODER("AClass");
+	TEST_MATCHES_ENCODER("A_Class__");
+	TEST_MATCHES_ENCODER("_A__C_lass");
+	TEST_MATCHES_ENCODER("MAX_SIZE_IN_BITS");
+	TEST_MATCHES_ENCODER("encodeNextSymbolName");
+	TEST_MATCHES_ENCODER("AClass_1024");
+	TEST_MATCHES_ENCODER("a0b03c4d67e68f1091g1092h109168i200001");
+	TEST_MATCHES_ENCODER("ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz_0123456789");
+
+	// appended to a stream as if it was encoded at runtime
+	static constexpr auto uint64_t_name = ConstexprEncoder::encodeSymbolName("uint64_t");
+	OutputBitStream stream;
+	stream.appendBits(0b101, 3);
+	stream.appendPackedBits(uint64_t_name.toPackedBits());
+	InputBitStream input(stream.release());
+	assert(input.readBits(3) == 0b101);
+	assert(Decoder::decodeNextSymbolName(input) == "uint64_t");
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "BitStream.h"
+#include "EncodingTables.h"
+#include "IndexList.h"
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+
+// A symbol name encoded at compile time (see ConstexprEncoder::encodeSymbolName).
+// The bits are packed most significant bit first in an array sized for the worst case of
+// NB_CHARS chars (11 bits per char: a single digit written as DIGITS_6BITS): only the
+// sizeInBits first bits are used, the next ones are 0.
+template<size_t NB_CHARS>
+struct EncodedSymbolName {
+	static const size_t NB_BYTES = (NB_CHARS * 11 + 7) / 8;
+
+	std::array<unsigned char, NB_BYTES> data;
+	unsigned int sizeInBits;
+	// current case of the stream after the name
+	BitStream::CASE_KIND endCase;
+
+	PackedBits toPackedBits() const {
+		PackedBits bits;
+		bits.data.assign(data.begin(), data.begin() + (sizeInBits + 7) / 8);
+		bits.sizeInBits = sizeInBits;
+		return bits;
+	}
+};
+
+// Encoder::encodeNextSymbolName() evaluated by the compiler, so that well-known names can be
+// carried pre-encoded:
+//   static constexpr auto UINT64_T = ConstexprEncoder::encodeSymbolName("uint64_t");
+// The bits are the ones written with the fixed width SYMBOL_NAME_CODES (no Huffman code) to a
+// stream in CASE_LOWER, such as a new stream. A name with a char which is not a letter, a digit
+// or an underscore doesn't compile.
+// C++11 constexpr functions (a single return statement): the name is walked recursively, one
+// token (a SYMBOL_NAME_CODES and its payload) at a time.
+namespace ConstexprEncoder {
+	struct Token {
+		unsigned int bits;     // the SYMBOL_NAME_CODES followed by its payload
+		unsigned int nbBits;
+		unsigned int nbChars;  // chars of the name written by the token
+		BitStream::CASE_KIND nextCase;
+	};
+
+	constexpr bool isLower(char c) {
+		return c >= 'a' && c <= 'z';
+	}
+
+	constexpr bool isUpper(char c) {
+		return c >= 'A' && c <= 'Z';
+	}
+
+	constexpr bool isDigit(char c) {
+		return c >= '0' && c <= '9';
+	}
+
+	constexpr unsigned int minimum(unsigned int a, unsigned int b) {
+		return (a < b) ? a : b;
+	}
+
+	constexpr unsigned int code(SYMBOL_NAME_CODES::ENUM code, unsigned int payload, unsigned int payload_bits) {
+		return (static_cast<unsigned int>(code) << payload_bits) | payload;
+	}
+
+	constexpr BitStream::CASE_KIND inverse(BitStream::CASE_KIND case_kind) {
+		return (case_kind == BitStream::CASE_LOWER) ? BitStream::CASE_UPPER : BitStream::CASE_LOWER;
+	}
+
+	// Same as CaseRuns: is there a letter of the given case after pos?
+	constexpr bool hasLetterOfCaseAfter(const char * name, unsigned int pos, bool upper) {
+		return (name[pos + 1] != 0) &&
+			((upper ? isUpper(name[pos + 1]) : isLower(name[pos + 1])) || hasLetterOfCaseAfter(name, pos + 1, upper));
+	}
+
+	constexpr unsigned int digitRunLength(const char * name, unsigned int pos) {
+		return isDigit(name[pos]) ? 1 + digitRunLength(name, pos + 1) : 0;
+	}
+
+	constexpr unsigned int digitsValue(const char * name, unsigned int pos, unsigned int nb_digits, unsigned int value) {
+		return (nb_digits == 0) ? value : digitsValue(name, pos + 1, nb_digits - 1, value * 10 + (name[pos] - '0'));
+	}
+
+	// Same as extract_4_digits_number: a leading zero is a number on its own.
+	constexpr unsigned int leadingNumber(const char * name, unsigned int pos, unsigned int nb_digits) {
+		return (name[pos] == '0') ? 0 : digitsValue(name, pos, nb_digits, 0);
+	}
+
+	constexpr unsigned int letterCode(char c) {
+		return SYMBOL_NAME_CODES::LETTER_A + (isUpper(c) ? c - 'A' : c - 'a');
+	}
+
+	constexpr Token letterToken(const char * name, unsigned int pos, BitStream::CASE_KIND current_case) {
+		return (isUpper(name[pos]) == (current_case == BitStream::CASE_UPPER)) ?
+			Token{ letterCode(name[pos]), SYMBOL_NAME_CODES::BIT_WIDTH, 1, current_case } :
+			hasLetterOfCaseAfter(name, pos, isUpper(name[pos])) ?
+				Token{ code(SYMBOL_NAME_CODES::CASE_INVERSE_PERMANENT, letterCode(name[pos]), SYMBOL_NAME_CODES::BIT_WIDTH), 2 * SYMBOL_NAME_CODES::BIT_WIDTH, 1, inverse(current_case) } :
+				Token{ code(SYMBOL_NAME_CODES::CASE_INVERSE_ONCE, letterCode(name[pos]), SYMBOL_NAME_CODES::BIT_WIDTH), 2 * SYMBOL_NAME_CODES::BIT_WIDTH, 1, current_case };
+	}
+
+	// Same as Encoder::encodeNumber, one DIGITS_* code at a time.
+	constexpr Token numberToken(const char * name, unsigned int pos, unsigned int nb_digits, unsigned int number, BitStream::CASE_KIND current_case) {
+		return (number <= 3) ?
+			Token{ code(SYMBOL_NAME_CODES::DIGITS_2BITS, number, 2), SYMBOL_NAME_CODES::BIT_WIDTH + 2, 1, current_case } :
+			(number <= 67) ?
+				Token{ code(SYMBOL_NAME_CODES::DIGITS_6BITS, number - 4, 6), SYMBOL_NAME_CODES::BIT_WIDTH + 6, nb_digits, current_case } :
+				(number <= 1091) ?
+					Token{ code(SYMBOL_NAME_CODES::DIGITS_10BITS, number - 68, 10), SYMBOL_NAME_CODES::BIT_WIDTH + 10, minimum(nb_digits, 4), current_case } :
+					Token{ code(SYMBOL_NAME_CODES::DIGITS_10BITS, leadingNumber(name, pos, 3) - 68, 10), SYMBOL_NAME_CODES::BIT_WIDTH + 10, 3, current_case };
+	}
+
+	constexpr Token numberToken(const char * name, unsigned int pos, unsigned int nb_digits, BitStream::CASE_KIND current_case) {
+		return numberToken(name, pos, nb_digits, leadingNumber(name, pos, minimum(nb_digits, 4)), current_case);
+	}
+
+	constexpr Token tokenAt(const char * name, unsigned int pos, BitStream::CASE_KIND current_case) {
+		return (isLower(name[pos]) || isUpper(name[pos])) ? letterToken(name, pos, current_case) :
+			(name[pos] == '_') ? Token{ SYMBOL_NAME_CODES::UNDERSCORE, SYMBOL_NAME_CODES::BIT_WIDTH, 1, current_case } :
+			isDigit(name[pos]) ? numberToken(name, pos, digitRunLength(name, pos), current_case) :
+			throw std::logic_error("Invalid symbol name!");
+	}
+
+	constexpr unsigned int sizeInBits(const char * name, unsigned int pos, BitStream::CASE_KIND current_case);
+
+	constexpr unsigned int sizeInBits(const char * name, unsigned int pos, const Token & token) {
+		return token.nbBits + sizeInBits(name, pos + token.nbChars, token.nextCase);
+	}
+
+	constexpr unsigned int sizeInBits(const char * name, unsigned int pos, BitStream::CASE_KIND current_case) {
+		return (name[pos] == 0) ? 0 : sizeInBits(name, pos, tokenAt(name, pos, current_case));
+	}
+
+	constexpr BitStream::CASE_KIND endCase(const char * name, unsigned int pos, BitStream::CASE_KIND current_case);
+
+	constexpr BitStream::CASE_KIND endCase(const char * name, unsigned int pos, const Token & token) {
+		return endCase(name, pos + token.nbChars, token.nextCase);
+	}
+
+	constexpr BitStream::CASE_KIND endCase(const char * name, unsigned int pos, BitStream::CASE_KIND current_case) {
+		return (name[pos] == 0) ? current_case : endCase(name, pos, tokenAt(name, pos, current_case));
+	}
+
+	// bit (0 past the end) of the encoding of the name from pos
+	constexpr unsigned int bitAt(const char * name, unsigned int bit, unsigned int pos, BitStream::CASE_KIND current_case);
+
+	constexpr unsigned int bitAt(const char * name, unsigned int bit, unsigned int pos, const Token & token) {
+		return (bit < token.nbBits) ? (token.bits >> (token.nbBits - 1 - bit)) & 1 :
+			bitAt(name, bit - token.nbBits, pos + token.nbChars, token.nextCase);
+	}
+
+	constexpr unsigned int bitAt(const char * name, unsigned int bit, unsigned int pos, BitStream::CASE_KIND current_case) {
+		return (name[pos] == 0) ? 0 : bitAt(name, bit, pos, tokenAt(name, pos, current_case));
+	}
+
+	constexpr unsigned char byteAt(const char * name, unsigned int index) {
+		return static_cast<unsigned char>(
+			(bitAt(name, index * 8 + 0, 0, BitStream::CASE_LOWER) << 7) |
+			(bitAt(name, index * 8 + 1, 0, BitStream::CASE_LOWER) << 6) |
+			(bitAt(name, index * 8 + 2, 0, BitStream::CASE_LOWER) << 5) |
+			(bitAt(name, index * 8 + 3, 0, BitStream::CASE_LOWER) << 4) |
+			(bitAt(name, index * 8 + 4, 0, BitStream::CASE_LOWER) << 3) |
+			(bitAt(name, index * 8 + 5, 0, BitStream::CASE_LOWER) << 2) |
+			(bitAt(name, index * 8 + 6, 0, BitStream::CASE_LOWER) << 1) |
+			(bitAt(name, index * 8 + 7, 0, BitStream::CASE_LOWER) << 0));
+	}
+
+	template<size_t N, unsigned int... Bytes>
+	constexpr EncodedSymbolName<N - 1> encodeSymbolName(const char (&name)[N], IndexList<Bytes...>) {
+		return EncodedSymbolName<N - 1>{ { { byteAt(name, Bytes)... } }, sizeInBits(name, 0, BitStream::CASE_LOWER), endCase(name, 0, BitStream::CASE_LOWER) };
+	}
+
+	// name: a string literal
+	template<size_t N>
+	constexpr EncodedSymbolName<N - 1> encodeSymbolName(const char (&name)[N]) {
+		return encodeSymbolName(name, typename MakeIndexList<static_cast<unsigned int>(EncodedSymbolName<N - 1>::NB_BYTES)>::type());
+	}
+}
+
+void test_ConstexprEncoder();
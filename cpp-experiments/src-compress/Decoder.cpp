@@ -1,67 +1,834 @@
 #include "Decoder.h"
 #include "BitStream.h"
+#include "Encoder.h"
+#include "SymbolCodeUnpacker.h"
+#include "SymbolDictionary.h"
+#include "TextCodec.h"
+#include "Tokenizer.h"
+#include "Keywords.h"
 
 #include <cassert>
+#include <cstring>
+#include <vector>
+#include <algorithm>
 
-static int decode2BitsNumber(InputBitStream & stream) {
+template<typename Stream>
+static int decode2BitsNumber(Stream & stream) {
 	assert(stream.remainingBits() >= 2);
 	return static_cast<int>(stream.readBits(2));
 }
 
-static int decode6BitsNumber(InputBitStream & stream) {
+template<typename Stream>
+static int decode6BitsNumber(Stream & stream) {
 	assert(stream.remainingBits() >= 6);
 	return static_cast<int>(stream.readBits(6)) + 4;
 }
 
-static int decode10BitsNumber(InputBitStream & stream) {
+template<typename Stream>
+static int decode10BitsNumber(Stream & stream) {
 	assert(stream.remainingBits() >= 10);
 	return static_cast<int>(stream.readBits(10)) + 68;
 }
 
+// Output of the symbol name decoders: appends to a std::string.
+class StringOutput {
+public:
+	explicit StringOutput(std::string & str) : m_str(str) {
+	}
+	size_t length() const {
+		return m_str.length();
+	}
+	void append(char c) {
+		m_str += c;
+	}
+	void append(const char * chars, size_t nb_chars) {
+		m_str.append(chars, nb_chars);
+	}
+
+private:
+	std::string & m_str;
+};
+
+// Output of the symbol name decoders: writes to a caller-provided buffer, throws when it is full.
+class BufferOutput {
+public:
+	BufferOutput(char * buffer, size_t capacity) : m_buffer(buffer), m_capacity(capacity) {
+	}
+	size_t length() const {
+		return m_length;
+	}
+	void append(char c) {
+		if (unlikely(m_length == m_capacity))
+			throw make_logic_error("Symbol name buffer overflow!");
+		m_buffer[m_length++] = c;
+	}
+	void append(const char * chars, size_t nb_chars) {
+		if (unlikely(nb_chars > m_capacity - m_length))
+			throw make_logic_error("Symbol name buffer overflow!");
+		std::memcpy(m_buffer + m_length, chars, nb_chars);
+		m_length += nb_chars;
+	}
+
+private:
+	char * m_buffer;
+	size_t m_capacity;
+	size_t m_length = 0;
+};
+
+// Output of the symbol name decoders: only counts the characters, to skip symbol names.
+class LengthOutput {
+public:
+	size_t length() const {
+		return m_length;
+	}
+	void append(char) {
+		m_length += 1;
+	}
+	void append(const char *, size_t nb_chars) {
+		m_length += nb_chars;
+	}
+
+private:
+	size_t m_length = 0;
+};
+
+// Decimal digits of a decoded number (at most 1091, so 4 digits), without temporary strings.
+template<typename Output>
+static void append_number(Output & output, int number) {
+	assert(number >= 0 && number <= 9999);
+	char digits[4];
+	int nb_digits = 0;
+	do {
+		digits[3 - nb_digits++] = static_cast<char>('0' + number % 10);
+		number /= 10;
+	} while (number > 0);
+	output.append(digits + 4 - nb_digits, nb_digits);
+}
+
+// Decodes a single code with the same rules as decodeNextSymbolName().
+template<typename Stream, typename Output>
+static void decodeSymbolCode(Stream & stream, SYMBOL_NAME_CODES::ENUM code, Output & str, bool & caseIsInversedOnce) {
+	if (code >= SYMBOL_NAME_CODES::LETTER_A && code <= SYMBOL_NAME_CODES::LETTER_Z) {
+		static_assert(SYMBOL_NAME_CODES::LETTER_Z - SYMBOL_NAME_CODES::LETTER_A == 25, "Problem with A-Z");
+		int letterNumber = static_cast<int>(code - SYMBOL_NAME_CODES::LETTER_A);
+		if (stream.currentCase() == BitStream::CASE_LOWER) {
+			str.append(static_cast<char>((caseIsInversedOnce ? 'A' : 'a') + letterNumber));
+		}
+		else if (stream.currentCase() == BitStream::CASE_UPPER) {
+			str.append(static_cast<char>((caseIsInversedOnce ? 'a' : 'A') + letterNumber));
+		}
+		else {
+			throw make_logic_error("Invalid current case!");
+		}
+		caseIsInversedOnce = false;
+	}
+	else if (code == SYMBOL_NAME_CODES::UNDERSCORE) {
+		str.append('_');
+	}
+	else if (code == SYMBOL_NAME_CODES::CASE_INVERSE_ONCE) {
+		caseIsInversedOnce = true;
+	}
+	else if (code == SYMBOL_NAME_CODES::CASE_INVERSE_PERMANENT) {
+		stream.invertCurrentCase();
+	}
+	else if (code == SYMBOL_NAME_CODES::DIGITS_2BITS) {
+		append_number(str, decode2BitsNumber(stream));
+	}
+	else if (code == SYMBOL_NAME_CODES::DIGITS_6BITS) {
+		append_number(str, decode6BitsNumber(stream));
+	}
+	else if (code == SYMBOL_NAME_CODES::DIGITS_10BITS) {
+		append_number(str, decode10BitsNumber(stream));
+	}
+	else {
+		throw make_logic_error("Invalid symbol name code!");
+	}
+}
+
+// Multi-symbol decoding table indexed by the next DECODING_WINDOW_BITS bits of the stream.
+// Each entry gives the leading literal characters (letters and underscores) of the window for
+// both cases. Case inversions and numbers are not handled by the table (nbSymbols == 0).
+static const unsigned int SYMBOLS_PER_WINDOW = 3;
+static const unsigned int DECODING_WINDOW_BITS = SYMBOLS_PER_WINDOW * SYMBOL_NAME_CODES::BIT_WIDTH;
+
+struct DecodingTableEntry {
+	char text[2][SYMBOLS_PER_WINDOW]; // indexed by BitStream::CASE_KIND
+	unsigned char nbSymbols;
+};
+
+static std::vector<DecodingTableEntry> build_decoding_table() {
+	static_assert(BitStream::CASE_LOWER == 0 && BitStream::CASE_UPPER == 1, "CASE_KIND is used as an index");
+	const unsigned int code_mask = (1 << SYMBOL_NAME_CODES::BIT_WIDTH) - 1;
+
+	std::vector<DecodingTableEntry> table(1 << DECODING_WINDOW_BITS);
+	for (unsigned int window = 0; window < table.size(); ++window) {
+		DecodingTableEntry & entry = table[window];
+		entry.nbSymbols = 0;
+		for (unsigned int i = 0; i < SYMBOLS_PER_WINDOW; ++i) {
+			const unsigned int shift = DECODING_WINDOW_BITS - (i + 1) * SYMBOL_NAME_CODES::BIT_WIDTH;
+			const unsigned int code = (window >> shift) & code_mask;
+			if (code <= SYMBOL_NAME_CODES::LETTER_Z) {
+				entry.text[BitStream::CASE_LOWER][i] = static_cast<char>('a' + code);
+				entry.text[BitStream::CASE_UPPER][i] = static_cast<char>('A' + code);
+			} else if (code == SYMBOL_NAME_CODES::UNDERSCORE) {
+				entry.text[BitStream::CASE_LOWER][i] = '_';
+				entry.text[BitStream::CASE_UPPER][i] = '_';
+			} else {
+				break;
+			}
+			entry.nbSymbols += 1;
+		}
+	}
+	return table;
+}
+
+static const DecodingTableEntry * decoding_table() {
+	static const std::vector<DecodingTableEntry> table = build_decoding_table();
+	return table.data();
+}
+
+// Characters of the letter and underscore codes, indexed by [case][code] (0 for the other codes).
+struct LiteralTable {
+	char chars[2][32];
+};
+
+static LiteralTable build_literal_table() {
+	LiteralTable table = {};
+	for (unsigned int code = SYMBOL_NAME_CODES::LETTER_A; code <= SYMBOL_NAME_CODES::LETTER_Z; ++code) {
+		table.chars[BitStream::CASE_LOWER][code] = static_cast<char>('a' + code);
+		table.chars[BitStream::CASE_UPPER][code] = static_cast<char>('A' + code);
+	}
+	table.chars[BitStream::CASE_LOWER][SYMBOL_NAME_CODES::UNDERSCORE] = '_';
+	table.chars[BitStream::CASE_UPPER][SYMBOL_NAME_CODES::UNDERSCORE] = '_';
+	return table;
+}
+
+static const LiteralTable literal_table = build_literal_table();
+
+// Table-driven decoding, appends to str until the end of the stream or until str reaches end_length.
+template<typename Output>
+static void decode_symbol_name(InputBitStream & stream, Output & str, size_t end_length) {
+	const DecodingTableEntry * table = decoding_table();
+	// the multi-symbol table only applies to fixed-width codes
+	const bool fixed_width_codes = (stream.symbolHuffmanCode() == nullptr && stream.symbolCodeSource() == nullptr);
+
+	// literal characters are gathered in a small local buffer to avoid growing str char by char
+	char buffer[64];
+	unsigned int buffer_length = 0;
+	bool caseIsInversedOnce = false;
+	while (stream.hasSymbolCode() && str.length() + buffer_length < end_length) {
+		if (likely(fixed_width_codes && !caseIsInversedOnce && stream.remainingBits() >= DECODING_WINDOW_BITS &&
+			end_length - (str.length() + buffer_length) >= SYMBOLS_PER_WINDOW)) {
+			const DecodingTableEntry & entry = table[stream.peekBits(DECODING_WINDOW_BITS)];
+			if (likely(entry.nbSymbols > 0)) {
+				const char * text = entry.text[stream.currentCase()];
+				for (unsigned int i = 0; i < SYMBOLS_PER_WINDOW; ++i) {
+					buffer[buffer_length + i] = text[i];
+				}
+				buffer_length += entry.nbSymbols;
+				stream.consume(entry.nbSymbols * SYMBOL_NAME_CODES::BIT_WIDTH);
+				if (unlikely(buffer_length > sizeof(buffer) - SYMBOLS_PER_WINDOW)) {
+					str.append(buffer, buffer_length);
+					buffer_length = 0;
+				}
+				continue;
+			}
+		}
+		str.append(buffer, buffer_length);
+		buffer_length = 0;
+		decodeSymbolCode(stream, stream.readSymbolCode(), str, caseIsInversedOnce);
+	}
+	str.append(buffer, buffer_length);
+}
+
+// Same as decode_symbol_name() with runs of codes unpacked in bulk (see SymbolCodeUnpacker) before
+// being decoded, until the payload of a number breaks their alignment. Fixed-width codes of a stream
+// in memory only.
+template<typename Output>
+static void decode_symbol_name_bulk(InputBitStream & stream, Output & str, size_t end_length) {
+	assert(stream.symbolHuffmanCode() == nullptr && stream.symbolCodeSource() == nullptr && !stream.pullsFromSource());
+	const unsigned int CODE_BUFFER_SIZE = 32;
+	unsigned char codes[CODE_BUFFER_SIZE];
+	char buffer[CODE_BUFFER_SIZE];
+	bool caseIsInversedOnce = false;
+	while (str.length() < end_length && stream.remainingBits() >= SYMBOL_NAME_CODES::BIT_WIDTH) {
+		const size_t nb_chars_left = end_length - str.length();
+		unsigned int nb_codes = std::min(CODE_BUFFER_SIZE, stream.remainingBits() / SYMBOL_NAME_CODES::BIT_WIDTH);
+		if (nb_chars_left < nb_codes) {
+			// one code per char, plus room for a few case inversions
+			nb_codes = std::min(nb_codes, static_cast<unsigned int>(nb_chars_left) + 2);
+		}
+		SymbolCodeUnpacker::unpack(stream.data(), stream.dataSizeInBytes(), stream.currentBit(), codes, nb_codes);
+
+		unsigned int buffer_length = 0;
+		unsigned int i = 0;
+		for (; i < nb_codes && buffer_length < nb_chars_left; ++i) {
+			const unsigned int code = codes[i];
+			if (likely(code <= SYMBOL_NAME_CODES::UNDERSCORE)) {
+				const int letter_case = stream.currentCase() ^ (caseIsInversedOnce ? 1 : 0);
+				buffer[buffer_length++] = literal_table.chars[letter_case][code];
+				caseIsInversedOnce = false;
+			} else if (code == SYMBOL_NAME_CODES::CASE_INVERSE_ONCE) {
+				caseIsInversedOnce = true;
+			} else if (code == SYMBOL_NAME_CODES::CASE_INVERSE_PERMANENT) {
+				stream.invertCurrentCase();
+			} else {
+				break;
+			}
+		}
+		str.append(buffer, buffer_length);
+		stream.skipBits(i * SYMBOL_NAME_CODES::BIT_WIDTH);
+		if (i < nb_codes && buffer_length < nb_chars_left) {
+			// a number: its payload is read from the stream
+			decodeSymbolCode(stream, stream.readSymbolCode(), str, caseIsInversedOnce);
+		}
+	}
+}
+
+// Bulk decoding for the fixed-width codes of streams in memory, table-driven decoding otherwise.
+template<typename Output>
+static void decode_bounded_symbol_name(InputBitStream & stream, Output & str, size_t end_length) {
+	if (stream.symbolHuffmanCode() == nullptr && stream.symbolCodeSource() == nullptr && !stream.pullsFromSource()) {
+		decode_symbol_name_bulk(stream, str, end_length);
+	} else {
+		decode_symbol_name(stream, str, end_length);
+	}
+}
+
+// Table of the interleaved decoder, indexed by the case state of the lane (current case, plus 2
+// after a CASE_INVERSE_ONCE) and the next LANE_WINDOW_BITS bits: letters, underscores and case
+// inversions are decoded by a single lookup, so that the steps of the lanes don't branch on them.
+// Numbers are not handled by the table (nbBits == 0).
+static const unsigned int LANE_WINDOW_CODES = 2;
+static const unsigned int LANE_WINDOW_BITS = LANE_WINDOW_CODES * SYMBOL_NAME_CODES::BIT_WIDTH;
+
+struct LaneTableEntry {
+	char text[LANE_WINDOW_CODES];
+	unsigned char nbChars;
+	unsigned char nbBits;
+	unsigned char nextState;
+};
+
+static std::vector<LaneTableEntry> build_lane_table() {
+	const unsigned int code_mask = (1 << SYMBOL_NAME_CODES::BIT_WIDTH) - 1;
+	std::vector<LaneTableEntry> table(4 << LANE_WINDOW_BITS);
+	for (unsigned int state = 0; state < 4; ++state) {
+		for (unsigned int window = 0; window < (1u << LANE_WINDOW_BITS); ++window) {
+			LaneTableEntry & entry = table[(state << LANE_WINDOW_BITS) | window];
+			entry = LaneTableEntry();
+			unsigned int letter_case = state & 1;
+			bool inversed_once = (state & 2) != 0;
+			for (unsigned int i = 0; i < LANE_WINDOW_CODES; ++i) {
+				const unsigned int code = (window >> (LANE_WINDOW_BITS - (i + 1) * SYMBOL_NAME_CODES::BIT_WIDTH)) & code_mask;
+				if (code <= SYMBOL_NAME_CODES::LETTER_Z) {
+					entry.text[entry.nbChars++] = literal_table.chars[letter_case ^ (inversed_once ? 1 : 0)][code];
+					inversed_once = false;
+				} else if (code == SYMBOL_NAME_CODES::UNDERSCORE) {
+					entry.text[entry.nbChars++] = '_';
+				} else if (code == SYMBOL_NAME_CODES::CASE_INVERSE_ONCE) {
+					inversed_once = true;
+				} else if (code == SYMBOL_NAME_CODES::CASE_INVERSE_PERMANENT) {
+					letter_case ^= 1;
+				} else {
+					break;
+				}
+				entry.nbBits += SYMBOL_NAME_CODES::BIT_WIDTH;
+			}
+			entry.nextState = static_cast<unsigned char>(letter_case | (inversed_once ? 2 : 0));
+		}
+	}
+	return table;
+}
+
+static const LaneTableEntry * lane_table() {
+	static const std::vector<LaneTableEntry> table = build_lane_table();
+	return table.data();
+}
+
+// Position in one of the interleaved streams. Peeking is a single unaligned load at the position,
+// with no bit buffer to refill: the cursors of the streams don't share any state or dependency.
+class LaneCursor : public BitStream {
+public:
+	LaneCursor(const unsigned char * data, unsigned int first_bit, unsigned int size_in_bits) :
+		m_data(data), m_position(first_bit), m_size_in_bits(size_in_bits) {
+	}
+
+	unsigned int position() const {
+		return m_position;
+	}
+	unsigned int remainingBits() const {
+		return m_size_in_bits - m_position;
+	}
+
+	// Bits past the end of the stream are not masked: the rest of its last byte is read as is (then
+	// zeros), so the callers only use the bits up to remainingBits().
+	unsigned int peekBits(unsigned int nb_bits) const {
+		assert(nb_bits > 0 && nb_bits <= 32);
+		const unsigned int byte = m_position / 8;
+		uint64_t word;
+		if (likely(byte + 8 <= (m_size_in_bits + 7) / 8)) {
+			word = load_big_endian_64(m_data + byte);
+		} else {
+			unsigned char bytes[8] = {};
+			std::memcpy(bytes, m_data + byte, (m_size_in_bits + 7) / 8 - byte);
+			word = load_big_endian_64(bytes);
+		}
+		return static_cast<unsigned int>((word << (m_position % 8)) >> (64 - nb_bits));
+	}
+	void consume(unsigned int nb_bits) {
+		assert(nb_bits <= remainingBits());
+		m_position += nb_bits;
+	}
+	unsigned int readBits(unsigned int nb_bits) {
+		if (unlikely(nb_bits > remainingBits()))
+			throw make_logic_error("can't read bits");
+		const unsigned int value = peekBits(nb_bits);
+		m_position += nb_bits;
+		return value;
+	}
+	// See OutputBitStream::appendVarUInt().
+	unsigned int readVarUInt() {
+		unsigned int value = 0;
+		for (unsigned int shift = 0; shift < 32; shift += 4) {
+			const unsigned int group = readBits(5);
+			value |= (group & 0xF) << shift;
+			if ((group & 0x10) == 0)
+				return value;
+		}
+		throw make_logic_error("invalid variable length integer");
+	}
+
+private:
+	const unsigned char * m_data;
+	unsigned int m_position;
+	unsigned int m_size_in_bits;
+};
+
+// Output of the symbol name decoders: the names of a lane one after the other, in a buffer that
+// always has room for a window of the lane table.
+class LaneOutput {
+public:
+	size_t length() const {
+		return m_length;
+	}
+	const char * data() const {
+		return m_chars.data();
+	}
+	void append(char c) {
+		reserve(1);
+		m_chars[m_length++] = c;
+	}
+	void append(const char * chars, size_t nb_chars) {
+		reserve(nb_chars);
+		std::memcpy(&m_chars[m_length], chars, nb_chars);
+		m_length += nb_chars;
+	}
+	void append(const LaneTableEntry & entry) {
+		reserve(LANE_WINDOW_CODES);
+		for (unsigned int i = 0; i < LANE_WINDOW_CODES; ++i) {
+			m_chars[m_length + i] = entry.text[i];
+		}
+		m_length += entry.nbChars;
+	}
+
+private:
+	void reserve(size_t nb_chars) {
+		if (unlikely(m_length + nb_chars > m_chars.size())) {
+			m_chars.resize(std::max(2 * m_chars.size(), m_length + nb_chars + 256));
+		}
+	}
+
+	std::string m_chars;
+	size_t m_length = 0;
+};
+
+// Decoding state of one of the interleaved streams.
+struct InterleavedLane {
+	explicit InterleavedLane(const InputBitStream & stream) :
+		cursor(stream.data(), stream.currentBit(), stream.currentBit() + stream.remainingBits()),
+		state(stream.currentCase()) {
+	}
+
+	LaneCursor cursor;
+	LaneOutput output;
+	// end of each decoded name in output
+	std::vector<size_t> ends;
+	// characters left in the name being decoded, 0 between two names
+	size_t remaining = 0;
+	// index of the lane table: current case, plus 2 after a CASE_INVERSE_ONCE
+	unsigned int state;
+};
+
+// Skips the payload of length chars of nb_bits bits each.
+static void skip_chars(InputBitStream & stream, unsigned int length, unsigned int nb_bits) {
+	if (static_cast<uint64_t>(length) * nb_bits > stream.remainingBits())
+		throw make_logic_error("Block payload past the end of the stream!");
+	stream.skipBits(length * nb_bits);
+}
+
 namespace Decoder {
 	std::string decodeNextSymbolName(InputBitStream & stream) {
 		std::string str;
+		StringOutput output(str);
+		decode_symbol_name(stream, output, std::string::npos);
+		return str;
+	}
 
-		bool caseIsInversedOnce = false;
-		while (stream.remainingBits() >= SYMBOL_NAME_CODES::BIT_WIDTH) {
-			auto code = stream.readSymbolCode();
-			if (code >= SYMBOL_NAME_CODES::LETTER_A && code <= SYMBOL_NAME_CODES::LETTER_Z) {
-				static_assert(SYMBOL_NAME_CODES::LETTER_Z - SYMBOL_NAME_CODES::LETTER_A == 25, "Problem with A-Z");
-				int letterNumber = static_cast<int>(code - SYMBOL_NAME_CODES::LETTER_A);
-				if (stream.currentCase() == BitStream::CASE_LOWER) {
-					str += (caseIsInversedOnce ? 'A' : 'a') + letterNumber;
+	size_t decodeNextSymbolName(InputBitStream & stream, char * buffer, size_t capacity) {
+		BufferOutput output(buffer, capacity);
+		decode_symbol_name(stream, output, std::string::npos);
+		return output.length();
+	}
+
+	void decodeSymbolName(InputBitStream & stream, unsigned int length, std::string & str) {
+		const size_t end_length = str.length() + length;
+		StringOutput output(str);
+		decode_bounded_symbol_name(stream, output, end_length);
+		if (str.length() != end_length)
+			throw make_logic_error("Symbol name length mismatch!");
+	}
+
+	void skipSymbolName(InputBitStream & stream, unsigned int length) {
+		LengthOutput output;
+		decode_bounded_symbol_name(stream, output, length);
+		if (output.length() != length)
+			throw make_logic_error("Symbol name length mismatch!");
+	}
+
+	void decodeInterleavedSymbolNames(InputBitStream * const streams[NB_INTERLEAVED_STREAMS], SymbolTable names[NB_INTERLEAVED_STREAMS]) {
+		const LaneTableEntry * table = lane_table();
+		for (unsigned int i = 0; i < NB_INTERLEAVED_STREAMS; ++i) {
+			if (streams[i]->symbolHuffmanCode() != nullptr || streams[i]->symbolCodeSource() != nullptr)
+				throw make_logic_error("Interleaved symbol names use fixed width codes!");
+			if (streams[i]->pullsFromSource())
+				throw make_logic_error("Interleaved symbol names must be in memory!");
+		}
+		static_assert(NB_INTERLEAVED_STREAMS == 4, "one lane per stream");
+		InterleavedLane lanes[NB_INTERLEAVED_STREAMS] = {
+			InterleavedLane(*streams[0]), InterleavedLane(*streams[1]), InterleavedLane(*streams[2]), InterleavedLane(*streams[3])
+		};
+
+		// one step per lane and iteration
+		bool active = true;
+		while (active) {
+			active = false;
+			for (InterleavedLane & lane : lanes) {
+				LaneCursor & cursor = lane.cursor;
+				if (lane.remaining == 0) {
+					if (cursor.remainingBits() == 0)
+						continue;
+					lane.remaining = cursor.readVarUInt() + 1;
 				}
-				else if (stream.currentCase() == BitStream::CASE_UPPER) {
-					str += (caseIsInversedOnce ? 'a' : 'A') + letterNumber;
+				active = true;
+
+				// the window can't go past the end of the name: it holds at most one char per code
+				// and stops at numbers
+				const LaneTableEntry & entry = table[(lane.state << LANE_WINDOW_BITS) | cursor.peekBits(LANE_WINDOW_BITS)];
+				if (likely(entry.nbBits != 0 && lane.remaining >= LANE_WINDOW_CODES && cursor.remainingBits() >= LANE_WINDOW_BITS)) {
+					lane.output.append(entry);
+					lane.remaining -= entry.nbChars;
+					lane.state = entry.nextState;
+					cursor.consume(entry.nbBits);
+				} else {
+					// numbers and the last char of a name, see decode_symbol_name()
+					if ((lane.state & 1) != static_cast<unsigned int>(cursor.currentCase())) {
+						cursor.invertCurrentCase();
+					}
+					bool caseIsInversedOnce = (lane.state & 2) != 0;
+					const size_t length = lane.output.length();
+					const SYMBOL_NAME_CODES::ENUM code = static_cast<SYMBOL_NAME_CODES::ENUM>(cursor.readBits(SYMBOL_NAME_CODES::BIT_WIDTH));
+					decodeSymbolCode(cursor, code, lane.output, caseIsInversedOnce);
+					if (lane.output.length() - length > lane.remaining)
+						throw make_logic_error("Symbol name length mismatch!");
+					lane.remaining -= lane.output.length() - length;
+					lane.state = cursor.currentCase() | (caseIsInversedOnce ? 2 : 0);
 				}
-				else {
-					throw make_logic_error("Invalid current case!");
+				if (lane.remaining == 0) {
+					lane.ends.push_back(lane.output.length());
 				}
-				caseIsInversedOnce = false;
 			}
-			else if (code == SYMBOL_NAME_CODES::UNDERSCORE) {
-				str += '_';
-			}
-			else if (code == SYMBOL_NAME_CODES::CASE_INVERSE_ONCE) {
-				caseIsInversedOnce = true;
-			}
-			else if (code == SYMBOL_NAME_CODES::CASE_INVERSE_PERMANENT) {
-				stream.invertCurrentCase();
+		}
+
+		for (unsigned int i = 0; i < NB_INTERLEAVED_STREAMS; ++i) {
+			const InterleavedLane & lane = lanes[i];
+			size_t start = 0;
+			for (size_t end : lane.ends) {
+				names[i].add(lane.output.data() + start, static_cast<unsigned int>(end - start));
+				start = end;
 			}
-			else if (code == SYMBOL_NAME_CODES::DIGITS_2BITS) {
-				str += std::to_string(decode2BitsNumber(stream));
+			// the streams end up where the lanes stopped
+			streams[i]->skipBits(lane.cursor.position() - streams[i]->currentBit());
+			if (static_cast<unsigned int>(streams[i]->currentCase()) != (lane.state & 1)) {
+				streams[i]->invertCurrentCase();
 			}
-			else if (code == SYMBOL_NAME_CODES::DIGITS_6BITS) {
-				str += std::to_string(decode6BitsNumber(stream));
+		}
+	}
+
+	std::string decodeNextSymbolNameBulk(InputBitStream & stream) {
+		if (stream.symbolHuffmanCode() != nullptr || stream.symbolCodeSource() != nullptr || stream.pullsFromSource()) {
+			return decodeNextSymbolName(stream);
+		}
+		std::string str;
+		StringOutput output(str);
+		decode_symbol_name_bulk(stream, output, std::string::npos);
+		return str;
+	}
+
+	std::string decodeNextSymbolNameCodeByCode(InputBitStream & stream) {
+		std::string str;
+		StringOutput output(str);
+
+		bool caseIsInversedOnce = false;
+		while (stream.hasSymbolCode()) {
+			decodeSymbolCode(stream, stream.readSymbolCode(), output, caseIsInversedOnce);
+		}
+
+		return str;
+	}
+
+	BLOCK_TYPE decodeNextBlock(InputBitStream & stream, std::string & output) {
+		const BLOCK_TYPE type = decodeBlockType(stream);
+		decodeBlockPayload(stream, type, output);
+		return type;
+	}
+
+	BLOCK_TYPE decodeBlockType(InputBitStream & stream) {
+		return static_cast<BLOCK_TYPE>(stream.readBits(BLOCK_TYPE_BIT_WIDTH));
+	}
+
+	unsigned int decodeSymbolReference(InputBitStream & stream, unsigned int nb_names) {
+		const unsigned int nb_bits = symbol_id_bit_width(nb_names);
+		const unsigned int id = (nb_bits == 0) ? 0 : stream.readBits(nb_bits);
+		if (id >= nb_names)
+			throw make_logic_error("Invalid symbol reference!");
+		return id;
+	}
+
+	void decodeBlockPayload(InputBitStream & stream, BLOCK_TYPE type, std::string & output) {
+		switch (type) {
+		case NEW_SYMBOL_NAME_LOCAL_SCOPE:
+		case NEW_SYMBOL_NAME_GLOBAL_SCOPE:
+		case ENCODED_NUMBER:
+			decodeSymbolName(stream, stream.readVarUInt() + 1, output);
+			break;
+		case SEPARATOR:
+			output.append(stream.readVarUInt() + 1, ' ');
+			break;
+		case INDENT_BLOCK: {
+			const unsigned int length = stream.readVarUInt() + 1;
+			for (unsigned int i = 0; i < length; ++i) {
+				output += stream.readBits(1) ? '\t' : ' ';
 			}
-			else if (code == SYMBOL_NAME_CODES::DIGITS_10BITS) {
-				str += std::to_string(decode10BitsNumber(stream));
+			break;
+		}
+		case NEW_LINE:
+			output += stream.readBits(1) ? "\r\n" : "\n";
+			break;
+		case SPECIAL_CHAR_BLOCK: {
+			const unsigned int length = stream.readVarUInt() + 1;
+			for (unsigned int i = 0; i < length; ++i) {
+				output += static_cast<char>(stream.readBits(7));
 			}
-			else {
-				throw make_logic_error("Invalid symbol name code!");
+			break;
+		}
+		case COMMENT_BLOCK:
+		case STRING_BLOCK:
+			TextCodec::decode(stream, stream.readVarUInt() + 1, output);
+			break;
+		case KEYWORD: {
+			const string_view name = Keywords::name(stream.readBits(Keywords::BIT_WIDTH));
+			output.append(name.data(), name.length());
+			break;
+		}
+		case UNDETERMINED_BLOCK: {
+			const unsigned int length = stream.readVarUInt() + 1;
+			for (unsigned int i = 0; i < length; ++i) {
+				output += static_cast<char>(stream.readBits(8));
 			}
+			break;
+		}
+		default:
+			throw make_logic_error("Unsupported block type!");
 		}
+	}
 
-		return str;
+	void skipBlockPayload(InputBitStream & stream, BLOCK_TYPE type) {
+		switch (type) {
+		case NEW_SYMBOL_NAME_LOCAL_SCOPE:
+		case NEW_SYMBOL_NAME_GLOBAL_SCOPE:
+		case ENCODED_NUMBER:
+			skipSymbolName(stream, stream.readVarUInt() + 1);
+			break;
+		case SEPARATOR:
+			stream.readVarUInt();
+			break;
+		case INDENT_BLOCK:
+			skip_chars(stream, stream.readVarUInt() + 1, 1);
+			break;
+		case NEW_LINE:
+			stream.readBits(1);
+			break;
+		case SPECIAL_CHAR_BLOCK:
+			skip_chars(stream, stream.readVarUInt() + 1, 7);
+			break;
+		case COMMENT_BLOCK:
+		case STRING_BLOCK:
+			TextCodec::skip(stream, stream.readVarUInt() + 1);
+			break;
+		case KEYWORD:
+			stream.readBits(Keywords::BIT_WIDTH);
+			break;
+		case UNDETERMINED_BLOCK:
+			skip_chars(stream, stream.readVarUInt() + 1, 8);
+			break;
+		default:
+			throw make_logic_error("Unsupported block type!");
+		}
 	}
-}
\ No newline at end of file
+}
+
+// ----------------------------------------------------------------
+
+struct TestBits {
+	unsigned int value;
+	unsigned int nb_bits;
+};
+
+static TestBits code(SYMBOL_NAME_CODES::ENUM e) {
+	return TestBits{ static_cast<unsigned int>(e), SYMBOL_NAME_CODES::BIT_WIDTH };
+}
+
+static void test_decode(std::vector<TestBits> input_bits, const char * expected) {
+	OutputBitStream output;
+	for (const TestBits & bits : input_bits) {
+		output.appendBits(bits.value, bits.nb_bits);
+	}
+	const PackedBits packed = output.release();
+	InputBitStream fast(packed.data.data(), packed.sizeInBits);
+	assert(Decoder::decodeNextSymbolName(fast) == expected);
+	assert(fast.isEmpty());
+	InputBitStream bulk(packed.data.data(), packed.sizeInBits);
+	assert(Decoder::decodeNextSymbolNameBulk(bulk) == expected);
+	assert(bulk.isEmpty());
+	InputBitStream reference(packed.data.data(), packed.sizeInBits);
+	assert(Decoder::decodeNextSymbolNameCodeByCode(reference) == expected);
+	assert(reference.isEmpty());
+
+	const size_t expected_length = std::strlen(expected);
+	char buffer[128];
+	InputBitStream into_buffer(packed.data.data(), packed.sizeInBits);
+	assert(Decoder::decodeNextSymbolName(into_buffer, buffer, expected_length) == expected_length);
+	assert(std::memcmp(buffer, expected, expected_length) == 0);
+	assert(into_buffer.isEmpty());
+	if (expected_length > 0) {
+		InputBitStream too_long(packed.data.data(), packed.sizeInBits);
+		bool thrown = false;
+		try {
+			Decoder::decodeNextSymbolName(too_long, buffer, expected_length - 1);
+		} catch (const std::logic_error &) {
+			thrown = true;
+		}
+		assert(thrown);
+	}
+}
+
+void test_Decoder() {
+	using C = SYMBOL_NAME_CODES;
+	const DecodingTableEntry * table = decoding_table();
+	// window starting with the given codes, completed with CASE_INVERSE_ONCE codes
+	auto window = [](std::vector<unsigned int> codes) {
+		unsigned int value = 0;
+		for (unsigned int i = 0; i < SYMBOLS_PER_WINDOW; ++i) {
+			value = (value << C::BIT_WIDTH) | (i < codes.size() ? codes[i] : static_cast<unsigned int>(C::CASE_INVERSE_ONCE));
+		}
+		return value;
+	};
+	const DecodingTableEntry & ab = table[window({ C::LETTER_A, C::LETTER_B })];
+	assert(ab.nbSymbols == 2);
+	assert(ab.text[BitStream::CASE_LOWER][0] == 'a');
+	assert(ab.text[BitStream::CASE_UPPER][1] == 'B');
+	const DecodingTableEntry & underscore = table[window({ C::UNDERSCORE })];
+	assert(underscore.nbSymbols == 1);
+	assert(underscore.text[BitStream::CASE_UPPER][0] == '_');
+	assert(table[window({ C::DIGITS_2BITS, C::LETTER_A })].nbSymbols == 0);
+	assert(table[window({ C::CASE_INVERSE_PERMANENT, C::LETTER_A })].nbSymbols == 0);
+
+	test_decode({}, "");
+	test_decode({ code(C::LETTER_A) }, "a");
+	test_decode({ code(C::LETTER_A), code(C::LETTER_B), code(C::LETTER_Z) }, "abz");
+	test_decode({ code(C::CASE_INVERSE_ONCE), code(C::LETTER_A), code(C::LETTER_B) }, "Ab");
+	test_decode({ code(C::CASE_INVERSE_PERMANENT), code(C::LETTER_A), code(C::LETTER_B), code(C::UNDERSCORE),
+		code(C::CASE_INVERSE_ONCE), code(C::LETTER_D), code(C::LETTER_E) }, "AB_dE");
+	test_decode({ code(C::LETTER_A), code(C::DIGITS_2BITS), { 1, 2 }, code(C::LETTER_B) }, "a1b");
+	test_decode({ code(C::LETTER_H), code(C::LETTER_E), code(C::LETTER_L), code(C::LETTER_L), code(C::LETTER_O),
+		code(C::UNDERSCORE), code(C::LETTER_W), code(C::LETTER_O), code(C::LETTER_R), code(C::LETTER_L), code(C::LETTER_D) }, "hello_world");
+	test_decode({ code(C::DIGITS_6BITS), { 30, 6 }, code(C::DIGITS_10BITS), { 0, 10 }, code(C::LETTER_X) }, "3468x");
+	test_decode({ code(C::DIGITS_2BITS), { 0, 2 }, code(C::DIGITS_10BITS), { 1023, 10 } }, "01091");
+
+	// long enough to flush the literal buffer of the table-driven decoder
+	std::vector<TestBits> long_name;
+	std::string long_expected;
+	for (int i = 0; i < 100; ++i) {
+		long_name.push_back(code(static_cast<C::ENUM>(C::LETTER_A + i % 26)));
+		long_expected += static_cast<char>('a' + i % 26);
+	}
+	test_decode(long_name, long_expected.c_str());
+
+	// interleaved: the streams don't share their case state and end at different times
+	std::string long_camel_case;
+	for (int i = 0; i < 100; ++i) {
+		long_camel_case += (i % 3 == 0) ? "Abc" : "DEF_g";
+	}
+	const std::vector<std::string> interleaved_names = { "aClass", "AB_dE", "x", "uint64_t", "MAX_SIZE", "a0b03c4d67e68f1091", "Z", "_",
+		long_camel_case, "hello_world", "aB", "Ab2" };
+	const unsigned int nb_interleaved_names = static_cast<unsigned int>(interleaved_names.size());
+	OutputBitStream interleaved_output[NB_INTERLEAVED_STREAMS];
+	for (unsigned int i = 0; i < nb_interleaved_names; ++i) {
+		Encoder::encodeInterleavedSymbolName(interleaved_output, i, string_view(interleaved_names[i].c_str()));
+	}
+	std::vector<InputBitStream> interleaved_input;
+	InputBitStream * interleaved_streams[NB_INTERLEAVED_STREAMS];
+	for (unsigned int i = 0; i < NB_INTERLEAVED_STREAMS; ++i) {
+		interleaved_input.push_back(InputBitStream(interleaved_output[i].release()));
+	}
+	for (unsigned int i = 0; i < NB_INTERLEAVED_STREAMS; ++i) {
+		interleaved_streams[i] = &interleaved_input[i];
+	}
+	SymbolTable decoded_names[NB_INTERLEAVED_STREAMS];
+	Decoder::decodeInterleavedSymbolNames(interleaved_streams, decoded_names);
+	for (unsigned int i = 0; i < nb_interleaved_names; ++i) {
+		assert(decoded_names[i % NB_INTERLEAVED_STREAMS].name(i / NB_INTERLEAVED_STREAMS) == string_view(interleaved_names[i].c_str()));
+	}
+	assert(decoded_names[0].size() == 3 && decoded_names[3].size() == 3);
+	for (const InputBitStream & stream : interleaved_input) {
+		assert(stream.isEmpty());
+	}
+
+	// skipped blocks end where the decoded ones do
+	const std::string binary("\x01\xFF\x80", 3);
+	const Block blocks[] = {
+		{ "aClass", NEW_SYMBOL_NAME_GLOBAL_SCOPE }, { "x2", NEW_SYMBOL_NAME_LOCAL_SCOPE }, { "1091", ENCODED_NUMBER },
+		{ "   ", SEPARATOR }, { "\t \t", INDENT_BLOCK }, { "\r\n", NEW_LINE }, { "\n", NEW_LINE }, { "{(*", SPECIAL_CHAR_BLOCK },
+		{ "// Returns the size.", COMMENT_BLOCK }, { "\"\\x01\"", STRING_BLOCK },
+		{ string_view(binary.data(), static_cast<int>(binary.size())), UNDETERMINED_BLOCK },
+	};
+	OutputBitStream blocks_output;
+	std::string blocks_text;
+	for (const Block & block : blocks) {
+		Encoder::encodeBlock(blocks_output, block);
+		blocks_text.append(block.text.data(), block.text.length());
+	}
+	const PackedBits blocks_bits = blocks_output.release();
+	InputBitStream decoded_blocks(blocks_bits.data.data(), blocks_bits.sizeInBits);
+	InputBitStream skipped_blocks(blocks_bits.data.data(), blocks_bits.sizeInBits);
+	std::string decoded_text;
+	for (const Block & block : blocks) {
+		const BLOCK_TYPE decoded_type = Decoder::decodeNextBlock(decoded_blocks, decoded_text);
+		const BLOCK_TYPE skipped_type = Decoder::decodeBlockType(skipped_blocks);
+		assert(decoded_type == block.type && skipped_type == block.type);
+		Decoder::skipBlockPayload(skipped_blocks, skipped_type);
+		assert(skipped_blocks.currentBit() == decoded_blocks.currentBit());
+	}
+	assert(decoded_text == blocks_text);
+	assert(skipped_blocks.isEmpty());
+}
@@ -1,10 +1,44 @@
 #pragma once
 
+#include "EncodingTables.h"
+
 #include <string>
 
 //class string_view;
 class InputBitStream;
+class SymbolTable;
 
 namespace Decoder {
+	// Table-driven: decodes several letters per step.
 	std::string decodeNextSymbolName(InputBitStream & stream);
-};
\ No newline at end of file
+	// Same without allocating: decodes into the capacity chars of buffer and returns the length of
+	// the symbol name. Throws if it doesn't fit.
+	size_t decodeNextSymbolName(InputBitStream & stream, char * buffer, size_t capacity);
+	// Appends exactly length characters to str (for symbol names that don't span the whole stream).
+	// Fixed-width codes of streams in memory are unpacked in bulk, see decodeNextSymbolNameBulk().
+	void decodeSymbolName(InputBitStream & stream, unsigned int length, std::string & str);
+	// Same without storing the characters: moves the stream (and its current case) past the name.
+	void skipSymbolName(InputBitStream & stream, unsigned int length);
+	// Unpacks runs of codes in bulk (see SymbolCodeUnpacker) before decoding them.
+	std::string decodeNextSymbolNameBulk(InputBitStream & stream);
+	// Reference implementation, decodes one code at a time.
+	std::string decodeNextSymbolNameCodeByCode(InputBitStream & stream);
+
+	// Appends the text of the next block (see Encoder::encodeBlock()) to output.
+	// SYMBOL_NAME_REFERENCE_* blocks are not supported: see decodeBlockPayload().
+	BLOCK_TYPE decodeNextBlock(InputBitStream & stream, std::string & output);
+	BLOCK_TYPE decodeBlockType(InputBitStream & stream);
+	void decodeBlockPayload(InputBitStream & stream, BLOCK_TYPE type, std::string & output);
+	// Same without decoding the text: moves the stream past the payload.
+	void skipBlockPayload(InputBitStream & stream, BLOCK_TYPE type);
+	// Decodes all the symbol names of the streams written by Encoder::encodeInterleavedSymbolName(),
+	// with fixed width codes, adding the ones of streams[i] to names[i]: the index-th name of the
+	// sequence is names[index % NB_INTERLEAVED_STREAMS].name(index / NB_INTERLEAVED_STREAMS).
+	// The streams are advanced in the same loop, a step each in turn, so that their independent
+	// dependency chains overlap on out-of-order cores. The streams must not pull from a source.
+	void decodeInterleavedSymbolNames(InputBitStream * const streams[NB_INTERLEAVED_STREAMS], SymbolTable names[NB_INTERLEAVED_STREAMS]);
+	// Payload of a SYMBOL_NAME_REFERENCE_* block.
+	unsigned int decodeSymbolReference(InputBitStream & stream, unsigned int nb_names);
+};
+
+void test_Decoder();
@@ -1,6 +1,11 @@
 #include "Encoder.h"
 
 #include "BitStream.h"
+#include "Tokenizer.h"
+#include "SymbolDictionary.h"
+#include "CharClassifier.h"
+#include "TextCodec.h"
+#include "Keywords.h"
 
 #include "string_view.h"
 #include <iostream>
@@ -8,16 +13,63 @@
 #include <cassert>
 #include <cctype>
 
-static int count_nb_digits(const string_view & str, int start_pos) {
-	int nb_digits = 0;
-	for (int i = start_pos; i < str.length(); ++i) {
-		if (std::isdigit(str[i])) {
-			nb_digits += 1;
-		} else {
-			break;
+// Character classes of a string, classified CharClassifier::BLOCK_SIZE chars at a time when first needed.
+class CharClassScanner {
+public:
+	enum CHAR_CLASS { LOWER, UPPER, DIGIT, UNDERSCORE, OTHER };
+
+	explicit CharClassScanner(string_view str) : m_str(str) {
+	}
+
+	CHAR_CLASS classAt(int pos) {
+		const uint32_t bit = 1u << load(pos);
+		if (m_masks.lower & bit)
+			return LOWER;
+		if (m_masks.upper & bit)
+			return UPPER;
+		if (m_masks.digit & bit)
+			return DIGIT;
+		if (m_masks.underscore & bit)
+			return UNDERSCORE;
+		return OTHER;
+	}
+
+	// Number of consecutive chars of the class of mask from pos.
+	int runLength(int pos, uint32_t CharClassMasks::* mask) {
+		int length = 0;
+		while (pos + length < m_str.length()) {
+			const int offset = load(pos + length);
+			// the bits shifted in past the block end stop the run
+			const uint32_t others = ~(m_masks.*mask >> offset);
+			const int run = (others == 0) ? CharClassifier::BLOCK_SIZE : count_trailing_zeros(others);
+			length += run;
+			if (offset + run < CharClassifier::BLOCK_SIZE)
+				break;
+		}
+		return length;
+	}
+
+private:
+	// Makes sure the classified block holds pos and returns the offset of pos in it.
+	int load(int pos) {
+		assert(pos < m_str.length());
+		if (pos < m_block_start || pos >= m_block_start + CharClassifier::BLOCK_SIZE) {
+			m_block_start = pos;
+			m_masks = CharClassifier::classify(m_str.data() + pos, std::min(CharClassifier::BLOCK_SIZE, m_str.length() - pos));
 		}
+		return pos - m_block_start;
 	}
-	return nb_digits;
+
+	string_view m_str;
+	int m_block_start = -CharClassifier::BLOCK_SIZE;
+	CharClassMasks m_masks = {};
+};
+
+static int count_nb_digits(const string_view & str, int start_pos) {
+	if (start_pos >= str.length())
+		return 0;
+	CharClassScanner scanner(str);
+	return scanner.runLength(start_pos, &CharClassMasks::digit);
 }
 
 static int extract_4_digits_number(string_view str) {
@@ -39,18 +91,50 @@ static int extract_4_digits_number(string_view str) {
 	return number;
 }
 
-static bool is_case_valid_for_next_letter(string_view str, int index, BitStream::CASE_KIND case_kind) {
-	assert(index < str.length());
-	for (int i = index + 1; i < str.length(); ++i) {
-		char c = str[i];
-		if (std::isalpha(c)) {
-			if (case_kind == BitStream::CASE_LOWER && std::isupper(c))
-				return false;
-			if (case_kind == BitStream::CASE_UPPER && std::islower(c))
-				return false;
+// Index of the last upper and lower case letters of the string (-1 if none), found by a single
+// backward scan the first time a case change has to be encoded: the current case stays valid after
+// a letter of the other case when no other letter of that case follows it in the rest of the string.
+class CaseRuns {
+public:
+	explicit CaseRuns(string_view str) : m_str(str) {
+	}
+
+	bool isCaseValidAfter(int index, BitStream::CASE_KIND case_kind) {
+		assert(index < m_str.length());
+		if (m_last_upper == NOT_COMPUTED) {
+			compute();
 		}
+		return (case_kind == BitStream::CASE_LOWER) ? (m_last_upper <= index) : (m_last_lower <= index);
+	}
+
+private:
+	static const int NOT_COMPUTED = -2;
+
+	void compute() {
+		m_last_upper = -1;
+		m_last_lower = -1;
+		for (int i = m_str.length() - 1; i >= 0 && (m_last_upper < 0 || m_last_lower < 0); --i) {
+			const char c = m_str[i];
+			if (m_last_upper < 0 && c >= 'A' && c <= 'Z') {
+				m_last_upper = i;
+			} else if (m_last_lower < 0 && c >= 'a' && c <= 'z') {
+				m_last_lower = i;
+			}
+		}
+	}
+
+	string_view m_str;
+	int m_last_upper = NOT_COMPUTED;
+	int m_last_lower = NOT_COMPUTED;
+};
+
+static void handle_current_case_mismatch(OutputBitStream & stream, CaseRuns & case_runs, int index) {
+	if (case_runs.isCaseValidAfter(index, stream.currentCase())) {
+		stream.appendSymbolCode(SYMBOL_NAME_CODES::CASE_INVERSE_ONCE);
+	} else {
+		stream.appendSymbolCode(SYMBOL_NAME_CODES::CASE_INVERSE_PERMANENT);
+		stream.invertCurrentCase();
 	}
-	return true;
 }
 
 namespace Encoder {
@@ -60,7 +144,7 @@ namespace Encoder {
 		int number = extract_4_digits_number(str);
 
 		if (number <= 3) {
-			stream.appendBits(SYMBOL_NAME_CODES::DIGITS_2BITS, SYMBOL_NAME_CODES::BIT_WIDTH);
+			stream.appendSymbolCode(SYMBOL_NAME_CODES::DIGITS_2BITS);
 			stream.appendBits(number, 2);
 			// take care of leading zeros
 			if (number == 0 && str.length() > 1) {
@@ -68,10 +152,10 @@ namespace Encoder {
 				return encodeNumber(stream, str);
 			}
 		} else if (number <= 67) {
-			stream.appendBits(SYMBOL_NAME_CODES::DIGITS_6BITS, SYMBOL_NAME_CODES::BIT_WIDTH);
+			stream.appendSymbolCode(SYMBOL_NAME_CODES::DIGITS_6BITS);
 			stream.appendBits(number - 4, 6);
 		} else if (number <= 1091) {
-			stream.appendBits(SYMBOL_NAME_CODES::DIGITS_10BITS, SYMBOL_NAME_CODES::BIT_WIDTH);
+			stream.appendSymbolCode(SYMBOL_NAME_CODES::DIGITS_10BITS);
 			stream.appendBits(number - 68, 10);
 			if (str.length() > 4) {
 				str.remove_prefix(4);
@@ -83,7 +167,7 @@ namespace Encoder {
 				(str[0] - '0') * 100 +
 				(str[1] - '0') * 10 +
 				(str[2] - '0') * 1;
-			stream.appendBits(SYMBOL_NAME_CODES::DIGITS_10BITS, SYMBOL_NAME_CODES::BIT_WIDTH);
+			stream.appendSymbolCode(SYMBOL_NAME_CODES::DIGITS_10BITS);
 			stream.appendBits(number - 68, 10);
 			str.remove_prefix(3);
 			return encodeNumber(stream, str);
@@ -91,49 +175,117 @@ namespace Encoder {
 	}
 
 	void handleCurrentCaseMismatch(OutputBitStream & stream, string_view str, int index) {
-		if (is_case_valid_for_next_letter(str, index, stream.currentCase())) {
-			stream.appendBits(SYMBOL_NAME_CODES::CASE_INVERSE_ONCE, SYMBOL_NAME_CODES::BIT_WIDTH);
-		} else {
-			stream.appendBits(SYMBOL_NAME_CODES::CASE_INVERSE_PERMANENT, SYMBOL_NAME_CODES::BIT_WIDTH);
-			stream.invertCurrentCase();
-		}
+		CaseRuns case_runs(str);
+		handle_current_case_mismatch(stream, case_runs, index);
 	}
 
+	// Letters, digits and underscores are handled by runs found with CharClassifier masks.
 	void encodeNextSymbolName(OutputBitStream & stream, string_view & str) {
-		for (int i = 0; i < str.length(); ++i) {
-			char c = str[i];
-			if (unlikely(std::isdigit(c))) {
-				int nb_digits = count_nb_digits(str, i);
-				assert(nb_digits > 0);
-
+		CaseRuns case_runs(str);
+		CharClassScanner scanner(str);
+		int i = 0;
+		while (i < str.length()) {
+			const CharClassScanner::CHAR_CLASS char_class = scanner.classAt(i);
+			if (likely(char_class == CharClassScanner::LOWER || char_class == CharClassScanner::UPPER)) {
+				const bool lower = (char_class == CharClassScanner::LOWER);
+				if (stream.currentCase() != (lower ? BitStream::CASE_LOWER : BitStream::CASE_UPPER)) {
+					handle_current_case_mismatch(stream, case_runs, i);
+				}
+				// after a CASE_INVERSE_ONCE, only the next letter is in the current case
+				const int run_length = (stream.currentCase() == (lower ? BitStream::CASE_LOWER : BitStream::CASE_UPPER)) ?
+					scanner.runLength(i, lower ? &CharClassMasks::lower : &CharClassMasks::upper) : 1;
+				const char first_letter = lower ? 'a' : 'A';
+				for (int end = i + run_length; i < end; ++i) {
+					stream.appendSymbolCode(static_cast<SYMBOL_NAME_CODES::ENUM>(SYMBOL_NAME_CODES::LETTER_A + (str[i] - first_letter)));
+				}
+			} else if (char_class == CharClassScanner::UNDERSCORE) {
+				for (int end = i + scanner.runLength(i, &CharClassMasks::underscore); i < end; ++i) {
+					stream.appendSymbolCode(SYMBOL_NAME_CODES::UNDERSCORE);
+				}
+			} else if (char_class == CharClassScanner::DIGIT) {
+				const int nb_digits = scanner.runLength(i, &CharClassMasks::digit);
 				encodeNumber(stream, string_view(str, i, nb_digits));
-				i += (nb_digits - 1);
-				assert(i < str.length());
+				i += nb_digits;
 			} else {
-				unsigned int code;
-
-				if (likely(std::islower(c))) {
-					if (stream.currentCase() != BitStream::CASE_LOWER) {
-						handleCurrentCaseMismatch(stream, str, i);
-					}
-					code = SYMBOL_NAME_CODES::LETTER_A + (c - 'a');
-				} else if (std::isupper(c)) {
-					if (stream.currentCase() != BitStream::CASE_UPPER) {
-						handleCurrentCaseMismatch(stream, str, i);
-					}
-					code = SYMBOL_NAME_CODES::LETTER_A + (c - 'A');
-				} else if (c == '_') {
-					code = SYMBOL_NAME_CODES::UNDERSCORE;
-				} else {
-					str.remove_prefix(i);
-					return;
-				}
-
-				stream.appendBits(code, SYMBOL_NAME_CODES::BIT_WIDTH);
+				str.remove_prefix(i);
+				return;
 			}
 		}
 		str.clear();
 	}
+
+	void encodeBlock(OutputBitStream & stream, const Block & block) {
+		const string_view & text = block.text;
+		assert(!text.empty());
+		stream.appendBits(block.type, BLOCK_TYPE_BIT_WIDTH);
+
+		switch (block.type) {
+		case NEW_SYMBOL_NAME_LOCAL_SCOPE:
+		case NEW_SYMBOL_NAME_GLOBAL_SCOPE:
+		case ENCODED_NUMBER: {
+			// the length tells the decoder where the symbol name ends
+			stream.appendVarUInt(text.length() - 1);
+			string_view str = text;
+			encodeNextSymbolName(stream, str);
+			if (!str.empty())
+				throw make_logic_error("Invalid symbol name!");
+			break;
+		}
+		case SEPARATOR:
+			stream.appendVarUInt(text.length() - 1);
+			break;
+		case INDENT_BLOCK:
+			stream.appendVarUInt(text.length() - 1);
+			for (int i = 0; i < text.length(); ++i) {
+				stream.appendBits(text[i] == '\t' ? 1 : 0, 1);
+			}
+			break;
+		case NEW_LINE:
+			stream.appendBits(text.length() == 2 ? 1 : 0, 1);
+			break;
+		case SPECIAL_CHAR_BLOCK:
+			// 7-bit ASCII
+			stream.appendVarUInt(text.length() - 1);
+			for (int i = 0; i < text.length(); ++i) {
+				stream.appendBits(static_cast<unsigned char>(text[i]), 7);
+			}
+			break;
+		case COMMENT_BLOCK:
+		case STRING_BLOCK:
+			stream.appendVarUInt(text.length() - 1);
+			TextCodec::encode(stream, text);
+			break;
+		case UNDETERMINED_BLOCK:
+			stream.appendVarUInt(text.length() - 1);
+			for (int i = 0; i < text.length(); ++i) {
+				stream.appendBits(static_cast<unsigned char>(text[i]), 8);
+			}
+			break;
+		default:
+			throw make_logic_error("Unsupported block type!");
+		}
+	}
+
+	void encodeSymbolReference(OutputBitStream & stream, BLOCK_TYPE type, unsigned int id, unsigned int nb_names) {
+		assert(type == SYMBOL_NAME_REFERENCE_LOCAL || type == SYMBOL_NAME_REFERENCE_GLOBAL || type == SYMBOL_NAME_REFERENCE_SHARED);
+		assert(id < nb_names);
+		stream.appendBits(type, BLOCK_TYPE_BIT_WIDTH);
+		stream.appendBits(id, symbol_id_bit_width(nb_names));
+	}
+
+	void encodeKeyword(OutputBitStream & stream, unsigned int keyword) {
+		assert(keyword < Keywords::NB_KEYWORDS);
+		stream.appendBits(KEYWORD, BLOCK_TYPE_BIT_WIDTH);
+		stream.appendBits(keyword, Keywords::BIT_WIDTH);
+	}
+
+	void encodeInterleavedSymbolName(OutputBitStream streams[NB_INTERLEAVED_STREAMS], unsigned int index, string_view name) {
+		OutputBitStream & stream = streams[index % NB_INTERLEAVED_STREAMS];
+		stream.appendVarUInt(name.length() - 1);
+		encodeNextSymbolName(stream, name);
+		if (!name.empty())
+			throw make_logic_error("Invalid symbol name!");
+	}
 }
 
 // ----------------------------------------------------------------
@@ -196,6 +348,50 @@ static void test_leading_zero_is_well_encoded() {
 	test_encode_number("200001", quick_encode(200, SYMBOL_NAME_CODES::DIGITS_10BITS) + quick_encode(0, SYMBOL_NAME_CODES::DIGITS_2BITS) + quick_encode(0, SYMBOL_NAME_CODES::DIGITS_2BITS) + quick_encode(1, SYMBOL_NAME_CODES::DIGITS_2BITS));
 }
 
+// The former lookahead, rescanning the rest of the string at each case change.
+static bool is_case_valid_for_next_letter(string_view str, int index, BitStream::CASE_KIND case_kind) {
+	for (int i = index + 1; i < str.length(); ++i) {
+		char c = str[i];
+		if (std::isalpha(c)) {
+			if (case_kind == BitStream::CASE_LOWER && std::isupper(c))
+				return false;
+			if (case_kind == BitStream::CASE_UPPER && std::islower(c))
+				return false;
+		}
+	}
+	return true;
+}
+
+static void test_case_runs_match_lookahead() {
+	const char alphabet[] = "aZbY_09 +";
+	unsigned int seed = 1;
+	for (int n = 0; n < 2000; ++n) {
+		std::string text;
+		const int length = 1 + n % 24;
+		for (int i = 0; i < length; ++i) {
+			seed = seed * 1103515245 + 12345;
+			text += alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+		}
+		const string_view str(text.data(), length);
+		CaseRuns case_runs(str);
+		for (int i = 0; i < length; ++i) {
+			for (auto case_kind : { BitStream::CASE_LOWER, BitStream::CASE_UPPER }) {
+				assert(case_runs.isCaseValidAfter(i, case_kind) == is_case_valid_for_next_letter(str, i, case_kind));
+			}
+		}
+	}
+}
+
+static void test_encode_block() {
+	OutputBitStream stream;
+	Encoder::encodeBlock(stream, Block{ "\r\n", NEW_LINE });
+	assert(stream.toString() == "1011" "1");
+	Encoder::encodeBlock(stream, Block{ "   ", SEPARATOR });
+	assert(stream.toString() == "1011" "1" "0101" "00010");
+	Encoder::encodeBlock(stream, Block{ "b", NEW_SYMBOL_NAME_GLOBAL_SCOPE });
+	assert(stream.toString() == "1011" "1" "0101" "00010" "0001" "00000" + to_string(SYMBOL_NAME_CODES::LETTER_B));
+}
+
 void test_Encoder() {
 	assert(count_nb_digits("", 0) == 0);
 	assert(count_nb_digits("1", 0) == 1);
@@ -239,4 +435,6 @@ void test_Encoder() {
 
 	test_deserialize_encoding();
 	test_leading_zero_is_well_encoded();
+	test_encode_block();
+	test_case_runs_match_lookahead();
 }
\ No newline at end of file
@@ -1,12 +1,24 @@
 #pragma once
 
+#include "EncodingTables.h"
+
 class string_view;
 class OutputBitStream;
+struct Block;
 
 namespace Encoder {
 	void encodeNumber(OutputBitStream & stream, string_view str);
 	void handleCurrentCaseMismatch(OutputBitStream & stream, string_view str, int index);
 	void encodeNextSymbolName(OutputBitStream & stream, string_view & str);
+	// Block type followed by its payload (see Tokenizer).
+	void encodeBlock(OutputBitStream & stream, const Block & block);
+	// SYMBOL_NAME_REFERENCE_* block: the id of a symbol name from a dictionary of nb_names names.
+	void encodeSymbolReference(OutputBitStream & stream, BLOCK_TYPE type, unsigned int id, unsigned int nb_names);
+	// KEYWORD block: the index of a keyword (see Keywords).
+	void encodeKeyword(OutputBitStream & stream, unsigned int keyword);
+	// The index-th symbol name of a sequence goes to streams[index % NB_INTERLEAVED_STREAMS]: its length
+	// (minus one, as a VarUInt) and its codes, so that the streams can be decoded independently.
+	void encodeInterleavedSymbolName(OutputBitStream streams[NB_INTERLEAVED_STREAMS], unsigned int index, string_view name);
 }
 
 void test_Encoder();
@@ -40,3 +40,29 @@ struct SYMBOL_NAME_CODES {
 	};
 };
 
+// Type of the blocks a source file is split into (see Tokenizer).
+// 4 bits (16 values)
+static const int BLOCK_TYPE_BIT_WIDTH = 4;
+enum BLOCK_TYPE {
+	NEW_SYMBOL_NAME_LOCAL_SCOPE,
+	NEW_SYMBOL_NAME_GLOBAL_SCOPE,
+	SYMBOL_NAME_REFERENCE_LOCAL,
+	SYMBOL_NAME_REFERENCE_GLOBAL,
+
+	COMMENT_BLOCK,        // "// ..." up to the end of line, or "/* ... */"
+	SEPARATOR,            // run of spaces
+	ENCODED_NUMBER,       // digit followed by letters, digits and underscores
+	STRING_BLOCK,         // "..." or '...' literal
+	SPECIAL_CHAR_BLOCK,   // run of punctuation and tabs
+	//REPEATER,
+	UNDETERMINED_BLOCK,   // anything else (control chars, non-ASCII)
+
+	INDENT_BLOCK,         // spaces and tabs at the beginning of a line
+	NEW_LINE,             // "\n" or "\r\n" (in Compressor streams, also the next empty lines and indentation: see IndentModel)
+	KEYWORD,              // C++ keyword or common identifier (see Keywords)
+	SYMBOL_NAME_REFERENCE_SHARED, // id of a symbol name in the SharedDictionary of the stream
+};
+
+// Number of streams consecutive symbol names are dealt to, round-robin, to be decoded together
+// (see Encoder::encodeInterleavedSymbolName()).
+static const unsigned int NB_INTERLEAVED_STREAMS = 4;
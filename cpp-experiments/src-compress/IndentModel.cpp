@@ -0,0 +1,179 @@
+#include "IndentModel.h"
+
+#include "BitStream.h"
+#include "string_view.h"
+
+#include <cassert>
+#include <vector>
+
+IndentModel::INDENT_KIND IndentModel::kindOf(string_view indent) {
+	if (indent.empty())
+		return INDENT_NONE;
+	bool has_tabs = false;
+	bool has_spaces = false;
+	for (int i = 0; i < indent.length(); ++i) {
+		assert(indent[i] == '\t' || indent[i] == ' ');
+		has_tabs |= (indent[i] == '\t');
+		has_spaces |= (indent[i] == ' ');
+	}
+	return has_tabs ? (has_spaces ? INDENT_MIXED : INDENT_TABS) : INDENT_SPACES;
+}
+
+unsigned int IndentModel::stepLength(int delta) const {
+	if (m_kind == INDENT_MIXED)
+		return 0;
+	const unsigned int step = (stepChar() == ' ') ? m_space_step : 1;
+	const unsigned int length = static_cast<unsigned int>(m_indent.length());
+	if (delta > 0)
+		return length + step;
+	return (length > step) ? length - step : 0;
+}
+
+void IndentModel::setIndent(string_view indent) {
+	const INDENT_KIND kind = kindOf(indent);
+	if (kind == INDENT_SPACES && m_kind == INDENT_SPACES) {
+		const unsigned int length = static_cast<unsigned int>(m_indent.length());
+		const unsigned int new_length = static_cast<unsigned int>(indent.length());
+		if (new_length != length) {
+			m_space_step = (new_length > length) ? new_length - length : length - new_length;
+		}
+	}
+	if (kind == INDENT_TABS || kind == INDENT_SPACES) {
+		m_last_kind = kind;
+	}
+	m_kind = kind;
+	m_indent.assign(indent.data(), indent.length());
+}
+
+void IndentModel::encodeNewLines(OutputBitStream & stream, bool crlf, unsigned int nb_empty_lines, string_view next_indent) {
+	stream.appendBits(crlf ? 1 : 0, 1);
+	if (nb_empty_lines == 0) {
+		stream.appendBits(0, 1);
+	} else {
+		stream.appendBits(1, 1);
+		stream.appendVarUInt(nb_empty_lines - 1);
+	}
+
+	const INDENT_KIND kind = kindOf(next_indent);
+	const unsigned int length = static_cast<unsigned int>(next_indent.length());
+	const bool is_step = (kind == INDENT_TABS || kind == INDENT_SPACES) && next_indent[0] == stepChar();
+	if (next_indent == string_view(m_indent.data(), static_cast<int>(m_indent.length()))) {
+		stream.appendBits(0b0, 1);
+	} else if (is_step && length == stepLength(1)) {
+		stream.appendBits(0b100, 3);
+	} else if (is_step && length == stepLength(-1)) {
+		stream.appendBits(0b101, 3);
+	} else if (kind == INDENT_NONE) {
+		stream.appendBits(0b110, 3);
+	} else {
+		stream.appendBits(0b111, 3);
+		if (kind == INDENT_MIXED) {
+			stream.appendBits(0, 1);
+			stream.appendVarUInt(length - 1);
+			for (int i = 0; i < next_indent.length(); ++i) {
+				stream.appendBits(next_indent[i] == '\t' ? 1 : 0, 1);
+			}
+		} else {
+			stream.appendBits(1, 1);
+			stream.appendBits(kind == INDENT_TABS ? 1 : 0, 1);
+			stream.appendVarUInt(length - 1);
+		}
+	}
+	setIndent(next_indent);
+}
+
+void IndentModel::decodeNewLines(InputBitStream & stream, std::string & output) {
+	const bool crlf = stream.readBits(1) != 0;
+	const unsigned int nb_new_lines = 1 + (stream.readBits(1) ? stream.readVarUInt() + 1 : 0);
+	if (crlf) {
+		for (unsigned int i = 0; i < nb_new_lines; ++i) {
+			output.append("\r\n", 2);
+		}
+	} else {
+		output.append(nb_new_lines, '\n');
+	}
+
+	if (stream.readBits(1) == 0) {
+		// same indentation
+		output.append(m_indent);
+		return;
+	}
+
+	const size_t indent_start = output.length();
+	const unsigned int code = stream.readBits(2);
+	switch (code) {
+	case 0b00:
+	case 0b01: {
+		const unsigned int length = stepLength(code == 0b00 ? 1 : -1);
+		if (length == 0)
+			throw make_logic_error("Invalid indentation step!");
+		output.append(length, stepChar());
+		break;
+	}
+	case 0b10:
+		break;
+	default:
+		if (stream.readBits(1)) {
+			const char c = stream.readBits(1) ? '\t' : ' ';
+			output.append(stream.readVarUInt() + 1, c);
+		} else {
+			const unsigned int length = stream.readVarUInt() + 1;
+			for (unsigned int i = 0; i < length; ++i) {
+				output += stream.readBits(1) ? '\t' : ' ';
+			}
+		}
+		break;
+	}
+	setIndent(string_view(output.data() + indent_start, static_cast<int>(output.length() - indent_start)));
+}
+
+// ----------------------------------------------------------------
+
+struct TestLine {
+	bool crlf;
+	unsigned int nb_empty_lines;
+	const char * next_indent;
+};
+
+static unsigned int test_lines(const std::vector<TestLine> & lines) {
+	IndentModel encoder;
+	OutputBitStream output;
+	std::string expected;
+	for (const TestLine & line : lines) {
+		encoder.encodeNewLines(output, line.crlf, line.nb_empty_lines, line.next_indent);
+		for (unsigned int i = 0; i <= line.nb_empty_lines; ++i) {
+			expected += line.crlf ? "\r\n" : "\n";
+		}
+		expected += line.next_indent;
+	}
+	const unsigned int size_in_bits = output.sizeInBits();
+
+	IndentModel decoder;
+	InputBitStream input(output.release());
+	std::string decoded;
+	for (size_t i = 0; i < lines.size(); ++i) {
+		decoder.decodeNewLines(input, decoded);
+	}
+	assert(decoded == expected);
+	assert(input.isEmpty());
+	return size_in_bits;
+}
+
+void test_IndentModel() {
+	// line end (1 bit), no empty line (1 bit), indentation
+	assert(test_lines({ { false, 0, "" } }) == 2 + 1);
+	assert(test_lines({ { false, 0, "\t" } }) == 2 + 3);
+	assert(test_lines({ { false, 0, "\t" }, { false, 0, "\t" }, { false, 0, "\t\t" }, { false, 0, "\t" }, { false, 0, "" } }) ==
+		(2 + 3) + (2 + 1) + (2 + 3) + (2 + 3) + (2 + 3));
+	assert(test_lines({ { true, 3, "" } }) == 2 + 5 + 1);
+
+	// the space step is learned from the indentations
+	assert(test_lines({ { false, 0, "  " }, { false, 0, "    " }, { false, 0, "      " }, { false, 0, "    " } }) ==
+		(2 + 3 + 2 + 5) + (2 + 3 + 2 + 5) + (2 + 3) + (2 + 3));
+	// steps from no indentation use the last kind
+	assert(test_lines({ { false, 0, "    " }, { false, 0, "" }, { false, 0, "    " } }) ==
+		(2 + 3 + 2 + 5) + (2 + 3) + (2 + 3));
+
+	test_lines({ { false, 0, "\t  " }, { true, 1, "\t  " }, { false, 0, "\t" }, { false, 20, " \t \t" }, { false, 0, "" },
+		{ false, 0, "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t" }, { true, 0, " " }, { false, 0, "" }, { false, 0, "" } });
+}
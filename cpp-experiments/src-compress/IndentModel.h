@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+
+class string_view;
+class OutputBitStream;
+class InputBitStream;
+
+// Line ends coded together with the empty lines that follow them and the indentation of the next
+// line, as the payload of the NEW_LINE blocks of a Compressor stream:
+//   1 bit: "\r\n" (else "\n")
+//   1 bit: followed by empty lines with the same line end, then their number - 1 (varuint)
+//   indentation of the next line (the INDENT_BLOCK that would follow), relative to the previous one:
+//     0           same as the previous indentation
+//     10 + 1 bit  one step more (0) or less (1): a tab, or the last difference seen between space indentations
+//     110         none
+//     111         explicit: 1 bit all tabs or all spaces, then
+//                   all tabs or spaces: 1 bit tabs, number of chars - 1 (varuint)
+//                   mixed: number of chars - 1 (varuint), 1 bit per char (tab or space)
+// The encoder and the decoder update the model in the same way.
+class IndentModel {
+public:
+	// next_indent: only tabs and spaces, empty if the next line has no indentation
+	void encodeNewLines(OutputBitStream & stream, bool crlf, unsigned int nb_empty_lines, string_view next_indent);
+	// Appends the line ends and the indentation, with one append per run of identical chars.
+	void decodeNewLines(InputBitStream & stream, std::string & output);
+
+	// Indentation of the first line (written as an INDENT_BLOCK).
+	void setIndent(string_view indent);
+
+private:
+	enum INDENT_KIND { INDENT_NONE, INDENT_TABS, INDENT_SPACES, INDENT_MIXED };
+	static INDENT_KIND kindOf(string_view indent);
+
+	// Length of the indentation one step deeper (delta 1) or shallower (delta -1), 0 if there is none.
+	unsigned int stepLength(int delta) const;
+	char stepChar() const {
+		return (m_kind == INDENT_SPACES || (m_kind == INDENT_NONE && m_last_kind == INDENT_SPACES)) ? ' ' : '\t';
+	}
+
+	std::string m_indent;
+	INDENT_KIND m_kind = INDENT_NONE;
+	// kind of the last indentation made of tabs or spaces only, used for the steps from no indentation
+	INDENT_KIND m_last_kind = INDENT_TABS;
+	unsigned int m_space_step = 4;
+};
+
+void test_IndentModel();
@@ -0,0 +1,31 @@
+#pragma once
+
+// Compile-time lists of indices, to expand a constexpr function over 0 to N - 1 into an
+// initializer list (C++11: no std::make_index_sequence).
+template<unsigned int... Is>
+struct IndexList {
+};
+
+template<typename A, typename B>
+struct ConcatIndexLists;
+
+template<unsigned int... A, unsigned int... B>
+struct ConcatIndexLists<IndexList<A...>, IndexList<B...>> {
+	typedef IndexList<A..., (sizeof...(A) + B)...> type;
+};
+
+// 0 to N - 1, built by halves to keep the template recursion shallow
+template<unsigned int N>
+struct MakeIndexList {
+	typedef typename ConcatIndexLists<typename MakeIndexList<N / 2>::type, typename MakeIndexList<N - N / 2>::type>::type type;
+};
+
+template<>
+struct MakeIndexList<0> {
+	typedef IndexList<> type;
+};
+
+template<>
+struct MakeIndexList<1> {
+	typedef IndexList<0> type;
+};
@@ -0,0 +1,154 @@
+#include "Keywords.h"
+#include "IndexList.h"
+#include "SymbolDictionary.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+// Changing the list requires a new multiplier (see KEYWORD_SLOT_MULTIPLIER) and a new Compressor::FORMAT_VERSION.
+static constexpr const char * KEYWORDS[Keywords::NB_KEYWORDS] = {
+	// C++ keywords
+	"alignas", "alignof", "and", "asm", "auto", "bool", "break", "case", "catch", "char", "char16_t", "char32_t",
+	"class", "const", "constexpr", "const_cast", "continue", "decltype", "default", "delete", "do", "double",
+	"dynamic_cast", "else", "enum", "explicit", "extern", "false", "float", "for", "friend", "goto", "if", "inline",
+	"int", "long", "mutable", "namespace", "new", "noexcept", "not", "nullptr", "operator", "or", "private",
+	"protected", "public", "reinterpret_cast", "return", "short", "signed", "sizeof", "static", "static_assert",
+	"static_cast", "struct", "switch", "template", "this", "thread_local", "throw", "true", "try", "typedef",
+	"typeid", "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while", "xor",
+	// preprocessor
+	"include", "define", "ifdef", "ifndef", "endif", "elif", "undef", "pragma", "defined",
+	// standard library
+	"std", "size_t", "ptrdiff_t", "string", "vector", "map", "set", "pair", "unique_ptr", "shared_ptr",
+	"make_shared", "make_unique", "move", "forward", "swap", "begin", "end", "size", "empty", "data", "value_type",
+	"size_type", "iterator", "const_iterator", "allocator", "uint8_t", "uint16_t", "uint32_t", "uint64_t", "int8_t",
+	"int16_t", "int32_t", "int64_t", "first", "second", "push_back", "emplace_back", "get", "reset", "npos",
+	"assert", "nullptr_t", "type", "override",
+};
+
+// The hash is the one of SymbolDictionary (FNV-1a), so that the encoder hashes each symbol name once.
+// Found by trying the odd multipliers in order until the keywords got distinct slots.
+static const uint32_t FNV_OFFSET_BASIS = 2166136261u;
+static const uint32_t KEYWORD_SLOT_MULTIPLIER = 21;
+static const unsigned int SLOT_BITS = 11;
+static const unsigned int NB_SLOTS = 1 << SLOT_BITS;
+static const unsigned int MIN_KEYWORD_LENGTH = 2;
+static const unsigned int MAX_KEYWORD_LENGTH = 16;
+
+// C++11 constexpr functions (a single return statement) so that the tables are built by the compiler.
+
+static constexpr uint32_t fnv1a(const char * str, uint32_t hash) {
+	return (*str == 0) ? hash : fnv1a(str + 1, (hash ^ static_cast<unsigned char>(*str)) * 16777619u);
+}
+
+static constexpr unsigned int slot_of_hash(uint32_t hash) {
+	return static_cast<uint32_t>(hash * KEYWORD_SLOT_MULTIPLIER) >> (32 - SLOT_BITS);
+}
+
+static constexpr unsigned int constexpr_strlen(const char * str) {
+	return (*str == 0) ? 0 : 1 + constexpr_strlen(str + 1);
+}
+
+template<typename Keywords>
+struct KeywordProperties;
+
+template<unsigned int... Keywords>
+struct KeywordProperties<IndexList<Keywords...>> {
+	static constexpr uint16_t slots[sizeof...(Keywords)] = { static_cast<uint16_t>(slot_of_hash(fnv1a(KEYWORDS[Keywords], FNV_OFFSET_BASIS)))... };
+	static constexpr unsigned char lengths[sizeof...(Keywords)] = { static_cast<unsigned char>(constexpr_strlen(KEYWORDS[Keywords]))... };
+};
+
+template<unsigned int... Keywords>
+constexpr uint16_t KeywordProperties<IndexList<Keywords...>>::slots[sizeof...(Keywords)];
+template<unsigned int... Keywords>
+constexpr unsigned char KeywordProperties<IndexList<Keywords...>>::lengths[sizeof...(Keywords)];
+
+typedef KeywordProperties<MakeIndexList<Keywords::NB_KEYWORDS>::type> KEYWORD_PROPERTIES;
+
+static constexpr unsigned int keyword_at_slot(unsigned int slot, unsigned int keyword) {
+	return (keyword == Keywords::NB_KEYWORDS || KEYWORD_PROPERTIES::slots[keyword] == slot) ?
+		keyword : keyword_at_slot(slot, keyword + 1);
+}
+
+template<typename Slots>
+struct SlotTable;
+
+template<unsigned int... Slots>
+struct SlotTable<IndexList<Slots...>> {
+	// keyword of each slot, Keywords::NOT_FOUND for the empty slots
+	static constexpr unsigned char keywords[sizeof...(Slots)] = { static_cast<unsigned char>(keyword_at_slot(Slots, 0))... };
+};
+
+template<unsigned int... Slots>
+constexpr unsigned char SlotTable<IndexList<Slots...>>::keywords[sizeof...(Slots)];
+
+typedef SlotTable<MakeIndexList<NB_SLOTS>::type> SLOT_TABLE;
+
+// The hash is perfect: each keyword is found in its own slot.
+static constexpr bool keywords_have_distinct_slots(unsigned int keyword) {
+	return keyword == Keywords::NB_KEYWORDS ||
+		(SLOT_TABLE::keywords[KEYWORD_PROPERTIES::slots[keyword]] == keyword && keywords_have_distinct_slots(keyword + 1));
+}
+
+static constexpr bool keyword_lengths_in_range(unsigned int keyword) {
+	return keyword == Keywords::NB_KEYWORDS ||
+		(KEYWORD_PROPERTIES::lengths[keyword] >= MIN_KEYWORD_LENGTH && KEYWORD_PROPERTIES::lengths[keyword] <= MAX_KEYWORD_LENGTH &&
+			keyword_lengths_in_range(keyword + 1));
+}
+
+static_assert(Keywords::NB_KEYWORDS == (1u << Keywords::BIT_WIDTH), "keywords are written on BIT_WIDTH bits");
+static_assert(keywords_have_distinct_slots(0), "KEYWORD_SLOT_MULTIPLIER doesn't give a perfect hash");
+static_assert(keyword_lengths_in_range(0), "keyword length out of range");
+
+namespace Keywords {
+	unsigned int find(string_view name) {
+		const unsigned int length = static_cast<unsigned int>(name.length());
+		if (length < MIN_KEYWORD_LENGTH || length > MAX_KEYWORD_LENGTH)
+			return NOT_FOUND;
+		return find(name, SymbolDictionary::hash(name));
+	}
+
+	unsigned int find(string_view name, uint32_t hash) {
+		const unsigned int length = static_cast<unsigned int>(name.length());
+		if (length < MIN_KEYWORD_LENGTH || length > MAX_KEYWORD_LENGTH)
+			return NOT_FOUND;
+		const unsigned int keyword = SLOT_TABLE::keywords[slot_of_hash(hash)];
+		if (keyword == NOT_FOUND || KEYWORD_PROPERTIES::lengths[keyword] != length ||
+			std::memcmp(KEYWORDS[keyword], name.data(), length) != 0)
+			return NOT_FOUND;
+		return keyword;
+	}
+
+	string_view name(unsigned int keyword) {
+		assert(keyword < NB_KEYWORDS);
+		return string_view(KEYWORDS[keyword], KEYWORD_PROPERTIES::lengths[keyword]);
+	}
+}
+
+// ----------------------------------------------------------------
+
+static_assert(fnv1a("", 1) == 1, "fnv1a");
+static_assert(constexpr_strlen("static_cast") == 11, "constexpr_strlen");
+static_assert(KEYWORD_PROPERTIES::lengths[0] == 7, "alignas");
+
+void test_Keywords() {
+	for (unsigned int keyword = 0; keyword < Keywords::NB_KEYWORDS; ++keyword) {
+		assert(Keywords::find(Keywords::name(keyword)) == keyword);
+		assert(SymbolDictionary::hash(Keywords::name(keyword)) == fnv1a(KEYWORDS[keyword], FNV_OFFSET_BASIS));
+		assert(Keywords::name(keyword) == string_view(KEYWORDS[keyword]));
+	}
+	assert(Keywords::name(Keywords::find("static_cast")) == string_view("static_cast"));
+	assert(Keywords::find("uint64_t") != Keywords::NOT_FOUND);
+
+	unsigned int nb_empty_slots = 0;
+	for (unsigned int slot = 0; slot < NB_SLOTS; ++slot) {
+		nb_empty_slots += (SLOT_TABLE::keywords[slot] == Keywords::NOT_FOUND) ? 1 : 0;
+	}
+	assert(nb_empty_slots == NB_SLOTS - Keywords::NB_KEYWORDS);
+
+	const char * not_keywords[] = { "", "i", "x", "Return", "returns", "retur", "static_casts", "aVeryLongIdentifierName", "INT", "std_" };
+	for (const char * name : not_keywords) {
+		assert(Keywords::find(name) == Keywords::NOT_FOUND);
+		assert(Keywords::find(name, SymbolDictionary::hash(name)) == Keywords::NOT_FOUND);
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "string_view.h"
+
+#include <cstdint>
+
+// C++ keywords, preprocessor directives and common standard library identifiers, written as a
+// KEYWORD block (their index on BIT_WIDTH bits) instead of a symbol name.
+// Lookup: a perfect hash of the name (SymbolDictionary::hash() times a fixed multiplier) gives the
+// only candidate, generated at compile time, and a single comparison confirms it.
+namespace Keywords {
+	static const unsigned int NB_KEYWORDS = 128;
+	static const unsigned int BIT_WIDTH = 7;
+	static const unsigned int NOT_FOUND = NB_KEYWORDS;
+
+	// Index of the keyword, NOT_FOUND if name is not a keyword.
+	unsigned int find(string_view name);
+	// Same with the SymbolDictionary::hash() of name, for the encoder to hash each name once.
+	unsigned int find(string_view name, uint32_t hash);
+	string_view name(unsigned int keyword);
+}
+
+void test_Keywords();
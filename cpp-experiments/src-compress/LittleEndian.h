@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Byte-oriented integers of the container formats (Archive, MappedArchive).
+
+inline void append_little_endian(std::string & output, uint64_t value, int nb_bytes) {
+	for (int i = 0; i < nb_bytes; ++i) {
+		output += static_cast<char>((value >> (8 * i)) & 0xFF);
+	}
+}
+
+inline uint64_t read_little_endian(const unsigned char * data, int nb_bytes) {
+	uint64_t value = 0;
+	for (int i = 0; i < nb_bytes; ++i) {
+		value |= static_cast<uint64_t>(data[i]) << (8 * i);
+	}
+	return value;
+}
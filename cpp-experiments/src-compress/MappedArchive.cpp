@@ -0,0 +1,407 @@
+#include "MappedArchive.h"
+
+#include "Compressor.h"
+#include "LittleEndian.h"
+#include "SharedDictionary.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+static const char MAPPED_ARCHIVE_MAGIC[4] = { 'S', 'R', 'C', 'M' };
+
+// byte-wise comparison, the order of the entries
+static int compare_paths(string_view lhs, string_view rhs) {
+	const int common_length = std::min(lhs.length(), rhs.length());
+	const int result = std::memcmp(lhs.data(), rhs.data(), common_length);
+	if (result != 0)
+		return result;
+	return lhs.length() - rhs.length();
+}
+
+// Files can be reused from a previous archive if the format of their stream is still the one written.
+static bool is_reusable(const MappedArchive & archive, size_t index) {
+	InputBitStream stream = archive.compressedStream(index);
+	return Compressor::hasFormat(stream, Compressor::DEFAULT_SYMBOL_CODING);
+}
+
+// The first bytes of a digest, to index them.
+static uint64_t digest_prefix(const Sha256::Digest & digest) {
+	return read_little_endian(digest.data(), 8);
+}
+
+// Compressed bits of a file, in a PackedBits or in place in the previous archive.
+struct CompressedFile {
+	const unsigned char * data;
+	size_t nb_bytes;
+	uint64_t size_in_bits;
+};
+
+std::string MappedArchive::build(const std::vector<SourceFile> & files, ThreadPool & pool, const SharedDictionary * dictionary) {
+	return build(nullptr, files, pool, dictionary, nullptr);
+}
+
+std::string MappedArchive::update(const MappedArchive & previous, const std::vector<SourceFile> & files, ThreadPool & pool,
+	const SharedDictionary * dictionary, size_t * nb_reused_files) {
+	return build(&previous, files, pool, dictionary, nb_reused_files);
+}
+
+std::string MappedArchive::build(const MappedArchive * previous, const std::vector<SourceFile> & files, ThreadPool & pool,
+	const SharedDictionary * dictionary, size_t * nb_reused_files) {
+	std::vector<const SourceFile *> sorted_files;
+	for (const SourceFile & file : files) {
+		sorted_files.push_back(&file);
+	}
+	std::sort(sorted_files.begin(), sorted_files.end(), [](const SourceFile * lhs, const SourceFile * rhs) {
+		return lhs->path < rhs->path;
+	});
+	for (size_t i = 1; i < sorted_files.size(); ++i) {
+		if (sorted_files[i - 1]->path == sorted_files[i]->path)
+			throw make_logic_error("Duplicated path in the archive!");
+	}
+
+	std::vector<Sha256::Digest> hashes(sorted_files.size());
+	pool.parallelFor(sorted_files.size(), [&sorted_files, &hashes](size_t i) {
+		hashes[i] = Sha256::hash(sorted_files[i]->content.data(), sorted_files[i]->content.size());
+	});
+
+	// the reusable files of the previous archive by content hash
+	std::unordered_map<uint64_t, size_t> previous_files;
+	if (previous != nullptr && previous->dictionaryId() == ((dictionary != nullptr) ? dictionary->id() : 0)) {
+		for (size_t i = 0; i < previous->nbFiles(); ++i) {
+			if (is_reusable(*previous, i)) {
+				previous_files.emplace(digest_prefix(previous->contentHash(i)), i);
+			}
+		}
+	}
+
+	std::vector<CompressedFile> compressed(sorted_files.size());
+	std::vector<size_t> to_compress;
+	for (size_t i = 0; i < sorted_files.size(); ++i) {
+		const auto found = previous_files.find(digest_prefix(hashes[i]));
+		if (found != previous_files.end() && previous->contentHash(found->second) == hashes[i] &&
+			previous->sourceLength(found->second) == sorted_files[i]->content.size()) {
+			uint64_t size_in_bits;
+			const unsigned char * data = previous->compressedData(found->second, size_in_bits);
+			compressed[i] = CompressedFile{ data, static_cast<size_t>((size_in_bits + 7) / 8), size_in_bits };
+		} else {
+			to_compress.push_back(i);
+		}
+	}
+	if (nb_reused_files != nullptr) {
+		*nb_reused_files = sorted_files.size() - to_compress.size();
+	}
+
+	std::vector<PackedBits> compressed_bits(to_compress.size());
+	pool.parallelFor(to_compress.size(), [&sorted_files, &to_compress, &compressed_bits, dictionary](size_t i) {
+		const std::string & content = sorted_files[to_compress[i]]->content;
+		compressed_bits[i] = Compressor::compress(string_view(content.data(), static_cast<int>(content.size())), Compressor::DEFAULT_SYMBOL_CODING, dictionary);
+	});
+	for (size_t i = 0; i < to_compress.size(); ++i) {
+		const PackedBits & bits = compressed_bits[i];
+		compressed[to_compress[i]] = CompressedFile{ bits.data.data(), bits.data.size(), bits.sizeInBits };
+	}
+
+	const size_t entries_offset = HEADER_SIZE;
+	const size_t paths_offset = entries_offset + sorted_files.size() * ENTRY_SIZE;
+	size_t data_offset = paths_offset;
+	for (const SourceFile * file : sorted_files) {
+		data_offset += file->path.size();
+	}
+
+	std::string archive(MAPPED_ARCHIVE_MAGIC, sizeof(MAPPED_ARCHIVE_MAGIC));
+	append_little_endian(archive, FORMAT_VERSION, 4);
+	append_little_endian(archive, sorted_files.size(), 4);
+	append_little_endian(archive, (dictionary != nullptr) ? dictionary->id() : 0, 4);
+	append_little_endian(archive, entries_offset, 8);
+	append_little_endian(archive, paths_offset, 8);
+	assert(archive.size() == HEADER_SIZE);
+
+	size_t path_offset = 0;
+	for (size_t i = 0; i < sorted_files.size(); ++i) {
+		append_little_endian(archive, path_offset, 8);
+		append_little_endian(archive, sorted_files[i]->path.size(), 4);
+		append_little_endian(archive, sorted_files[i]->content.size(), 4);
+		append_little_endian(archive, data_offset, 8);
+		append_little_endian(archive, compressed[i].size_in_bits, 8);
+		archive.append(reinterpret_cast<const char *>(hashes[i].data()), hashes[i].size());
+		path_offset += sorted_files[i]->path.size();
+		data_offset += compressed[i].nb_bytes;
+	}
+	for (const SourceFile * file : sorted_files) {
+		archive += file->path;
+	}
+	for (const CompressedFile & file : compressed) {
+		archive.append(reinterpret_cast<const char *>(file.data), file.nb_bytes);
+	}
+	assert(archive.size() == data_offset);
+	return archive;
+}
+
+void MappedArchive::buildFile(const std::string & archive_path, const std::vector<std::string> & source_paths,
+	const SharedDictionary * dictionary) {
+	std::vector<SourceFile> files;
+	for (const std::string & path : source_paths) {
+		files.push_back(SourceFile{ path, Compressor::readFile(path) });
+	}
+	ThreadPool pool;
+	const std::string archive = build(files, pool, dictionary);
+	Compressor::writeFile(archive_path, archive.data(), archive.size());
+}
+
+void MappedArchive::updateFile(const std::string & previous_archive_path, const std::string & archive_path,
+	const std::vector<std::string> & source_paths, const SharedDictionary * dictionary) {
+	std::vector<SourceFile> files;
+	for (const std::string & path : source_paths) {
+		files.push_back(SourceFile{ path, Compressor::readFile(path) });
+	}
+	std::string archive;
+	{
+		// unmapped before writing, archive_path can be the same file
+		const MappedArchive previous(previous_archive_path);
+		ThreadPool pool;
+		archive = update(previous, files, pool, dictionary);
+	}
+	Compressor::writeFile(archive_path, archive.data(), archive.size());
+}
+
+MappedArchive::MappedArchive(const std::string & archive_path) :
+	m_file(new MappedFile(archive_path)),
+	m_data(m_file->data()),
+	m_size(m_file->size()) {
+	readHeader();
+}
+
+MappedArchive::MappedArchive(const unsigned char * data, size_t size) :
+	m_data(data),
+	m_size(size) {
+	readHeader();
+}
+
+// Only the header is checked here, each entry is checked when used.
+void MappedArchive::readHeader() {
+	if (m_size < HEADER_SIZE || std::memcmp(m_data, MAPPED_ARCHIVE_MAGIC, sizeof(MAPPED_ARCHIVE_MAGIC)) != 0)
+		throw make_logic_error("Not a mapped archive!");
+	if (read_little_endian(m_data + 4, 4) != FORMAT_VERSION)
+		throw make_logic_error("Unsupported format version!");
+
+	const uint64_t nb_files = read_little_endian(m_data + 8, 4);
+	const uint64_t dictionary_id = read_little_endian(m_data + 12, 4);
+	const uint64_t entries_offset = read_little_endian(m_data + 16, 8);
+	const uint64_t paths_offset = read_little_endian(m_data + 24, 8);
+	if (entries_offset < HEADER_SIZE || entries_offset > m_size ||
+		nb_files > (m_size - entries_offset) / ENTRY_SIZE ||
+		paths_offset < entries_offset + nb_files * ENTRY_SIZE || paths_offset > m_size)
+		throw make_logic_error("Invalid mapped archive header!");
+
+	m_nb_files = static_cast<size_t>(nb_files);
+	m_dictionary_id = static_cast<uint32_t>(dictionary_id);
+	m_entries_offset = static_cast<size_t>(entries_offset);
+	m_paths_offset = static_cast<size_t>(paths_offset);
+}
+
+string_view MappedArchive::path(size_t index) const {
+	assert(index < m_nb_files);
+	const uint64_t offset = read_little_endian(entry(index), 8);
+	const uint64_t length = read_little_endian(entry(index) + 8, 4);
+	if (offset > m_size - m_paths_offset || length > m_size - m_paths_offset - offset || length > 0x7FFFFFFF)
+		throw make_logic_error("Invalid mapped archive path!");
+	return string_view(reinterpret_cast<const char *>(m_data + m_paths_offset + offset), static_cast<int>(length));
+}
+
+size_t MappedArchive::sourceLength(size_t index) const {
+	assert(index < m_nb_files);
+	return static_cast<size_t>(read_little_endian(entry(index) + 12, 4));
+}
+
+Sha256::Digest MappedArchive::contentHash(size_t index) const {
+	assert(index < m_nb_files);
+	Sha256::Digest digest;
+	std::memcpy(digest.data(), entry(index) + 32, digest.size());
+	return digest;
+}
+
+size_t MappedArchive::find(string_view path) const {
+	size_t first = 0;
+	size_t last = m_nb_files;
+	while (first < last) {
+		const size_t middle = first + (last - first) / 2;
+		const int comparison = compare_paths(this->path(middle), path);
+		if (comparison == 0)
+			return middle;
+		if (comparison < 0) {
+			first = middle + 1;
+		} else {
+			last = middle;
+		}
+	}
+	return NOT_FOUND;
+}
+
+const unsigned char * MappedArchive::compressedData(size_t index, uint64_t & size_in_bits) const {
+	assert(index < m_nb_files);
+	const uint64_t offset = read_little_endian(entry(index) + 16, 8);
+	size_in_bits = read_little_endian(entry(index) + 24, 8);
+	if (offset > m_size || (size_in_bits + 7) / 8 > m_size - offset || size_in_bits > 0xFFFFFFFFu)
+		throw make_logic_error("Invalid mapped archive entry!");
+	return m_data + offset;
+}
+
+InputBitStream MappedArchive::compressedStream(size_t index) const {
+	uint64_t size_in_bits;
+	const unsigned char * data = compressedData(index, size_in_bits);
+	return InputBitStream(data, static_cast<unsigned int>(size_in_bits));
+}
+
+std::string MappedArchive::decompress(size_t index, const SharedDictionary * dictionary) const {
+	if (m_dictionary_id != ((dictionary != nullptr) ? dictionary->id() : 0))
+		throw make_logic_error("Shared dictionary mismatch!");
+	InputBitStream stream = compressedStream(index);
+	std::string source = Compressor::decompress(stream, dictionary);
+	if (source.size() != sourceLength(index))
+		throw make_logic_error("Mapped archive source length mismatch!");
+	return source;
+}
+
+std::vector<size_t> MappedArchive::findSymbolName(string_view name, ThreadPool & pool, const SharedDictionary * dictionary) const {
+	if (m_dictionary_id != ((dictionary != nullptr) ? dictionary->id() : 0))
+		throw make_logic_error("Shared dictionary mismatch!");
+	// one flag per file, written by a single iteration each
+	std::vector<unsigned char> found(m_nb_files, 0);
+	pool.parallelFor(m_nb_files, [this, name, dictionary, &found](size_t i) {
+		InputBitStream stream = compressedStream(i);
+		found[i] = Compressor::containsSymbolName(stream, name, dictionary) ? 1 : 0;
+	});
+	std::vector<size_t> indexes;
+	for (size_t i = 0; i < m_nb_files; ++i) {
+		if (found[i] != 0) {
+			indexes.push_back(i);
+		}
+	}
+	return indexes;
+}
+
+// ----------------------------------------------------------------
+
+void test_MappedArchive() {
+	std::vector<MappedArchive::SourceFile> files = {
+		{ "src/main.cpp", "#include \"a.h\"\n\nint main() {\n\treturn value();\n}\n" },
+		{ "src/a.h", "#pragma once\n\ninline int value() { return 42; }\n" },
+		{ "README", "Some prose, not code." },
+		{ "src/empty.h", "" },
+	};
+	for (int i = 0; i < 50; ++i) {
+		files.push_back({ "gen/file_" + std::to_string(i) + ".h", "int generated_" + std::to_string(i) + ";\n" });
+	}
+
+	ThreadPool pool(2);
+	const std::string bytes = MappedArchive::build(files, pool);
+	const MappedArchive archive(reinterpret_cast<const unsigned char *>(bytes.data()), bytes.size());
+	assert(archive.nbFiles() == files.size());
+	for (size_t i = 1; i < archive.nbFiles(); ++i) {
+		assert(compare_paths(archive.path(i - 1), archive.path(i)) < 0);
+	}
+	for (const MappedArchive::SourceFile & file : files) {
+		const size_t index = archive.find(file.path.c_str());
+		assert(index != MappedArchive::NOT_FOUND);
+		assert(archive.path(index) == string_view(file.path.c_str()));
+		assert(archive.sourceLength(index) == file.content.size());
+		assert(archive.decompress(index) == file.content);
+	}
+	assert(archive.find("src") == MappedArchive::NOT_FOUND);
+	assert(archive.find("src/main.cpp2") == MappedArchive::NOT_FOUND);
+	assert(archive.find("") == MappedArchive::NOT_FOUND);
+	assert(archive.dictionaryId() == 0);
+
+	// with a dictionary trained on the files, smaller
+	std::vector<std::string> sources;
+	for (const MappedArchive::SourceFile & file : files) {
+		sources.push_back(file.content);
+	}
+	const std::string dictionary_bytes = SharedDictionary::train(sources);
+	const SharedDictionary dictionary(reinterpret_cast<const unsigned char *>(dictionary_bytes.data()), dictionary_bytes.size());
+	const std::string shared_bytes = MappedArchive::build(files, pool, &dictionary);
+	assert(shared_bytes.size() < bytes.size());
+	const MappedArchive shared_archive(reinterpret_cast<const unsigned char *>(shared_bytes.data()), shared_bytes.size());
+	assert(shared_archive.dictionaryId() == dictionary.id());
+	for (const MappedArchive::SourceFile & file : files) {
+		assert(shared_archive.decompress(shared_archive.find(file.path.c_str()), &dictionary) == file.content);
+	}
+	bool thrown = false;
+	try {
+		shared_archive.decompress(0);
+	} catch (const std::logic_error &) {
+		thrown = true;
+	}
+	assert(thrown);
+
+	// search in place: names only, not the comments or the strings
+	const std::vector<size_t> value_files = archive.findSymbolName("value", pool);
+	assert(value_files.size() == 2 && value_files[0] == archive.find("src/a.h") && value_files[1] == archive.find("src/main.cpp"));
+	assert(archive.findSymbolName("generated_7", pool) == std::vector<size_t>(1, archive.find("gen/file_7.h")));
+	assert(archive.findSymbolName("return", pool).size() == 2);
+	assert(archive.findSymbolName("prose", pool) == std::vector<size_t>(1, archive.find("README")));
+	assert(archive.findSymbolName("absent", pool).empty());
+	assert(shared_archive.findSymbolName("value", pool, &dictionary) == value_files);
+	assert(shared_archive.findSymbolName("generated_7", pool, &dictionary) == std::vector<size_t>(1, archive.find("gen/file_7.h")));
+
+	// incremental: a file modified, one added, one removed and one renamed
+	std::vector<MappedArchive::SourceFile> next_files = files;
+	next_files[0].content += "// modified\n";
+	next_files.erase(next_files.begin() + 2);
+	next_files[3].path = "gen/renamed.h";
+	next_files.push_back({ "src/b.h", "#pragma once\n\nint added();\n" });
+	size_t nb_reused = 0;
+	const std::string updated_bytes = MappedArchive::update(archive, next_files, pool, nullptr, &nb_reused);
+	assert(nb_reused == next_files.size() - 2);
+	assert(updated_bytes == MappedArchive::build(next_files, pool));
+	const MappedArchive updated(reinterpret_cast<const unsigned char *>(updated_bytes.data()), updated_bytes.size());
+	for (const MappedArchive::SourceFile & file : next_files) {
+		const size_t index = updated.find(file.path.c_str());
+		assert(updated.decompress(index) == file.content);
+	}
+	assert(updated.contentHash(updated.find("gen/renamed.h")) == archive.contentHash(archive.find("gen/file_0.h")));
+	// not with another dictionary
+	MappedArchive::update(shared_archive, next_files, pool, nullptr, &nb_reused);
+	assert(nb_reused == 0);
+	MappedArchive::update(shared_archive, next_files, pool, &dictionary, &nb_reused);
+	assert(nb_reused == next_files.size() - 2);
+	// nor a file compressed with another Compressor::FORMAT_VERSION, as if it had been bumped since
+	std::string stale_bytes = bytes;
+	const size_t stale_offset = archive.compressedStream(archive.find("gen/file_1.h")).data() -
+		reinterpret_cast<const unsigned char *>(bytes.data());
+	stale_bytes[stale_offset] = static_cast<char>(Compressor::FORMAT_VERSION - 1);
+	const MappedArchive stale(reinterpret_cast<const unsigned char *>(stale_bytes.data()), stale_bytes.size());
+	assert(MappedArchive::update(stale, next_files, pool, nullptr, &nb_reused) == updated_bytes);
+	assert(nb_reused == next_files.size() - 3);
+
+	// through a file mapping
+	const std::string path = "test_MappedArchive.tmp";
+	Compressor::writeFile(path, bytes.data(), bytes.size());
+	{
+		const MappedArchive mapped(path);
+		assert(mapped.decompress(mapped.find("src/a.h")) == files[1].content);
+	}
+	std::remove(path.c_str());
+
+	thrown = false;
+	try {
+		files.push_back(files[0]);
+		MappedArchive::build(files, pool);
+	} catch (const std::logic_error &) {
+		thrown = true;
+	}
+	assert(thrown);
+
+	thrown = false;
+	try {
+		const MappedArchive truncated(reinterpret_cast<const unsigned char *>(bytes.data()), MappedArchive::HEADER_SIZE + 10);
+	} catch (const std::logic_error &) {
+		thrown = true;
+	}
+	assert(thrown);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "BitStream.h"
+#include "MappedFile.h"
+#include "Sha256.h"
+#include "string_view.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+class SharedDictionary;
+
+// Read-only archive of many source files compressed by Compressor::compress(), laid out to be used
+// in place from a memory mapping: looking up and decompressing one file only touches the header,
+// the entries met by the binary search and the compressed bits of that file.
+//
+// Layout (integers are little endian):
+//   header (HEADER_SIZE bytes): "SRCM", format version (32 bits), number of files (32 bits),
+//     id of the SharedDictionary of the files or 0 (32 bits), entries offset (64 bits), paths offset (64 bits)
+//   entries (ENTRY_SIZE bytes each, sorted by path): path offset in the paths (64 bits), path length (32 bits),
+//     source length (32 bits), compressed data offset in the archive (64 bits), compressed size in bits (64 bits),
+//     SHA-256 of the source (256 bits)
+//   paths, concatenated
+//   compressed files, each one starting on a byte boundary
+class MappedArchive {
+public:
+	static const unsigned int FORMAT_VERSION = 3;
+	static const size_t HEADER_SIZE = 32;
+	static const size_t ENTRY_SIZE = 64;
+	static const size_t NOT_FOUND = static_cast<size_t>(-1);
+
+	struct SourceFile {
+		std::string path;
+		std::string content;
+	};
+
+	// Builds the archive in memory, the files are compressed in parallel on pool.
+	static std::string build(const std::vector<SourceFile> & files, ThreadPool & pool, const SharedDictionary * dictionary = nullptr);
+	static void buildFile(const std::string & archive_path, const std::vector<std::string> & source_paths,
+		const SharedDictionary * dictionary = nullptr);
+
+	// Incremental build: same as build(), except that the files found in previous (same SHA-256 and
+	// length, whatever their path) are copied from it instead of being compressed again, so that the
+	// time spent compressing depends on the changed files only. Nothing is reused if previous was built
+	// with another dictionary, nor the files compressed with another Compressor::FORMAT_VERSION.
+	// nb_reused_files, if not null, receives the number of copied files.
+	static std::string update(const MappedArchive & previous, const std::vector<SourceFile> & files, ThreadPool & pool,
+		const SharedDictionary * dictionary = nullptr, size_t * nb_reused_files = nullptr);
+	// archive_path can be previous_archive_path.
+	static void updateFile(const std::string & previous_archive_path, const std::string & archive_path,
+		const std::vector<std::string> & source_paths, const SharedDictionary * dictionary = nullptr);
+
+	// Maps the archive file.
+	explicit MappedArchive(const std::string & archive_path);
+	// Uses an archive already in memory: data must outlive the MappedArchive.
+	MappedArchive(const unsigned char * data, size_t size);
+
+	size_t nbFiles() const {
+		return m_nb_files;
+	}
+
+	// 0 if the files were compressed without a SharedDictionary.
+	uint32_t dictionaryId() const {
+		return m_dictionary_id;
+	}
+
+	// Files are sorted by path.
+	string_view path(size_t index) const;
+	size_t sourceLength(size_t index) const;
+	// SHA-256 of the source.
+	Sha256::Digest contentHash(size_t index) const;
+	size_t find(string_view path) const;
+
+	// Stream reading the compressed bits of the file directly from the archive.
+	InputBitStream compressedStream(size_t index) const;
+	// dictionary: the one the archive was built with, if any.
+	std::string decompress(size_t index, const SharedDictionary * dictionary = nullptr) const;
+	// Indexes (sorted) of the files with name as a symbol name, see Compressor::containsSymbolName().
+	// The files are searched in parallel on pool, in place, without being decompressed.
+	std::vector<size_t> findSymbolName(string_view name, ThreadPool & pool, const SharedDictionary * dictionary = nullptr) const;
+
+private:
+	static std::string build(const MappedArchive * previous, const std::vector<SourceFile> & files, ThreadPool & pool,
+		const SharedDictionary * dictionary, size_t * nb_reused_files);
+	void readHeader();
+	// Compressed bits of the file, checked to lie within the archive.
+	const unsigned char * compressedData(size_t index, uint64_t & size_in_bits) const;
+	const unsigned char * entry(size_t index) const {
+		return m_data + m_entries_offset + index * ENTRY_SIZE;
+	}
+
+	std::unique_ptr<MappedFile> m_file;
+	const unsigned char * m_data;
+	size_t m_size;
+	size_t m_nb_files = 0;
+	uint32_t m_dictionary_id = 0;
+	size_t m_entries_offset = 0;
+	size_t m_paths_offset = 0;
+};
+
+void test_MappedArchive();
@@ -0,0 +1,126 @@
+#include "MappedFile.h"
+
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string & path) {
+	HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("Can't open " + path);
+	m_file = file;
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(file, &size)) {
+		::CloseHandle(file);
+		throw std::runtime_error("Can't get the size of " + path);
+	}
+	m_size = static_cast<size_t>(size.QuadPart);
+	if (m_size == 0) {
+		// empty files can't be mapped
+		return;
+	}
+
+	m_mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping != nullptr) {
+		m_data = static_cast<const unsigned char *>(::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (m_data == nullptr) {
+		if (m_mapping != nullptr) {
+			::CloseHandle(m_mapping);
+		}
+		::CloseHandle(file);
+		throw std::runtime_error("Can't map " + path);
+	}
+}
+
+MappedFile::~MappedFile() {
+	if (m_data != nullptr) {
+		::UnmapViewOfFile(m_data);
+	}
+	if (m_mapping != nullptr) {
+		::CloseHandle(m_mapping);
+	}
+	::CloseHandle(m_file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string & path) {
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		throw std::runtime_error("Can't open " + path);
+
+	struct stat status;
+	if (::fstat(file, &status) != 0) {
+		::close(file);
+		throw std::runtime_error("Can't get the size of " + path);
+	}
+	m_size = static_cast<size_t>(status.st_size);
+	if (m_size == 0) {
+		// empty files can't be mapped
+		::close(file);
+		return;
+	}
+
+	void * data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+	// the mapping keeps its own reference to the file
+	::close(file);
+	if (data == MAP_FAILED)
+		throw std::runtime_error("Can't map " + path);
+	m_data = static_cast<const unsigned char *>(data);
+}
+
+MappedFile::~MappedFile() {
+	if (m_data != nullptr) {
+		::munmap(const_cast<unsigned char *>(m_data), m_size);
+	}
+}
+
+#endif
+
+// ----------------------------------------------------------------
+
+void test_MappedFile() {
+	const std::string path = "test_MappedFile.tmp";
+	const std::string content("mapped\ncontent\0with a null", 26);
+	{
+		FILE * file = std::fopen(path.c_str(), "wb");
+		assert(file != nullptr);
+		std::fwrite(content.data(), 1, content.size(), file);
+		std::fclose(file);
+	}
+	{
+		const MappedFile mapped(path);
+		assert(mapped.size() == content.size());
+		assert(std::string(reinterpret_cast<const char *>(mapped.data()), mapped.size()) == content);
+	}
+	{
+		FILE * file = std::fopen(path.c_str(), "wb");
+		std::fclose(file);
+		const MappedFile mapped(path);
+		assert(mapped.size() == 0);
+	}
+	std::remove(path.c_str());
+
+	bool thrown = false;
+	try {
+		const MappedFile mapped("this file doesn't exist.srcm");
+	} catch (const std::runtime_error &) {
+		thrown = true;
+	}
+	assert(thrown);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+// Read-only mapping of a whole file in memory: pages are only loaded when touched.
+class MappedFile {
+public:
+	// Throws std::runtime_error if the file can't be opened or mapped.
+	explicit MappedFile(const std::string & path);
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile & operator=(const MappedFile &) = delete;
+
+	const unsigned char * data() const {
+		return m_data;
+	}
+
+	size_t size() const {
+		return m_size;
+	}
+
+private:
+	const unsigned char * m_data = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	void * m_file = nullptr;
+	void * m_mapping = nullptr;
+#endif
+};
+
+void test_MappedFile();
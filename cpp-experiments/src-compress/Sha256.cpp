@@ -0,0 +1,116 @@
+#include "Sha256.h"
+
+#include <cassert>
+#include <cstring>
+#include <string>
+
+static const uint32_t ROUND_CONSTANTS[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const size_t BLOCK_SIZE = 64;
+
+static uint32_t rotate_right(uint32_t value, unsigned int nb_bits) {
+	return (value >> nb_bits) | (value << (32 - nb_bits));
+}
+
+static void process_block(uint32_t (&state)[8], const unsigned char * block) {
+	uint32_t w[64];
+	for (int i = 0; i < 16; ++i) {
+		w[i] = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16) | (uint32_t(block[4 * i + 2]) << 8) | block[4 * i + 3];
+	}
+	for (int i = 16; i < 64; ++i) {
+		const uint32_t s0 = rotate_right(w[i - 15], 7) ^ rotate_right(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		const uint32_t s1 = rotate_right(w[i - 2], 17) ^ rotate_right(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+	uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+	for (int i = 0; i < 64; ++i) {
+		const uint32_t s1 = rotate_right(e, 6) ^ rotate_right(e, 11) ^ rotate_right(e, 25);
+		const uint32_t choice = (e & f) ^ (~e & g);
+		const uint32_t t1 = h + s1 + choice + ROUND_CONSTANTS[i] + w[i];
+		const uint32_t s0 = rotate_right(a, 2) ^ rotate_right(a, 13) ^ rotate_right(a, 22);
+		const uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+		const uint32_t t2 = s0 + majority;
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+	state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+	state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+namespace Sha256 {
+	Digest hash(const void * data, size_t size) {
+		uint32_t state[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+		const unsigned char * bytes = static_cast<const unsigned char *>(data);
+		const size_t nb_full_blocks = size / BLOCK_SIZE;
+		for (size_t i = 0; i < nb_full_blocks; ++i) {
+			process_block(state, bytes + i * BLOCK_SIZE);
+		}
+
+		// padding: a 1 bit, zeros, then the length in bits (64 bits, big endian), in one or two blocks
+		unsigned char tail[2 * BLOCK_SIZE] = {};
+		const size_t nb_tail_bytes = size % BLOCK_SIZE;
+		if (nb_tail_bytes > 0) {
+			std::memcpy(tail, bytes + nb_full_blocks * BLOCK_SIZE, nb_tail_bytes);
+		}
+		tail[nb_tail_bytes] = 0x80;
+		const size_t tail_size = (nb_tail_bytes + 1 + 8 <= BLOCK_SIZE) ? BLOCK_SIZE : 2 * BLOCK_SIZE;
+		const uint64_t size_in_bits = static_cast<uint64_t>(size) * 8;
+		for (int i = 0; i < 8; ++i) {
+			tail[tail_size - 1 - i] = static_cast<unsigned char>(size_in_bits >> (8 * i));
+		}
+		for (size_t offset = 0; offset < tail_size; offset += BLOCK_SIZE) {
+			process_block(state, tail + offset);
+		}
+
+		Digest digest;
+		for (int i = 0; i < 8; ++i) {
+			for (int j = 0; j < 4; ++j) {
+				digest[4 * i + j] = static_cast<unsigned char>(state[i] >> (24 - 8 * j));
+			}
+		}
+		return digest;
+	}
+}
+
+// ----------------------------------------------------------------
+
+static std::string to_hex(const Sha256::Digest & digest) {
+	static const char DIGITS[] = "0123456789abcdef";
+	std::string hex;
+	for (unsigned char byte : digest) {
+		hex += DIGITS[byte >> 4];
+		hex += DIGITS[byte & 0xF];
+	}
+	return hex;
+}
+
+void test_Sha256() {
+	// FIPS 180-4 examples, and the lengths around the padding limits
+	assert(to_hex(Sha256::hash("", 0)) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+	assert(to_hex(Sha256::hash("abc", 3)) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+	const std::string two_blocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+	assert(to_hex(Sha256::hash(two_blocks.data(), two_blocks.size())) == "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+	const std::string million(1000000, 'a');
+	assert(to_hex(Sha256::hash(million.data(), million.size())) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+	const std::string block(64, 'a');
+	assert(to_hex(Sha256::hash(block.data(), 55)) == "9f4390f8d30c2dd92ec9f095b65e2b9ae9b0a925a5258e241c9f1e910f734318");
+	assert(to_hex(Sha256::hash(block.data(), 56)) == "b35439a4ac6f0948b6d6f9e3c6af0f5f590ce20f1bde7090ef7970686ec6738a");
+	assert(to_hex(Sha256::hash(block.data(), block.size())) == "ffe054fe7ae0cb6dc65c3af9b61d5209f439851db43d0ba5997337df154668eb");
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// SHA-256 (FIPS 180-4), for content hashes that files are identified by: unlike FNV-1a, finding two
+// contents with the same digest is not practical.
+namespace Sha256 {
+	static const size_t DIGEST_SIZE = 32;
+	typedef std::array<unsigned char, DIGEST_SIZE> Digest;
+
+	Digest hash(const void * data, size_t size);
+}
+
+void test_Sha256();
@@ -0,0 +1,252 @@
+#include "SharedDictionary.h"
+
+#include "BitStream.h"
+#include "Compressor.h"
+#include "Encoder.h"
+#include "Keywords.h"
+#include "LittleEndian.h"
+#include "Tokenizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+static const char SHARED_DICTIONARY_MAGIC[4] = { 'S', 'R', 'C', 'D' };
+
+// FNV-1a of the offsets and the names, 0 excepted
+static uint32_t dictionary_id(const unsigned char * data, size_t size) {
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < size; ++i) {
+		h = (h ^ data[i]) * 16777619u;
+	}
+	return (h == 0) ? 1 : h;
+}
+
+// Bits of a NEW_SYMBOL_NAME_* block payload with fixed width symbol codes.
+static unsigned int encoded_name_bits(string_view name) {
+	OutputBitStream stream;
+	stream.appendVarUInt(name.length() - 1);
+	Encoder::encodeNextSymbolName(stream, name);
+	return stream.sizeInBits();
+}
+
+struct TrainedName {
+	string_view name;
+	unsigned int nb_sources;
+	uint64_t saved_bits;
+};
+
+std::string SharedDictionary::train(const std::vector<std::string> & sources, unsigned int max_names) {
+	// number of sources each name appears in
+	SymbolDictionary names;
+	std::vector<TrainedName> trained_names;
+	for (const std::string & source : sources) {
+		SymbolDictionary source_names;
+		Tokenizer tokenizer(string_view(source.data(), static_cast<int>(source.size())));
+		Block block;
+		while (tokenizer.getNextBlock(block)) {
+			if ((block.type != NEW_SYMBOL_NAME_LOCAL_SCOPE && block.type != NEW_SYMBOL_NAME_GLOBAL_SCOPE) ||
+				Keywords::find(block.text) != Keywords::NOT_FOUND || source_names.find(block.text) != NOT_FOUND)
+				continue;
+			source_names.insert(block.text);
+			unsigned int id = names.find(block.text);
+			if (id == NOT_FOUND) {
+				id = names.insert(block.text);
+				trained_names.push_back(TrainedName{ block.text, 0, 0 });
+			}
+			trained_names[id].nb_sources += 1;
+		}
+	}
+
+	// In each source, the first occurrence of a name becomes a reference (the next ones are
+	// references anyway).
+	const unsigned int reference_bits = symbol_id_bit_width(max_names);
+	std::vector<TrainedName> selected;
+	for (TrainedName & name : trained_names) {
+		const unsigned int name_bits = encoded_name_bits(name.name);
+		if (name.nb_sources >= 2 && name_bits > reference_bits) {
+			name.saved_bits = static_cast<uint64_t>(name.nb_sources) * (name_bits - reference_bits);
+			selected.push_back(name);
+		}
+	}
+	std::sort(selected.begin(), selected.end(), [](const TrainedName & lhs, const TrainedName & rhs) {
+		if (lhs.saved_bits != rhs.saved_bits)
+			return lhs.saved_bits > rhs.saved_bits;
+		return std::lexicographical_compare(lhs.name.data(), lhs.name.data() + lhs.name.length(),
+			rhs.name.data(), rhs.name.data() + rhs.name.length());
+	});
+	if (selected.size() > max_names) {
+		selected.resize(max_names);
+	}
+
+	std::string content;
+	uint32_t end_offset = 0;
+	for (const TrainedName & name : selected) {
+		end_offset += name.name.length();
+		append_little_endian(content, end_offset, 4);
+	}
+	for (const TrainedName & name : selected) {
+		content.append(name.name.data(), name.name.length());
+	}
+
+	std::string dictionary(SHARED_DICTIONARY_MAGIC, sizeof(SHARED_DICTIONARY_MAGIC));
+	append_little_endian(dictionary, FORMAT_VERSION, 4);
+	append_little_endian(dictionary, dictionary_id(reinterpret_cast<const unsigned char *>(content.data()), content.size()), 4);
+	append_little_endian(dictionary, selected.size(), 4);
+	assert(dictionary.size() == HEADER_SIZE);
+	return dictionary + content;
+}
+
+void SharedDictionary::trainFile(const std::string & dictionary_path, const std::vector<std::string> & source_paths) {
+	std::vector<std::string> sources;
+	for (const std::string & path : source_paths) {
+		sources.push_back(Compressor::readFile(path));
+	}
+	const std::string dictionary = train(sources);
+	Compressor::writeFile(dictionary_path, dictionary.data(), dictionary.size());
+}
+
+SharedDictionary::SharedDictionary(const std::string & dictionary_path) :
+	m_file(new MappedFile(dictionary_path)),
+	m_data(m_file->data()),
+	m_size(m_file->size()) {
+	load();
+}
+
+SharedDictionary::SharedDictionary(const unsigned char * data, size_t size) :
+	m_data(data),
+	m_size(size) {
+	load();
+}
+
+// The whole dictionary is checked (the id is the hash of its content) and indexed.
+void SharedDictionary::load() {
+	if (m_size < HEADER_SIZE || std::memcmp(m_data, SHARED_DICTIONARY_MAGIC, sizeof(SHARED_DICTIONARY_MAGIC)) != 0)
+		throw make_logic_error("Not a shared dictionary!");
+	if (read_little_endian(m_data + 4, 4) != FORMAT_VERSION)
+		throw make_logic_error("Unsupported format version!");
+
+	m_id = static_cast<uint32_t>(read_little_endian(m_data + 8, 4));
+	const uint64_t nb_names = read_little_endian(m_data + 12, 4);
+	if (nb_names > (m_size - HEADER_SIZE) / 4)
+		throw make_logic_error("Invalid shared dictionary header!");
+	m_names_offset = HEADER_SIZE + static_cast<size_t>(nb_names) * 4;
+	if (m_id != dictionary_id(m_data + HEADER_SIZE, m_size - HEADER_SIZE))
+		throw make_logic_error("Corrupted shared dictionary!");
+
+	uint64_t start = 0;
+	for (unsigned int i = 0; i < nb_names; ++i) {
+		const uint64_t end = read_little_endian(m_data + HEADER_SIZE + i * 4, 4);
+		if (end <= start || end > m_size - m_names_offset)
+			throw make_logic_error("Invalid shared dictionary name!");
+		const string_view name(reinterpret_cast<const char *>(m_data + m_names_offset + start), static_cast<int>(end - start));
+		if (m_index.find(name) != NOT_FOUND)
+			throw make_logic_error("Duplicated name in the shared dictionary!");
+		m_index.insert(name);
+		start = end;
+	}
+}
+
+string_view SharedDictionary::name(unsigned int id) const {
+	if (id >= size())
+		throw make_logic_error("Invalid symbol id!");
+	const uint32_t start = (id == 0) ? 0 : static_cast<uint32_t>(read_little_endian(m_data + HEADER_SIZE + (id - 1) * 4, 4));
+	const uint32_t end = static_cast<uint32_t>(read_little_endian(m_data + HEADER_SIZE + id * 4, 4));
+	return string_view(reinterpret_cast<const char *>(m_data + m_names_offset + start), static_cast<int>(end - start));
+}
+
+// ----------------------------------------------------------------
+
+static PackedBits compress(const std::string & source, const SharedDictionary * dictionary) {
+	return Compressor::compress(string_view(source.data(), static_cast<int>(source.size())), Compressor::SYMBOL_CODING_HUFFMAN, dictionary);
+}
+
+void test_SharedDictionary() {
+	std::vector<std::string> corpus;
+	for (int i = 0; i < 20; ++i) {
+		corpus.push_back("#include \"ProjectSettings.h\"\n\nint computeChecksum_" + std::to_string(i) +
+			"(const ProjectSettings & settings) {\n\treturn settings.maximumNodeCount + localValue" + std::to_string(i) + ";\n}\n");
+	}
+	const std::string bytes = SharedDictionary::train(corpus);
+	const SharedDictionary dictionary(reinterpret_cast<const unsigned char *>(bytes.data()), bytes.size());
+	assert(dictionary.id() != 0);
+	assert(dictionary.size() == 3);
+	// as many sources, the longest name saves the most bits
+	assert(dictionary.name(0) == "maximumNodeCount");
+	assert(dictionary.find("ProjectSettings") != SharedDictionary::NOT_FOUND);
+	assert(dictionary.find("settings") != SharedDictionary::NOT_FOUND);
+	// in a single source, or a keyword
+	assert(dictionary.find("localValue0") == SharedDictionary::NOT_FOUND);
+	assert(dictionary.find("computeChecksum_") == SharedDictionary::NOT_FOUND);
+	assert(dictionary.find("return") == SharedDictionary::NOT_FOUND);
+	for (unsigned int id = 0; id < dictionary.size(); ++id) {
+		assert(dictionary.find(dictionary.name(id)) == id);
+	}
+	assert(SharedDictionary::train(corpus) == bytes);
+	assert(SharedDictionary::train(corpus, 1).size() == SharedDictionary::HEADER_SIZE + 4 + std::strlen("maximumNodeCount"));
+
+	// a small file not in the corpus
+	const std::string source = "bool isValid(const ProjectSettings & settings) {\n\treturn settings.maximumNodeCount > 0 && settings.maximumNodeCount < 1000;\n}\n";
+	const PackedBits with_dictionary = compress(source, &dictionary);
+	const PackedBits without_dictionary = compress(source, nullptr);
+	assert(with_dictionary.sizeInBits + 100 < without_dictionary.sizeInBits);
+	for (auto coding : { Compressor::SYMBOL_CODING_FIXED, Compressor::SYMBOL_CODING_HUFFMAN, Compressor::SYMBOL_CODING_RANS,
+		Compressor::SYMBOL_CODING_INTERLEAVED }) {
+		InputBitStream stream(Compressor::compress(string_view(source.data(), static_cast<int>(source.size())), coding, &dictionary));
+		assert(Compressor::decompress(stream, &dictionary) == source);
+	}
+
+	// the stream can only be decompressed with the same dictionary
+	bool thrown = false;
+	try {
+		InputBitStream stream(with_dictionary);
+		Compressor::decompress(stream);
+	} catch (const std::logic_error &) {
+		thrown = true;
+	}
+	assert(thrown);
+
+	// through a file mapping, and the files record the id of the dictionary
+	const std::string path = "test_SharedDictionary.tmp";
+	const std::string source_path = "test_SharedDictionary.source.tmp";
+	const std::string compressed_path = "test_SharedDictionary.srcz.tmp";
+	Compressor::writeFile(path, bytes.data(), bytes.size());
+	Compressor::writeFile(source_path, source.data(), source.size());
+	{
+		const SharedDictionary mapped(path);
+		assert(mapped.id() == dictionary.id());
+		InputBitStream stream(with_dictionary);
+		assert(Compressor::decompress(stream, &mapped) == source);
+
+		Compressor::compressFile(source_path, compressed_path, &mapped);
+		std::remove(source_path.c_str());
+		Compressor::decompressFile(compressed_path, source_path, &mapped);
+		assert(Compressor::readFile(source_path) == source);
+
+		const std::string other_bytes = SharedDictionary::train({ corpus[0], "int settings;", "settings = 1;" });
+		const SharedDictionary other_dictionary(reinterpret_cast<const unsigned char *>(other_bytes.data()), other_bytes.size());
+		assert(other_dictionary.id() != dictionary.id());
+		thrown = false;
+		try {
+			Compressor::decompressFile(compressed_path, source_path, &other_dictionary);
+		} catch (const std::runtime_error &) {
+			thrown = true;
+		}
+		assert(thrown);
+	}
+	std::remove(path.c_str());
+	std::remove(source_path.c_str());
+	std::remove(compressed_path.c_str());
+
+	std::string corrupted = bytes;
+	corrupted.back() ^= 1;
+	thrown = false;
+	try {
+		const SharedDictionary invalid(reinterpret_cast<const unsigned char *>(corrupted.data()), corrupted.size());
+	} catch (const std::logic_error &) {
+		thrown = true;
+	}
+	assert(thrown);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "SymbolDictionary.h"
+#include "string_view.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Frequent symbol names of a codebase, shared by its compressed files: they are known to the encoder
+// and the decoder before the first block, and written as SYMBOL_NAME_REFERENCE_SHARED blocks instead
+// of being encoded again in each file. Built by train() from a corpus and used in place from a memory
+// mapping. The compressed streams record the id of the dictionary they were compressed with.
+//
+// Layout (integers are little endian):
+//   "SRCD", format version (32 bits), id (32 bits), number of names (32 bits)
+//   end offset of each name in the names (32 bits each)
+//   names, concatenated, the ones saving the most bits first
+class SharedDictionary {
+public:
+	static const unsigned int FORMAT_VERSION = 1;
+	static const size_t HEADER_SIZE = 16;
+	static const unsigned int DEFAULT_MAX_NAMES = 4096;
+	static const unsigned int NOT_FOUND = SymbolDictionary::NOT_FOUND;
+
+	// Builds the dictionary of the names found in at least 2 of the sources (keywords excepted),
+	// ranked by the number of bits they would save over the corpus.
+	static std::string train(const std::vector<std::string> & sources, unsigned int max_names = DEFAULT_MAX_NAMES);
+	static void trainFile(const std::string & dictionary_path, const std::vector<std::string> & source_paths);
+
+	// Maps the dictionary file.
+	explicit SharedDictionary(const std::string & dictionary_path);
+	// Uses a dictionary already in memory: data must outlive the SharedDictionary.
+	SharedDictionary(const unsigned char * data, size_t size);
+
+	// Never 0, so that 0 can stand for "no dictionary".
+	uint32_t id() const {
+		return m_id;
+	}
+
+	unsigned int size() const {
+		return m_index.size();
+	}
+
+	string_view name(unsigned int id) const;
+	// Returns the id of name or NOT_FOUND.
+	unsigned int find(string_view name) const {
+		return m_index.find(name);
+	}
+	// name_hash: SymbolDictionary::hash(name)
+	unsigned int find(string_view name, uint32_t name_hash) const {
+		return m_index.find(name, name_hash);
+	}
+
+private:
+	void load();
+
+	std::unique_ptr<MappedFile> m_file;
+	const unsigned char * m_data;
+	size_t m_size;
+	uint32_t m_id = 0;
+	size_t m_names_offset = 0;
+	// names -> ids, the names are views on the dictionary data
+	SymbolDictionary m_index;
+};
+
+void test_SharedDictionary();
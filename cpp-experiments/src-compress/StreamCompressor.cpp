@@ -0,0 +1,252 @@
+#include "StreamCompressor.h"
+
+#include "LittleEndian.h"
+#include "string_view.h"
+
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+static const char STREAM_MAGIC[4] = { 'S', 'R', 'C', 'S' };
+static const size_t FRAME_HEADER_SIZE = 4 + 4;
+
+// Appends the bytes pulled from source to buffer until it holds max_size bytes or the source ends.
+// Returns false at the end of the source.
+static bool fill(const ByteSource & source, std::string & buffer, size_t max_size) {
+	while (buffer.size() < max_size) {
+		const size_t size = buffer.size();
+		buffer.resize(max_size);
+		const size_t n = source(reinterpret_cast<unsigned char *>(&buffer[size]), max_size - size);
+		buffer.resize(size + std::min(n, max_size - size));
+		if (n == 0)
+			return false;
+	}
+	return true;
+}
+
+static void read_exactly(const ByteSource & source, unsigned char * buffer, size_t nb_bytes) {
+	while (nb_bytes > 0) {
+		const size_t n = source(buffer, nb_bytes);
+		if (n == 0 || n > nb_bytes)
+			throw std::runtime_error("Unexpected end of input");
+		buffer += n;
+		nb_bytes -= n;
+	}
+}
+
+// Frames end after the last line end of the buffer unless it holds the end of the input, or are cut
+// at the end of the buffer when there is none.
+static size_t frame_length(const std::string & buffer, bool end_of_input) {
+	if (end_of_input)
+		return buffer.size();
+	const size_t line_end = buffer.rfind('\n');
+	return (line_end == std::string::npos) ? buffer.size() : line_end + 1;
+}
+
+static void append_frame_header(OutputBitStream & stream, size_t source_length, unsigned int size_in_bits) {
+	std::string header;
+	append_little_endian(header, source_length, 4);
+	append_little_endian(header, size_in_bits, 4);
+	stream.appendBytes(reinterpret_cast<const unsigned char *>(header.data()), header.size());
+}
+
+namespace StreamCompressor {
+	void compress(const ByteSource & source, const ByteSink & sink, Compressor::SYMBOL_CODING coding, unsigned int frame_size, size_t chunk_size) {
+		if (frame_size == 0 || frame_size > MAX_FRAME_SIZE)
+			throw make_logic_error("Invalid frame size!");
+
+		OutputBitStream output(sink, chunk_size);
+		output.appendBytes(reinterpret_cast<const unsigned char *>(STREAM_MAGIC), sizeof(STREAM_MAGIC));
+
+		std::string buffer;
+		buffer.reserve(frame_size);
+		bool end_of_input = false;
+		for (;;) {
+			if (!end_of_input) {
+				end_of_input = !fill(source, buffer, frame_size);
+			}
+			if (buffer.empty())
+				break;
+
+			const size_t length = frame_length(buffer, end_of_input);
+			const PackedBits bits = Compressor::compress(string_view(buffer.data(), static_cast<int>(length)), coding);
+			append_frame_header(output, length, bits.sizeInBits);
+			output.appendPackedBits(bits);
+			output.alignToByte();
+			buffer.erase(0, length);
+		}
+		append_frame_header(output, 0, 0);
+		output.finish();
+	}
+
+	void decompress(const ByteSource & source, const ByteSink & sink, size_t chunk_size) {
+		unsigned char magic[sizeof(STREAM_MAGIC)];
+		read_exactly(source, magic, sizeof(magic));
+		if (std::memcmp(magic, STREAM_MAGIC, sizeof(STREAM_MAGIC)) != 0)
+			throw make_logic_error("Not a compressed stream!");
+
+		for (;;) {
+			unsigned char header[FRAME_HEADER_SIZE];
+			read_exactly(source, header, sizeof(header));
+			const size_t source_length = static_cast<size_t>(read_little_endian(header, 4));
+			const unsigned int size_in_bits = static_cast<unsigned int>(read_little_endian(header + 4, 4));
+			if (source_length == 0)
+				break;
+
+			InputBitStream stream(source, size_in_bits, chunk_size);
+			const std::string frame = Compressor::decompress(stream);
+			if (frame.size() != source_length)
+				throw make_logic_error("Stream frame length mismatch!");
+			sink(reinterpret_cast<const unsigned char *>(frame.data()), frame.size());
+		}
+	}
+
+	ByteSource fileSource(FILE * file) {
+		return [file](unsigned char * buffer, size_t nb_bytes) {
+			const size_t n = std::fread(buffer, 1, nb_bytes, file);
+			if (n == 0 && std::ferror(file))
+				throw std::runtime_error("Can't read input");
+			return n;
+		};
+	}
+
+	ByteSink fileSink(FILE * file) {
+		return [file](const unsigned char * bytes, size_t nb_bytes) {
+			if (std::fwrite(bytes, 1, nb_bytes, file) != nb_bytes)
+				throw std::runtime_error("Can't write output");
+		};
+	}
+
+	// Opens path, or returns the standard input or output (switched to binary mode) for "-".
+	static std::shared_ptr<FILE> open_file(const std::string & path, bool output) {
+		if (path == "-") {
+			FILE * file = output ? stdout : stdin;
+#ifdef _WIN32
+			_setmode(_fileno(file), _O_BINARY);
+#endif
+			return std::shared_ptr<FILE>(file, [](FILE * f) { std::fflush(f); });
+		}
+		FILE * file = std::fopen(path.c_str(), output ? "wb" : "rb");
+		if (file == nullptr)
+			throw std::runtime_error("Can't open " + path);
+		return std::shared_ptr<FILE>(file, [](FILE * f) { std::fclose(f); });
+	}
+
+	void compressFile(const std::string & source_path, const std::string & compressed_path) {
+		const std::shared_ptr<FILE> input = open_file(source_path, false);
+		const std::shared_ptr<FILE> output = open_file(compressed_path, true);
+		compress(fileSource(input.get()), fileSink(output.get()));
+		if (std::fflush(output.get()) != 0)
+			throw std::runtime_error("Can't write " + compressed_path);
+	}
+
+	void decompressFile(const std::string & compressed_path, const std::string & source_path) {
+		const std::shared_ptr<FILE> input = open_file(compressed_path, false);
+		const std::shared_ptr<FILE> output = open_file(source_path, true);
+		decompress(fileSource(input.get()), fileSink(output.get()));
+		if (std::fflush(output.get()) != 0)
+			throw std::runtime_error("Can't write " + source_path);
+	}
+}
+
+// ----------------------------------------------------------------
+
+// Source handing out at most max_read bytes per call, like a pipe.
+static ByteSource string_source(const std::string & data, size_t & position, size_t max_read) {
+	return [&data, &position, max_read](unsigned char * buffer, size_t nb_bytes) {
+		const size_t n = std::min(std::min(nb_bytes, max_read), data.size() - position);
+		std::memcpy(buffer, data.data() + position, n);
+		position += n;
+		return n;
+	};
+}
+
+static void test_stream_round_trip(const std::string & source, Compressor::SYMBOL_CODING coding, unsigned int frame_size, size_t chunk_size, size_t max_read) {
+	std::string compressed;
+	size_t largest_chunk = 0;
+	size_t source_position = 0;
+	StreamCompressor::compress(string_source(source, source_position, max_read),
+		[&compressed, &largest_chunk](const unsigned char * bytes, size_t nb_bytes) {
+			compressed.append(reinterpret_cast<const char *>(bytes), nb_bytes);
+			largest_chunk = std::max(largest_chunk, nb_bytes);
+		}, coding, frame_size, chunk_size);
+	assert(source_position == source.size());
+	assert(largest_chunk <= chunk_size);
+
+	std::string decompressed;
+	size_t compressed_position = 0;
+	StreamCompressor::decompress(string_source(compressed, compressed_position, max_read),
+		[&decompressed](const unsigned char * bytes, size_t nb_bytes) {
+			decompressed.append(reinterpret_cast<const char *>(bytes), nb_bytes);
+		}, chunk_size);
+	assert(decompressed == source);
+	assert(compressed_position == compressed.size());
+}
+
+void test_StreamCompressor() {
+	std::string source;
+	for (int i = 0; i < 300; ++i) {
+		source += "int Value_" + std::to_string(i) + " = compute(value_" + std::to_string(i % 7) + ");\n";
+	}
+	source += "aVeryLongIdentifierWithoutAnyLineEnd";
+
+	for (auto coding : { Compressor::SYMBOL_CODING_FIXED, Compressor::SYMBOL_CODING_HUFFMAN, Compressor::SYMBOL_CODING_RANS,
+		Compressor::SYMBOL_CODING_INTERLEAVED }) {
+		test_stream_round_trip("", coding, 16, 16, 16);
+		test_stream_round_trip("x", coding, 16, 16, 16);
+		test_stream_round_trip(source, coding, StreamCompressor::DEFAULT_FRAME_SIZE, StreamCompressor::DEFAULT_CHUNK_SIZE, source.size());
+		// frames and chunks much smaller than the input, reads of a few bytes
+		test_stream_round_trip(source, coding, 200, 5, 3);
+		test_stream_round_trip(source, coding, 7, 1, 1);
+		test_stream_round_trip(source, coding, 1000, 64, 1000);
+	}
+
+	// rANS data followed by a high-entropy string literal copied in raw mode: the raw bytes are read
+	// from the source after the rANS data
+	std::string raw_text = "int first = 0;\nconst char * key = \"";
+	for (int i = 0; i < 200; ++i) {
+		raw_text += static_cast<char>('!' + (i * 37) % 90);
+		if (raw_text.back() == '"' || raw_text.back() == '\\') {
+			raw_text.back() = '#';
+		}
+	}
+	raw_text += "\";\n";
+	for (int i = 0; i < 50; ++i) {
+		raw_text += "int identifier_" + std::to_string(i) + " = other_" + std::to_string(i % 3) + ";\n";
+	}
+	test_stream_round_trip(raw_text, Compressor::SYMBOL_CODING_RANS, StreamCompressor::DEFAULT_FRAME_SIZE, 5, 3);
+	test_stream_round_trip(raw_text, Compressor::SYMBOL_CODING_RANS, 1000, 1, 1);
+
+	// truncated input
+	std::string compressed;
+	size_t position = 0;
+	StreamCompressor::compress(string_source(source, position, 100), [&compressed](const unsigned char * bytes, size_t nb_bytes) {
+		compressed.append(reinterpret_cast<const char *>(bytes), nb_bytes);
+	}, Compressor::SYMBOL_CODING_HUFFMAN, 500);
+	compressed.resize(compressed.size() - 20);
+	position = 0;
+	bool thrown = false;
+	try {
+		StreamCompressor::decompress(string_source(compressed, position, 100), [](const unsigned char *, size_t) {});
+	} catch (const std::runtime_error &) {
+		thrown = true;
+	}
+	assert(thrown);
+
+	// frames too large for the 32-bit size in bits
+	thrown = false;
+	try {
+		position = 0;
+		StreamCompressor::compress(string_source(source, position, 100), [](const unsigned char *, size_t) {},
+			Compressor::SYMBOL_CODING_HUFFMAN, StreamCompressor::MAX_FRAME_SIZE + 1);
+	} catch (const std::logic_error &) {
+		thrown = true;
+	}
+	assert(thrown);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "BitStream.h"
+#include "Compressor.h"
+
+#include <cstdio>
+#include <string>
+
+// Compression of inputs of any size (e.g. preprocessed sources piped from the compiler) with bounded
+// memory: the input is pulled from a source frame_size bytes at a time, each frame (cut at a line end
+// when possible) is compressed independently by Compressor::compress() and the output is handed to a
+// sink chunk_size bytes at a time. Decompression pulls the frames through a window of chunk_size bytes,
+// so the memory used depends on the frame and chunk sizes, not on the size of the input.
+//
+// Layout (integers are little endian):
+//   "SRCS"
+//   frames, each one starting on a byte boundary: source length (32 bits), size in bits (32 bits),
+//     compressed bits
+//   end of stream: 8 zero bytes (a frame with an empty source)
+namespace StreamCompressor {
+	static const unsigned int DEFAULT_FRAME_SIZE = 1 << 20;
+	// The size in bits of a frame is written on 32 bits: at 8 bits per char or less, frames up to
+	// 512 MB fit (compressing a frame that doesn't fit throws).
+	static const unsigned int MAX_FRAME_SIZE = (1u << 29) - 1;
+	static const size_t DEFAULT_CHUNK_SIZE = 1 << 16;
+
+	void compress(const ByteSource & source, const ByteSink & sink,
+		Compressor::SYMBOL_CODING coding = Compressor::DEFAULT_SYMBOL_CODING,
+		unsigned int frame_size = DEFAULT_FRAME_SIZE, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+	void decompress(const ByteSource & source, const ByteSink & sink, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+	// Reads or writes the file until its end, the file must be opened in binary mode.
+	ByteSource fileSource(FILE * file);
+	ByteSink fileSink(FILE * file);
+
+	// "-" stands for the standard input or output.
+	void compressFile(const std::string & source_path, const std::string & compressed_path);
+	void decompressFile(const std::string & compressed_path, const std::string & source_path);
+}
+
+void test_StreamCompressor();
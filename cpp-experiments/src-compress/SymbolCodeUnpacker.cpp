@@ -0,0 +1,184 @@
+#include "SymbolCodeUnpacker.h"
+
+#include "BitStream.h"
+
+#include <cassert>
+#include <cstring>
+
+// _pdep_u64 only exists in 64-bit mode: the Win32 configurations use the scalar code
+#if defined(_M_X64) || defined(__x86_64__)
+#define SYMBOL_CODE_UNPACKER_BMI2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_BMI2
+#else
+#include <cpuid.h>
+#define TARGET_BMI2 __attribute__((target("bmi2")))
+#endif
+#endif
+
+static const unsigned int CODES_PER_STEP = 8;
+static const unsigned int BITS_PER_STEP = CODES_PER_STEP * SYMBOL_NAME_CODES::BIT_WIDTH;
+
+// Returns the 40 bits of 8 codes starting at first_bit, right aligned (first code in the highest bits).
+// Reads 8 bytes: the caller makes sure they are available.
+static uint64_t load_step(const unsigned char * data, unsigned int first_bit) {
+	const uint64_t word = load_big_endian_64(data + first_bit / 8) << (first_bit % 8);
+	return word >> (64 - BITS_PER_STEP);
+}
+
+static void unpack_step_scalar(uint64_t packed, unsigned char * codes) {
+	for (unsigned int i = 0; i < CODES_PER_STEP; ++i) {
+		const unsigned int shift = BITS_PER_STEP - (i + 1) * SYMBOL_NAME_CODES::BIT_WIDTH;
+		codes[i] = static_cast<unsigned char>((packed >> shift) & 0x1F);
+	}
+}
+
+// Unpacks the codes one at a time, only reading the bytes they lie in.
+static void unpack_tail(const unsigned char * data, unsigned int first_bit, unsigned char * codes, unsigned int nb_codes) {
+	for (unsigned int i = 0; i < nb_codes; ++i) {
+		const unsigned int bit = first_bit + i * SYMBOL_NAME_CODES::BIT_WIDTH;
+		unsigned int value = static_cast<unsigned int>(data[bit / 8]) << 8;
+		if ((bit % 8) + SYMBOL_NAME_CODES::BIT_WIDTH > 8) {
+			value |= data[bit / 8 + 1];
+		}
+		codes[i] = static_cast<unsigned char>((value >> (16 - SYMBOL_NAME_CODES::BIT_WIDTH - bit % 8)) & 0x1F);
+	}
+}
+
+// Number of codes that can be unpacked with 8-byte loads without reading past nb_bytes.
+static unsigned int nb_codes_in_whole_steps(unsigned int nb_bytes, unsigned int first_bit, unsigned int nb_codes) {
+	unsigned int nb_steps = 0;
+	while (nb_steps * CODES_PER_STEP + CODES_PER_STEP <= nb_codes &&
+		(first_bit + nb_steps * BITS_PER_STEP) / 8 + 8 <= nb_bytes) {
+		nb_steps += 1;
+	}
+	return nb_steps * CODES_PER_STEP;
+}
+
+static void unpack_scalar(const unsigned char * data, unsigned int nb_bytes, unsigned int first_bit, unsigned char * codes, unsigned int nb_codes) {
+	const unsigned int nb_fast_codes = nb_codes_in_whole_steps(nb_bytes, first_bit, nb_codes);
+	for (unsigned int i = 0; i < nb_fast_codes; i += CODES_PER_STEP) {
+		unpack_step_scalar(load_step(data, first_bit), codes + i);
+		first_bit += BITS_PER_STEP;
+	}
+	unpack_tail(data, first_bit, codes + nb_fast_codes, nb_codes - nb_fast_codes);
+}
+
+#ifdef SYMBOL_CODE_UNPACKER_BMI2
+static uint64_t byte_swap_64(uint64_t value) {
+#if defined(_MSC_VER)
+	return _byteswap_uint64(value);
+#else
+	return __builtin_bswap64(value);
+#endif
+}
+
+// PDEP spreads each 5-bit field of the 40 packed bits into its own byte. The last code lands in
+// the lowest byte, so the result is byte swapped to get the first code first in memory.
+TARGET_BMI2 static void unpack_bmi2(const unsigned char * data, unsigned int nb_bytes, unsigned int first_bit, unsigned char * codes, unsigned int nb_codes) {
+	const unsigned int nb_fast_codes = nb_codes_in_whole_steps(nb_bytes, first_bit, nb_codes);
+	for (unsigned int i = 0; i < nb_fast_codes; i += CODES_PER_STEP) {
+		const uint64_t spread = _pdep_u64(load_step(data, first_bit), 0x1F1F1F1F1F1F1F1FULL);
+		const uint64_t in_memory_order = byte_swap_64(spread);
+		std::memcpy(codes + i, &in_memory_order, sizeof(in_memory_order));
+		first_bit += BITS_PER_STEP;
+	}
+	unpack_tail(data, first_bit, codes + nb_fast_codes, nb_codes - nb_fast_codes);
+}
+
+// EAX, EBX, ECX and EDX of CPUID leaf, sub-leaf 0.
+static void cpuid(unsigned int leaf, unsigned int (&regs)[4]) {
+#if defined(_MSC_VER)
+	__cpuidex(reinterpret_cast<int *>(regs), static_cast<int>(leaf), 0);
+#else
+	__cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static bool cpu_has_bmi2() {
+	// CPUID leaf 7, sub-leaf 0: EBX bit 8
+	unsigned int regs[4];
+	cpuid(0, regs);
+	if (regs[0] < 7)
+		return false;
+	cpuid(7, regs);
+	return (regs[1] & (1 << 8)) != 0;
+}
+
+// PDEP is microcoded on AMD before Zen 3 (family 19h), much slower than the scalar code.
+static bool cpu_has_slow_pdep() {
+	// vendor in EBX, EDX, ECX
+	unsigned int regs[4];
+	cpuid(0, regs);
+	const bool amd = std::memcmp(&regs[1], "Auth", 4) == 0 && std::memcmp(&regs[3], "enti", 4) == 0 &&
+		std::memcmp(&regs[2], "cAMD", 4) == 0;
+	if (!amd)
+		return false;
+	cpuid(1, regs);
+	const unsigned int base_family = (regs[0] >> 8) & 0xF;
+	const unsigned int family = (base_family == 0xF) ? base_family + ((regs[0] >> 20) & 0xFF) : base_family;
+	return family < 0x19;
+}
+#endif
+
+typedef void (*UnpackFunction)(const unsigned char *, unsigned int, unsigned int, unsigned char *, unsigned int);
+
+static UnpackFunction select_unpack_function() {
+#ifdef SYMBOL_CODE_UNPACKER_BMI2
+	if (cpu_has_bmi2() && !cpu_has_slow_pdep())
+		return unpack_bmi2;
+#endif
+	return unpack_scalar;
+}
+
+static const UnpackFunction selected_unpack_function = select_unpack_function();
+
+namespace SymbolCodeUnpacker {
+	void unpack(const unsigned char * data, unsigned int nb_bytes, unsigned int first_bit, unsigned char * codes, unsigned int nb_codes) {
+		assert(first_bit + nb_codes * SYMBOL_NAME_CODES::BIT_WIDTH <= nb_bytes * 8);
+		selected_unpack_function(data, nb_bytes, first_bit, codes, nb_codes);
+	}
+
+	const char * implementationName() {
+		return selected_unpack_function == unpack_scalar ? "scalar" : "bmi2";
+	}
+}
+
+// ----------------------------------------------------------------
+
+static void test_unpack_function(UnpackFunction unpack) {
+	OutputBitStream output;
+	const unsigned int nb_codes = 100;
+	for (unsigned int i = 0; i < nb_codes; ++i) {
+		output.appendBits((i * 7) % 32, SYMBOL_NAME_CODES::BIT_WIDTH);
+	}
+	const PackedBits bits = output.release();
+
+	for (unsigned int first_code = 0; first_code < 20; ++first_code) {
+		for (unsigned int count = 0; count <= nb_codes - first_code; count += 3) {
+			unsigned char codes[nb_codes];
+			unpack(bits.data.data(), static_cast<unsigned int>(bits.data.size()), first_code * SYMBOL_NAME_CODES::BIT_WIDTH, codes, count);
+			for (unsigned int i = 0; i < count; ++i) {
+				assert(codes[i] == ((first_code + i) * 7) % 32);
+			}
+		}
+	}
+
+	// unaligned start
+	const unsigned char data[] = { 0b10100001, 0b00010000, 0b11001000, 0b01000010, 0b00011000, 0b10000000 };
+	unsigned char codes[8];
+	unpack(data, sizeof(data), 1, codes, 8);
+	const unsigned char expected[8] = { 0b01000, 0b01000, 0b10000, 0b11001, 0b00001, 0b00001, 0b00001, 0b10001 };
+	assert(std::memcmp(codes, expected, 8) == 0);
+}
+
+void test_SymbolCodeUnpacker() {
+	test_unpack_function(unpack_scalar);
+#ifdef SYMBOL_CODE_UNPACKER_BMI2
+	if (cpu_has_bmi2())
+		test_unpack_function(unpack_bmi2);
+#endif
+	test_unpack_function(SymbolCodeUnpacker::unpack);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Bulk extraction of fixed-width SYMBOL_NAME_CODES (BIT_WIDTH = 5).
+// Uses BMI2 (PDEP) to spread 8 codes at a time when the CPU supports it and PDEP is fast (not on
+// AMD before Zen 3), or a portable implementation otherwise. The choice is made once at runtime
+// with CPUID.
+namespace SymbolCodeUnpacker {
+	// Unpacks nb_codes consecutive 5-bit codes, starting at bit first_bit of data (most significant
+	// bit first), into one byte per code. All the codes must lie within the nb_bytes of data.
+	void unpack(const unsigned char * data, unsigned int nb_bytes, unsigned int first_bit, unsigned char * codes, unsigned int nb_codes);
+
+	// Name of the implementation selected at runtime ("bmi2" or "scalar").
+	const char * implementationName();
+}
+
+void test_SymbolCodeUnpacker();
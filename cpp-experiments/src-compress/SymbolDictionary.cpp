@@ -0,0 +1,143 @@
+#include "SymbolDictionary.h"
+
+#include "BitStream.h"
+
+#include <cassert>
+#include <algorithm>
+
+unsigned int symbol_id_bit_width(unsigned int nb_names) {
+	unsigned int nb_bits = 0;
+	while (nb_bits < 32 && (uint64_t(1) << nb_bits) < nb_names) {
+		nb_bits += 1;
+	}
+	return nb_bits;
+}
+
+// FNV-1a
+uint32_t SymbolDictionary::hash(string_view name) {
+	uint32_t h = 2166136261u;
+	for (int i = 0; i < name.length(); ++i) {
+		h = (h ^ static_cast<unsigned char>(name[i])) * 16777619u;
+	}
+	return h;
+}
+
+unsigned int SymbolDictionary::find(string_view name, uint32_t h) const {
+	assert(h == hash(name));
+	if (m_slots.empty())
+		return NOT_FOUND;
+
+	const size_t mask = m_slots.size() - 1;
+	for (size_t i = h & mask; ; i = (i + 1) & mask) {
+		const Slot & slot = m_slots[i];
+		if (slot.id_plus_one == 0)
+			return NOT_FOUND;
+		if (slot.hash == h && m_names[slot.id_plus_one - 1] == name)
+			return slot.id_plus_one - 1;
+	}
+}
+
+unsigned int SymbolDictionary::insert(string_view name, uint32_t h) {
+	assert(find(name, h) == NOT_FOUND);
+	// keep the load factor under 1/2
+	if ((m_names.size() + 1) * 2 > m_slots.size()) {
+		grow();
+	}
+
+	const unsigned int id = size();
+	m_names.push_back(name);
+
+	const size_t mask = m_slots.size() - 1;
+	size_t i = h & mask;
+	while (m_slots[i].id_plus_one != 0) {
+		i = (i + 1) & mask;
+	}
+	m_slots[i].hash = h;
+	m_slots[i].id_plus_one = id + 1;
+	return id;
+}
+
+void SymbolDictionary::grow() {
+	std::vector<Slot> slots(m_slots.empty() ? 64 : m_slots.size() * 2, Slot{ 0, 0 });
+	const size_t mask = slots.size() - 1;
+	for (const Slot & slot : m_slots) {
+		if (slot.id_plus_one != 0) {
+			size_t i = slot.hash & mask;
+			while (slots[i].id_plus_one != 0) {
+				i = (i + 1) & mask;
+			}
+			slots[i] = slot;
+		}
+	}
+	m_slots.swap(slots);
+}
+
+void SymbolDictionary::clear() {
+	if (!m_names.empty()) {
+		std::fill(m_slots.begin(), m_slots.end(), Slot{ 0, 0 });
+		m_names.clear();
+	}
+}
+
+// ----------------------------------------------------------------
+
+unsigned int SymbolTable::add(const char * name, unsigned int length) {
+	const unsigned int id = size();
+	m_offsets.push_back(static_cast<unsigned int>(m_chars.size()));
+	m_lengths.push_back(length);
+	m_chars.append(name, length);
+	return id;
+}
+
+string_view SymbolTable::name(unsigned int id) const {
+	if (id >= size())
+		throw make_logic_error("Invalid symbol id!");
+	return string_view(m_chars.data() + m_offsets[id], static_cast<int>(m_lengths[id]));
+}
+
+void SymbolTable::clear() {
+	m_offsets.clear();
+	m_lengths.clear();
+	m_chars.clear();
+}
+
+// ----------------------------------------------------------------
+
+void test_SymbolDictionary() {
+	assert(symbol_id_bit_width(0) == 0);
+	assert(symbol_id_bit_width(1) == 0);
+	assert(symbol_id_bit_width(2) == 1);
+	assert(symbol_id_bit_width(3) == 2);
+	assert(symbol_id_bit_width(4) == 2);
+	assert(symbol_id_bit_width(5) == 3);
+	assert(symbol_id_bit_width(1024) == 10);
+
+	std::vector<std::string> names;
+	for (int i = 0; i < 1000; ++i) {
+		names.push_back("name" + std::to_string(i));
+	}
+
+	SymbolDictionary dictionary;
+	assert(dictionary.find("name0") == SymbolDictionary::NOT_FOUND);
+	for (size_t i = 0; i < names.size(); ++i) {
+		assert(dictionary.insert(names[i].c_str()) == i);
+	}
+	assert(dictionary.size() == names.size());
+	for (size_t i = 0; i < names.size(); ++i) {
+		assert(dictionary.find(names[i].c_str()) == i);
+	}
+	assert(dictionary.find("name") == SymbolDictionary::NOT_FOUND);
+	assert(dictionary.find("name1000") == SymbolDictionary::NOT_FOUND);
+	dictionary.clear();
+	assert(dictionary.size() == 0);
+	assert(dictionary.find("name0") == SymbolDictionary::NOT_FOUND);
+	assert(dictionary.insert("name1") == 0);
+
+	SymbolTable table;
+	assert(table.add("abc", 3) == 0);
+	assert(table.add("de", 2) == 1);
+	assert(table.name(0) == "abc");
+	assert(table.name(1) == "de");
+	table.clear();
+	assert(table.size() == 0);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "string_view.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Number of bits used to write the id of a symbol from a dictionary of nb_names names.
+unsigned int symbol_id_bit_width(unsigned int nb_names);
+
+// Encoder side: gives consecutive ids to symbol names, using an open addressing hash table.
+// Names are not copied: the text they refer to must outlive the dictionary.
+class SymbolDictionary {
+public:
+	static const unsigned int NOT_FOUND = ~0u;
+
+	unsigned int size() const {
+		return static_cast<unsigned int>(m_names.size());
+	}
+
+	// FNV-1a, also used by Keywords::find(): the overloads taking it let the encoder hash a name once.
+	static uint32_t hash(string_view name);
+
+	// Returns the id of name or NOT_FOUND.
+	unsigned int find(string_view name) const {
+		return find(name, hash(name));
+	}
+	unsigned int find(string_view name, uint32_t name_hash) const;
+	// Returns the id given to name, which must not be in the dictionary yet.
+	unsigned int insert(string_view name) {
+		return insert(name, hash(name));
+	}
+	unsigned int insert(string_view name, uint32_t name_hash);
+	void clear();
+
+private:
+	struct Slot {
+		uint32_t hash;
+		uint32_t id_plus_one; // 0 for an empty slot
+	};
+
+	void grow();
+
+	std::vector<Slot> m_slots;
+	std::vector<string_view> m_names;
+};
+
+// Decoder side mirror of SymbolDictionary: id -> name.
+// Names are stored one after the other in a single buffer.
+class SymbolTable {
+public:
+	unsigned int size() const {
+		return static_cast<unsigned int>(m_offsets.size());
+	}
+
+	unsigned int add(const char * name, unsigned int length);
+	// The returned view is invalidated by the next call to add().
+	string_view name(unsigned int id) const;
+	void clear();
+
+private:
+	std::vector<unsigned int> m_offsets;
+	std::vector<unsigned int> m_lengths;
+	std::string m_chars;
+};
+
+void test_SymbolDictionary();
@@ -0,0 +1,208 @@
+#include "SymbolHuffmanCode.h"
+
+#include "BitStream.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <queue>
+#include <vector>
+
+// Plain Huffman construction; returns the code length of each symbol (0 if its frequency is 0).
+static std::vector<unsigned int> huffman_code_lengths(const std::vector<uint64_t> & frequencies) {
+	struct Node {
+		uint64_t frequency;
+		int left;
+		int right;
+	};
+	std::vector<Node> nodes;
+	typedef std::pair<uint64_t, int> QueueItem; // (frequency, node index)
+	std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+	for (size_t symbol = 0; symbol < frequencies.size(); ++symbol) {
+		nodes.push_back(Node{ frequencies[symbol], -1, -1 });
+		if (frequencies[symbol] > 0) {
+			queue.push(QueueItem(frequencies[symbol], static_cast<int>(symbol)));
+		}
+	}
+
+	std::vector<unsigned int> lengths(frequencies.size(), 0);
+	if (queue.size() == 1) {
+		lengths[queue.top().second] = 1;
+		return lengths;
+	}
+	while (queue.size() > 1) {
+		const QueueItem a = queue.top();
+		queue.pop();
+		const QueueItem b = queue.top();
+		queue.pop();
+		nodes.push_back(Node{ a.first + b.first, a.second, b.second });
+		queue.push(QueueItem(a.first + b.first, static_cast<int>(nodes.size() - 1)));
+	}
+
+	// depth of the leaves
+	std::vector<std::pair<int, unsigned int>> stack;
+	if (!queue.empty()) {
+		stack.push_back(std::make_pair(queue.top().second, 0u));
+	}
+	while (!stack.empty()) {
+		const auto item = stack.back();
+		stack.pop_back();
+		const Node & node = nodes[item.first];
+		if (node.left < 0) {
+			lengths[item.first] = item.second;
+		} else {
+			stack.push_back(std::make_pair(node.left, item.second + 1));
+			stack.push_back(std::make_pair(node.right, item.second + 1));
+		}
+	}
+	return lengths;
+}
+
+std::vector<unsigned int> limited_huffman_code_lengths(std::vector<uint64_t> frequencies, unsigned int max_length) {
+	for (;;) {
+		std::vector<unsigned int> lengths = huffman_code_lengths(frequencies);
+		if (lengths.empty() || *std::max_element(lengths.begin(), lengths.end()) <= max_length)
+			return lengths;
+		// flatten the distribution until the longest code fits
+		for (uint64_t & frequency : frequencies) {
+			if (frequency > 0) {
+				frequency = (frequency + 1) / 2;
+			}
+		}
+	}
+}
+
+SymbolHuffmanCode SymbolHuffmanCode::fromFrequencies(const unsigned int (&frequencies)[NB_SYMBOLS]) {
+	const std::vector<unsigned int> lengths = limited_huffman_code_lengths(
+		std::vector<uint64_t>(frequencies, frequencies + NB_SYMBOLS), MAX_CODE_LENGTH);
+	SymbolHuffmanCode code;
+	std::copy(lengths.begin(), lengths.end(), code.m_lengths);
+	code.assignCanonicalCodes();
+	return code;
+}
+
+SymbolHuffmanCode SymbolHuffmanCode::fromCodeLengths(const unsigned char (&lengths)[NB_SYMBOLS]) {
+	unsigned int kraft_sum = 0;
+	for (unsigned int symbol = 0; symbol < NB_SYMBOLS; ++symbol) {
+		if (lengths[symbol] > MAX_CODE_LENGTH)
+			throw make_logic_error("Invalid Huffman code length!");
+		if (lengths[symbol] > 0) {
+			kraft_sum += 1 << (MAX_CODE_LENGTH - lengths[symbol]);
+		}
+	}
+	if (kraft_sum > (1u << MAX_CODE_LENGTH))
+		throw make_logic_error("Invalid Huffman code lengths!");
+
+	SymbolHuffmanCode code;
+	std::copy(lengths, lengths + NB_SYMBOLS, code.m_lengths);
+	code.assignCanonicalCodes();
+	return code;
+}
+
+void SymbolHuffmanCode::assignCanonicalCodes() {
+	// codes are given by increasing length, then by increasing symbol
+	unsigned int next_code = 0;
+	m_min_length = 0;
+	for (unsigned int length = 1; length <= MAX_CODE_LENGTH; ++length) {
+		for (unsigned int symbol = 0; symbol < NB_SYMBOLS; ++symbol) {
+			if (m_lengths[symbol] != length)
+				continue;
+			if (m_min_length == 0) {
+				m_min_length = length;
+			}
+			m_codes[symbol] = static_cast<uint16_t>(next_code);
+			const unsigned int shift = MAX_CODE_LENGTH - length;
+			for (unsigned int window = next_code << shift; window < (next_code + 1) << shift; ++window) {
+				m_decoding_table[window].symbol = static_cast<unsigned char>(symbol);
+				m_decoding_table[window].length = static_cast<unsigned char>(length);
+			}
+			next_code += 1;
+		}
+		next_code <<= 1;
+	}
+}
+
+void SymbolHuffmanCode::write(OutputBitStream & stream) const {
+	for (unsigned int symbol = 0; symbol < NB_SYMBOLS; ++symbol) {
+		stream.appendBits(m_lengths[symbol], 4);
+	}
+}
+
+SymbolHuffmanCode SymbolHuffmanCode::read(InputBitStream & stream) {
+	unsigned char lengths[NB_SYMBOLS];
+	for (unsigned int symbol = 0; symbol < NB_SYMBOLS; ++symbol) {
+		lengths[symbol] = static_cast<unsigned char>(stream.readBits(4));
+	}
+	return fromCodeLengths(lengths);
+}
+
+// ----------------------------------------------------------------
+
+static void test_round_trip(const unsigned int (&frequencies)[SymbolHuffmanCode::NB_SYMBOLS]) {
+	const SymbolHuffmanCode code = SymbolHuffmanCode::fromFrequencies(frequencies);
+	OutputBitStream output;
+	output.setSymbolHuffmanCode(&code);
+	code.write(output);
+	for (unsigned int symbol = 0; symbol < SymbolHuffmanCode::NB_SYMBOLS; ++symbol) {
+		assert((code.codeLength(symbol) == 0) == (frequencies[symbol] == 0));
+		if (frequencies[symbol] > 0) {
+			output.appendSymbolCode(static_cast<SYMBOL_NAME_CODES::ENUM>(symbol));
+		}
+	}
+
+	InputBitStream input(output.release());
+	const SymbolHuffmanCode read_code = SymbolHuffmanCode::read(input);
+	input.setSymbolHuffmanCode(&read_code);
+	for (unsigned int symbol = 0; symbol < SymbolHuffmanCode::NB_SYMBOLS; ++symbol) {
+		assert(read_code.codeLength(symbol) == code.codeLength(symbol));
+		if (frequencies[symbol] > 0) {
+			assert(input.readSymbolCode() == symbol);
+		}
+	}
+	assert(input.isEmpty());
+}
+
+void test_SymbolHuffmanCode() {
+	unsigned int frequencies[SymbolHuffmanCode::NB_SYMBOLS] = {};
+
+	frequencies[3] = 10;
+	test_round_trip(frequencies);
+	assert(SymbolHuffmanCode::fromFrequencies(frequencies).codeLength(3) == 1);
+
+	frequencies[7] = 10;
+	frequencies[8] = 20;
+	test_round_trip(frequencies);
+	const SymbolHuffmanCode small = SymbolHuffmanCode::fromFrequencies(frequencies);
+	assert(small.codeLength(8) == 1 && small.codeLength(3) == 2 && small.codeLength(7) == 2);
+	// canonical: shorter codes first, then by symbol
+	assert(small.code(8) == 0b0 && small.code(3) == 0b10 && small.code(7) == 0b11);
+	assert(small.minCodeLength() == 1);
+
+	// Fibonacci frequencies need long codes: lengths are limited
+	unsigned int a = 1, b = 1;
+	for (unsigned int symbol = 0; symbol < SymbolHuffmanCode::NB_SYMBOLS; ++symbol) {
+		frequencies[symbol] = a;
+		const unsigned int next = a + b;
+		a = b;
+		b = next;
+	}
+	test_round_trip(frequencies);
+	for (unsigned int symbol = 0; symbol < SymbolHuffmanCode::NB_SYMBOLS; ++symbol) {
+		assert(SymbolHuffmanCode::fromFrequencies(frequencies).codeLength(symbol) <= SymbolHuffmanCode::MAX_CODE_LENGTH);
+	}
+
+	for (unsigned int symbol = 0; symbol < SymbolHuffmanCode::NB_SYMBOLS; ++symbol) {
+		frequencies[symbol] = 1;
+	}
+	test_round_trip(frequencies);
+	assert(SymbolHuffmanCode::fromFrequencies(frequencies).codeLength(0) == 5);
+
+	unsigned char too_many_short_codes[SymbolHuffmanCode::NB_SYMBOLS] = { 1, 1, 1 };
+	bool thrown = false;
+	try {
+		SymbolHuffmanCode::fromCodeLengths(too_many_short_codes);
+	} catch (const std::logic_error &) {
+		thrown = true;
+	}
+	assert(thrown);
+}
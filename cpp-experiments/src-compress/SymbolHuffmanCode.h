@@ -0,0 +1,61 @@
+#pragma once
+
+#include "EncodingTables.h"
+
+#include <cstdint>
+#include <vector>
+
+class OutputBitStream;
+class InputBitStream;
+
+// Canonical Huffman code for the SYMBOL_NAME_CODES alphabet (order 0), an alternative to the
+// fixed 5-bit codes. Decoding uses a single table indexed by the next MAX_CODE_LENGTH bits.
+class SymbolHuffmanCode {
+public:
+	static const unsigned int NB_SYMBOLS = 1 << SYMBOL_NAME_CODES::BIT_WIDTH;
+	static const unsigned int MAX_CODE_LENGTH = 12;
+
+	// Symbols with a null frequency get no code.
+	static SymbolHuffmanCode fromFrequencies(const unsigned int (&frequencies)[NB_SYMBOLS]);
+	// Throws if the lengths don't describe a valid prefix code.
+	static SymbolHuffmanCode fromCodeLengths(const unsigned char (&lengths)[NB_SYMBOLS]);
+
+	// Serialized as the code length of each symbol (4 bits each).
+	void write(OutputBitStream & stream) const;
+	static SymbolHuffmanCode read(InputBitStream & stream);
+
+	// 0 for a symbol without code
+	unsigned int codeLength(unsigned int symbol) const {
+		return m_lengths[symbol];
+	}
+	unsigned int code(unsigned int symbol) const {
+		return m_codes[symbol];
+	}
+	unsigned int minCodeLength() const {
+		return m_min_length;
+	}
+
+	struct DecodingEntry {
+		unsigned char symbol;
+		unsigned char length; // 0 if the bits don't start with a valid code
+	};
+	// window: the next MAX_CODE_LENGTH bits of the stream
+	DecodingEntry decode(unsigned int window) const {
+		return m_decoding_table[window];
+	}
+
+private:
+	SymbolHuffmanCode() = default;
+	void assignCanonicalCodes();
+
+	unsigned char m_lengths[NB_SYMBOLS] = {};
+	uint16_t m_codes[NB_SYMBOLS] = {};
+	unsigned int m_min_length = 0;
+	DecodingEntry m_decoding_table[1 << MAX_CODE_LENGTH] = {};
+};
+
+// Huffman code lengths (0 for the symbols with a null frequency), the distribution being flattened
+// until no code is longer than max_length bits.
+std::vector<unsigned int> limited_huffman_code_lengths(std::vector<uint64_t> frequencies, unsigned int max_length);
+
+void test_SymbolHuffmanCode();
@@ -0,0 +1,191 @@
+#include "SymbolRansCoder.h"
+
+#include "BitStream.h"
+
+#include <algorithm>
+#include <cassert>
+
+// lower bound of the normalized state interval [RANS_L, RANS_L << 8)
+static const uint32_t RANS_L = 1u << 23;
+
+SymbolRansModel SymbolRansModel::fromCounts(const unsigned int (&counts)[NB_SYMBOLS]) {
+	SymbolRansModel model;
+	uint64_t total = 0;
+	for (unsigned int symbol = 0; symbol < NB_SYMBOLS; ++symbol) {
+		total += counts[symbol];
+	}
+	if (total == 0) {
+		model.buildTables();
+		return model;
+	}
+
+	// every present symbol keeps a non null frequency, the rounding error goes to the most frequent one
+	const unsigned int scale = 1 << SCALE_BITS;
+	unsigned int sum = 0;
+	unsigned int most_frequent = 0;
+	for (unsigned int symbol = 0; symbol < NB_SYMBOLS; ++symbol) {
+		if (counts[symbol] > 0) {
+			const uint64_t frequency = std::max<uint64_t>(1, counts[symbol] * uint64_t(scale) / total);
+			model.m_frequencies[symbol] = static_cast<uint16_t>(frequency);
+			sum += model.m_frequencies[symbol];
+		}
+		if (counts[symbol] > counts[most_frequent]) {
+			most_frequent = symbol;
+		}
+	}
+	model.m_frequencies[most_frequent] = static_cast<uint16_t>(model.m_frequencies[most_frequent] + scale - sum);
+	model.buildTables();
+	return model;
+}
+
+void SymbolRansModel::buildTables() {
+	unsigned int cumulative = 0;
+	for (unsigned int symbol = 0; symbol < NB_SYMBOLS; ++symbol) {
+		m_cumulative[symbol] = static_cast<uint16_t>(cumulative);
+		for (unsigned int slot = cumulative; slot < cumulative + m_frequencies[symbol]; ++slot) {
+			m_slot_to_symbol[slot] = static_cast<unsigned char>(symbol);
+		}
+		cumulative += m_frequencies[symbol];
+	}
+	assert(cumulative == 0 || cumulative == (1u << SCALE_BITS));
+}
+
+void SymbolRansModel::write(OutputBitStream & stream) const {
+	for (unsigned int symbol = 0; symbol < NB_SYMBOLS; ++symbol) {
+		stream.appendBits(m_frequencies[symbol], SCALE_BITS + 1);
+	}
+}
+
+SymbolRansModel SymbolRansModel::read(InputBitStream & stream) {
+	SymbolRansModel model;
+	unsigned int sum = 0;
+	for (unsigned int symbol = 0; symbol < NB_SYMBOLS; ++symbol) {
+		model.m_frequencies[symbol] = static_cast<uint16_t>(stream.readBits(SCALE_BITS + 1));
+		sum += model.m_frequencies[symbol];
+	}
+	if (sum != 0 && sum != (1u << SCALE_BITS))
+		throw make_logic_error("Invalid rANS frequencies!");
+	model.buildTables();
+	return model;
+}
+
+// ----------------------------------------------------------------
+
+namespace SymbolRans {
+	std::vector<unsigned char> encode(const SymbolRansModel & model, const std::vector<unsigned char> & symbols) {
+		// bytes are produced backwards: worst case 4 bytes per symbol plus the final states
+		std::vector<unsigned char> buffer(symbols.size() * 4 + NB_STATES * 4);
+		unsigned char * ptr = buffer.data() + buffer.size();
+
+		uint32_t states[NB_STATES];
+		std::fill(states, states + NB_STATES, RANS_L);
+
+		// last symbol first, so that the decoder reads them in order
+		for (size_t i = symbols.size(); i-- > 0;) {
+			uint32_t & x = states[i % NB_STATES];
+			const unsigned int symbol = symbols[i];
+			const uint32_t frequency = model.frequency(symbol);
+			if (frequency == 0)
+				throw make_logic_error("Symbol missing from the rANS model!");
+
+			const uint32_t x_max = ((RANS_L >> SymbolRansModel::SCALE_BITS) << 8) * frequency;
+			while (x >= x_max) {
+				*--ptr = static_cast<unsigned char>(x & 0xFF);
+				x >>= 8;
+			}
+			x = ((x / frequency) << SymbolRansModel::SCALE_BITS) + (x % frequency) + model.cumulativeFrequency(symbol);
+		}
+
+		// the decoder reads state 0 first
+		for (unsigned int s = NB_STATES; s-- > 0;) {
+			for (int byte = 0; byte < 4; ++byte) {
+				*--ptr = static_cast<unsigned char>(states[s] >> (8 * byte));
+			}
+		}
+
+		return std::vector<unsigned char>(ptr, buffer.data() + buffer.size());
+	}
+}
+
+SymbolRansDecoder::SymbolRansDecoder(const SymbolRansModel & model, const unsigned char * data, size_t size, unsigned int nb_symbols) :
+	m_model(model),
+	m_data(data),
+	m_end(data + size),
+	m_remaining_symbols(nb_symbols) {
+	if (size < SymbolRans::NB_STATES * 4)
+		throw make_logic_error("Truncated rANS data!");
+	for (unsigned int s = 0; s < SymbolRans::NB_STATES; ++s) {
+		m_states[s] =
+			(static_cast<uint32_t>(m_data[0]) << 24) |
+			(static_cast<uint32_t>(m_data[1]) << 16) |
+			(static_cast<uint32_t>(m_data[2]) << 8) |
+			static_cast<uint32_t>(m_data[3]);
+		m_data += 4;
+	}
+}
+
+unsigned int SymbolRansDecoder::decodeSymbol() {
+	if (m_remaining_symbols == 0)
+		throw make_logic_error("No more rANS symbols!");
+	m_remaining_symbols -= 1;
+
+	uint32_t & x = m_states[m_next_state];
+	m_next_state = (m_next_state + 1) % SymbolRans::NB_STATES;
+
+	const uint32_t mask = (1u << SymbolRansModel::SCALE_BITS) - 1;
+	const unsigned int symbol = m_model.symbolAt(x & mask);
+	x = m_model.frequency(symbol) * (x >> SymbolRansModel::SCALE_BITS) + (x & mask) - m_model.cumulativeFrequency(symbol);
+	while (x < RANS_L) {
+		if (unlikely(m_data == m_end))
+			throw make_logic_error("Truncated rANS data!");
+		x = (x << 8) | *m_data++;
+	}
+	return symbol;
+}
+
+// ----------------------------------------------------------------
+
+static void test_rans_round_trip(const std::vector<unsigned char> & symbols) {
+	unsigned int counts[SymbolRansModel::NB_SYMBOLS] = {};
+	for (unsigned char symbol : symbols) {
+		counts[symbol] += 1;
+	}
+	const SymbolRansModel model = SymbolRansModel::fromCounts(counts);
+
+	OutputBitStream output;
+	model.write(output);
+	InputBitStream input(output.release());
+	const SymbolRansModel read_model = SymbolRansModel::read(input);
+	assert(input.isEmpty());
+
+	const std::vector<unsigned char> encoded = SymbolRans::encode(model, symbols);
+	SymbolRansDecoder decoder(read_model, encoded.data(), encoded.size(), static_cast<unsigned int>(symbols.size()));
+	for (unsigned char symbol : symbols) {
+		assert(decoder.decodeSymbol() == symbol);
+	}
+	assert(decoder.remainingSymbols() == 0);
+}
+
+void test_SymbolRansCoder() {
+	test_rans_round_trip({});
+	test_rans_round_trip({ 7 });
+	test_rans_round_trip({ 1, 2, 3 });
+
+	std::vector<unsigned char> symbols;
+	unsigned int seed = 1;
+	for (int i = 0; i < 10000; ++i) {
+		seed = seed * 1103515245 + 12345;
+		// skewed distribution
+		const unsigned int r = (seed >> 16) & 0x7FFF;
+		symbols.push_back(static_cast<unsigned char>(r % 7 == 0 ? r % 32 : r % 5));
+	}
+	test_rans_round_trip(symbols);
+
+	unsigned int counts[SymbolRansModel::NB_SYMBOLS] = {};
+	counts[0] = 1000000;
+	counts[31] = 1;
+	const SymbolRansModel model = SymbolRansModel::fromCounts(counts);
+	assert(model.frequency(31) == 1);
+	assert(model.frequency(0) == (1u << SymbolRansModel::SCALE_BITS) - 1);
+	assert(model.symbolAt(0) == 0 && model.symbolAt((1u << SymbolRansModel::SCALE_BITS) - 1) == 31);
+}
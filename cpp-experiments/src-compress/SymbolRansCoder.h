@@ -0,0 +1,74 @@
+#pragma once
+
+#include "EncodingTables.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class OutputBitStream;
+class InputBitStream;
+
+// Static frequency model of the SYMBOL_NAME_CODES alphabet for the rANS coder.
+// Frequencies are normalized to a total of 1 << SCALE_BITS.
+class SymbolRansModel {
+public:
+	static const unsigned int NB_SYMBOLS = 1 << SYMBOL_NAME_CODES::BIT_WIDTH;
+	static const unsigned int SCALE_BITS = 12;
+
+	static SymbolRansModel fromCounts(const unsigned int (&counts)[NB_SYMBOLS]);
+
+	// Serialized as the normalized frequency of each symbol (SCALE_BITS + 1 bits each).
+	void write(OutputBitStream & stream) const;
+	static SymbolRansModel read(InputBitStream & stream);
+
+	unsigned int frequency(unsigned int symbol) const {
+		return m_frequencies[symbol];
+	}
+	unsigned int cumulativeFrequency(unsigned int symbol) const {
+		return m_cumulative[symbol];
+	}
+	// symbol whose [cumulative, cumulative + frequency) range holds slot
+	unsigned int symbolAt(unsigned int slot) const {
+		return m_slot_to_symbol[slot];
+	}
+
+private:
+	SymbolRansModel() = default;
+	void buildTables();
+
+	uint16_t m_frequencies[NB_SYMBOLS] = {};
+	uint16_t m_cumulative[NB_SYMBOLS] = {};
+	unsigned char m_slot_to_symbol[1 << SCALE_BITS] = {};
+};
+
+// rANS coding of symbol codes with NB_STATES interleaved states (symbol i uses state i % NB_STATES)
+// so that the CPU can overlap their dependency chains. 32-bit states, byte-wise renormalization.
+namespace SymbolRans {
+	static const unsigned int NB_STATES = 4;
+
+	std::vector<unsigned char> encode(const SymbolRansModel & model, const std::vector<unsigned char> & symbols);
+}
+
+// Reads the symbols written by SymbolRans::encode() in order.
+class SymbolRansDecoder {
+public:
+	// data must outlive the decoder.
+	SymbolRansDecoder(const SymbolRansModel & model, const unsigned char * data, size_t size, unsigned int nb_symbols);
+
+	unsigned int remainingSymbols() const {
+		return m_remaining_symbols;
+	}
+
+	unsigned int decodeSymbol();
+
+private:
+	const SymbolRansModel & m_model;
+	const unsigned char * m_data;
+	const unsigned char * m_end;
+	unsigned int m_remaining_symbols;
+	unsigned int m_next_state = 0;
+	uint32_t m_states[SymbolRans::NB_STATES];
+};
+
+void test_SymbolRansCoder();
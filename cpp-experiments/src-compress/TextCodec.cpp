@@ -0,0 +1,258 @@
+#include "TextCodec.h"
+
+#include "BitStream.h"
+#include "SymbolHuffmanCode.h"
+#include "string_view.h"
+
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+// Byte frequencies of the comments and string literals of the C headers of a Linux distribution
+// (/usr/include without the C++ library), scaled to 65535. Every byte has a code.
+static const uint16_t TEXT_BYTE_FREQUENCIES[256] = {
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 528, 4685, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	65535, 93, 1365, 81, 17, 44, 49, 646, 978, 987, 11358, 180, 1642, 6233, 4340, 10906,
+	883, 944, 923, 399, 317, 338, 343, 110, 286, 222, 1059, 198, 323, 842, 308, 20,
+	470, 1944, 652, 1947, 1139, 2191, 941, 671, 593, 2377, 102, 204, 1826, 941, 1651, 1500,
+	1190, 81, 1754, 2340, 2789, 993, 416, 383, 303, 292, 80, 120, 468, 115, 30, 2759,
+	238, 15939, 3671, 8731, 8088, 29398, 5837, 3805, 8345, 16785, 286, 1187, 9893, 5452, 15742, 15610,
+	6126, 317, 15050, 15181, 21805, 6836, 2546, 2384, 1162, 3054, 402, 134, 148, 133, 14, 1,
+	4, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 4, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 5, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+};
+
+static const unsigned int MODE_HUFFMAN = 0;
+static const unsigned int MODE_RAW = 1;
+
+struct TextDecodingEntry {
+	unsigned char bytes[2];
+	unsigned char first_length; // 0 if the bits don't start with a valid code
+	unsigned char pair_length;  // length of the 2 codes, 0 if the second one doesn't fit in the window
+};
+
+// Complete codes at the start of a window.
+struct TextSkipEntry {
+	unsigned char nb_codes;
+	unsigned char nb_bits;
+};
+
+struct TextModel {
+	unsigned char lengths[256];
+	uint16_t codes[256];
+	TextDecodingEntry decoding_table[1 << TextCodec::MAX_CODE_LENGTH];
+	TextSkipEntry skip_table[1 << TextCodec::MAX_CODE_LENGTH];
+};
+
+static TextModel build_text_model() {
+	const unsigned int window_bits = TextCodec::MAX_CODE_LENGTH;
+	TextModel model = {};
+	const std::vector<unsigned int> lengths = limited_huffman_code_lengths(
+		std::vector<uint64_t>(TEXT_BYTE_FREQUENCIES, TEXT_BYTE_FREQUENCIES + 256), window_bits);
+
+	// canonical codes, by increasing length then by increasing byte
+	unsigned int next_code = 0;
+	for (unsigned int length = 1; length <= window_bits; ++length) {
+		for (unsigned int c = 0; c < 256; ++c) {
+			if (lengths[c] != length)
+				continue;
+			model.lengths[c] = static_cast<unsigned char>(length);
+			model.codes[c] = static_cast<uint16_t>(next_code);
+			const unsigned int shift = window_bits - length;
+			for (unsigned int window = next_code << shift; window < (next_code + 1) << shift; ++window) {
+				model.decoding_table[window].bytes[0] = static_cast<unsigned char>(c);
+				model.decoding_table[window].first_length = static_cast<unsigned char>(length);
+			}
+			next_code += 1;
+		}
+		next_code <<= 1;
+	}
+
+	// second code of the window, when it fits
+	for (unsigned int window = 0; window < (1u << window_bits); ++window) {
+		TextDecodingEntry & entry = model.decoding_table[window];
+		if (entry.first_length == 0)
+			continue;
+		const unsigned int rest = (window << entry.first_length) & ((1u << window_bits) - 1);
+		const TextDecodingEntry & second = model.decoding_table[rest];
+		if (second.first_length != 0 && entry.first_length + second.first_length <= window_bits) {
+			entry.bytes[1] = second.bytes[0];
+			entry.pair_length = static_cast<unsigned char>(entry.first_length + second.first_length);
+		}
+	}
+
+	for (unsigned int window = 0; window < (1u << window_bits); ++window) {
+		TextSkipEntry & entry = model.skip_table[window];
+		unsigned int nb_bits = 0;
+		while (nb_bits < window_bits) {
+			const unsigned int rest = (window << nb_bits) & ((1u << window_bits) - 1);
+			const unsigned int length = model.decoding_table[rest].first_length;
+			if (length == 0 || nb_bits + length > window_bits)
+				break;
+			nb_bits += length;
+			entry.nb_codes += 1;
+		}
+		entry.nb_bits = static_cast<unsigned char>(nb_bits);
+	}
+	return model;
+}
+
+static const TextModel & text_model() {
+	static const TextModel model = build_text_model();
+	return model;
+}
+
+namespace TextCodec {
+	void encode(OutputBitStream & stream, string_view text) {
+		const TextModel & model = text_model();
+		uint64_t huffman_bits = 0;
+		for (int i = 0; i < text.length(); ++i) {
+			huffman_bits += model.lengths[static_cast<unsigned char>(text[i])];
+		}
+		const unsigned int padding = (8 - (stream.sizeInBits() + 1) % 8) % 8;
+		if (padding + 8 * static_cast<uint64_t>(text.length()) <= huffman_bits) {
+			stream.appendBits(MODE_RAW, 1);
+			stream.alignToByte();
+			stream.appendBytes(reinterpret_cast<const unsigned char *>(text.data()), text.length());
+			return;
+		}
+		stream.appendBits(MODE_HUFFMAN, 1);
+		for (int i = 0; i < text.length(); ++i) {
+			const unsigned char c = static_cast<unsigned char>(text[i]);
+			stream.appendBits(model.codes[c], model.lengths[c]);
+		}
+	}
+
+	void decode(InputBitStream & stream, unsigned int length, std::string & output) {
+		const size_t start = output.size();
+		if (stream.readBits(1) == MODE_RAW) {
+			stream.alignToByte();
+			const unsigned char * bytes = stream.readBytes(length);
+			output.append(reinterpret_cast<const char *>(bytes), length);
+			return;
+		}
+
+		const TextDecodingEntry * table = text_model().decoding_table;
+		output.resize(start + length);
+		char * chars = &output[start];
+		unsigned int i = 0;
+		while (i + 1 < length) {
+			const TextDecodingEntry & entry = table[stream.peekBits(MAX_CODE_LENGTH)];
+			if (likely(entry.pair_length != 0 && entry.pair_length <= stream.remainingBits())) {
+				chars[i] = static_cast<char>(entry.bytes[0]);
+				chars[i + 1] = static_cast<char>(entry.bytes[1]);
+				stream.consume(entry.pair_length);
+				i += 2;
+				continue;
+			}
+			if (unlikely(entry.first_length == 0 || entry.first_length > stream.remainingBits()))
+				throw make_logic_error("Invalid text code!");
+			chars[i++] = static_cast<char>(entry.bytes[0]);
+			stream.consume(entry.first_length);
+		}
+		if (i < length) {
+			const TextDecodingEntry & entry = table[stream.peekBits(MAX_CODE_LENGTH)];
+			if (unlikely(entry.first_length == 0 || entry.first_length > stream.remainingBits()))
+				throw make_logic_error("Invalid text code!");
+			chars[i] = static_cast<char>(entry.bytes[0]);
+			stream.consume(entry.first_length);
+		}
+	}
+
+	void skip(InputBitStream & stream, unsigned int length) {
+		if (stream.readBits(1) == MODE_RAW) {
+			stream.alignToByte();
+			if (static_cast<uint64_t>(length) * 8 > stream.remainingBits())
+				throw make_logic_error("Invalid text length!");
+			stream.skipBits(length * 8);
+			return;
+		}
+
+		const TextModel & model = text_model();
+		unsigned int i = 0;
+		while (i < length) {
+			const unsigned int window = stream.peekBits(MAX_CODE_LENGTH);
+			const TextSkipEntry & entry = model.skip_table[window];
+			if (likely(entry.nb_codes != 0 && entry.nb_codes <= length - i && entry.nb_bits <= stream.remainingBits())) {
+				stream.consume(entry.nb_bits);
+				i += entry.nb_codes;
+				continue;
+			}
+			// the last codes of the text, or of the stream
+			const unsigned int code_length = model.decoding_table[window].first_length;
+			if (unlikely(code_length == 0 || code_length > stream.remainingBits()))
+				throw make_logic_error("Invalid text code!");
+			stream.consume(code_length);
+			i += 1;
+		}
+	}
+
+	unsigned int codeLength(unsigned char c) {
+		return text_model().lengths[c];
+	}
+}
+
+// ----------------------------------------------------------------
+
+static void test_text_round_trip(const std::string & text, unsigned int offset) {
+	OutputBitStream output;
+	output.appendBits(0, offset);
+	TextCodec::encode(output, string_view(text.data(), static_cast<int>(text.size())));
+	output.appendBits(0b101, 3);
+
+	const PackedBits bits = output.release();
+	InputBitStream input(bits);
+	input.skipBits(offset);
+	std::string decoded = "prefix";
+	TextCodec::decode(input, static_cast<unsigned int>(text.size()), decoded);
+	assert(decoded == "prefix" + text);
+	assert(input.readBits(3) == 0b101);
+	assert(input.isEmpty());
+
+	InputBitStream skipped(bits);
+	skipped.skipBits(offset);
+	TextCodec::skip(skipped, static_cast<unsigned int>(text.size()));
+	assert(skipped.readBits(3) == 0b101);
+	assert(skipped.isEmpty());
+}
+
+void test_TextCodec() {
+	const TextModel & model = text_model();
+	unsigned int kraft_sum = 0;
+	for (unsigned int c = 0; c < 256; ++c) {
+		assert(model.lengths[c] > 0 && model.lengths[c] <= TextCodec::MAX_CODE_LENGTH);
+		kraft_sum += 1 << (TextCodec::MAX_CODE_LENGTH - model.lengths[c]);
+	}
+	assert(kraft_sum == (1u << TextCodec::MAX_CODE_LENGTH));
+	assert(TextCodec::codeLength(' ') < TextCodec::codeLength('e'));
+	assert(TextCodec::codeLength('e') < TextCodec::codeLength('Q'));
+
+	std::string all_bytes;
+	for (int i = 0; i < 256; ++i) {
+		all_bytes += static_cast<char>(i);
+	}
+	const std::string prose = "// Returns the number of elements in the container, see also size() and \"empty\".";
+	for (unsigned int offset : { 0, 1, 5, 7, 8 }) {
+		test_text_round_trip("", offset);
+		test_text_round_trip("x", offset);
+		test_text_round_trip("\"a\\\"b\\n\"", offset);
+		test_text_round_trip(prose, offset);
+		test_text_round_trip(all_bytes, offset);
+	}
+
+	// prose is Huffman coded, binary data is copied
+	OutputBitStream huffman;
+	TextCodec::encode(huffman, string_view(prose.data(), static_cast<int>(prose.size())));
+	assert(huffman.sizeInBits() < prose.size() * 6);
+	OutputBitStream raw;
+	raw.appendBits(0, 3);
+	TextCodec::encode(raw, string_view(all_bytes.data(), static_cast<int>(all_bytes.size())));
+	assert(raw.sizeInBits() == 8 + all_bytes.size() * 8);
+}
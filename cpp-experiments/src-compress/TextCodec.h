@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+class string_view;
+class OutputBitStream;
+class InputBitStream;
+
+// Payload of the COMMENT_BLOCK and STRING_BLOCK blocks (prose, escape sequences): a mode bit then
+// either the bytes coded with a static canonical Huffman code, built once from byte frequencies
+// measured on the comments and string literals of C headers, or, when that would not be smaller,
+// the raw bytes starting on a byte boundary (copied in one go by the decoder).
+// Decoding uses a table indexed by the next MAX_CODE_LENGTH bits, giving up to 2 bytes per lookup.
+namespace TextCodec {
+	static const unsigned int MAX_CODE_LENGTH = 12;
+
+	void encode(OutputBitStream & stream, string_view text);
+	// Appends the length bytes of the text to output.
+	void decode(InputBitStream & stream, unsigned int length, std::string & output);
+	// Moves the stream past the text without decoding it: the raw bytes are skipped at once, the
+	// Huffman codes several per lookup.
+	void skip(InputBitStream & stream, unsigned int length);
+
+	// Length in bits of the Huffman code of c.
+	unsigned int codeLength(unsigned char c);
+}
+
+void test_TextCodec();
@@ -0,0 +1,120 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <stdexcept>
+
+ThreadPool::ThreadPool(unsigned int nb_threads) {
+	if (nb_threads == 0) {
+		nb_threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	for (unsigned int i = 1; i < nb_threads; ++i) {
+		m_workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_work_available.notify_all();
+	for (std::thread & worker : m_workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> & task) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_task = &task;
+	m_count = count;
+	m_next = 0;
+	m_nb_done = 0;
+	m_error = nullptr;
+	m_work_available.notify_all();
+
+	runIterations(lock);
+	m_work_done.wait(lock, [this] { return m_nb_done == m_count; });
+
+	m_task = nullptr;
+	m_count = 0;
+	m_next = 0;
+	if (m_error) {
+		std::exception_ptr error = m_error;
+		m_error = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+void ThreadPool::workerLoop() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		m_work_available.wait(lock, [this] { return m_stopping || m_next < m_count; });
+		if (m_stopping)
+			return;
+		runIterations(lock);
+	}
+}
+
+void ThreadPool::runIterations(std::unique_lock<std::mutex> & lock) {
+	while (m_next < m_count) {
+		const size_t index = m_next++;
+		const std::function<void(size_t)> & task = *m_task;
+		lock.unlock();
+		std::exception_ptr error;
+		try {
+			task(index);
+		} catch (...) {
+			error = std::current_exception();
+		}
+		lock.lock();
+
+		m_nb_done += 1;
+		if (error && !m_error) {
+			m_error = error;
+			// skips the iterations not started yet
+			m_nb_done += m_count - m_next;
+			m_next = m_count;
+		}
+		if (m_nb_done == m_count) {
+			m_work_done.notify_all();
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+
+void test_ThreadPool() {
+	for (unsigned int nb_threads : { 1, 4 }) {
+		ThreadPool pool(nb_threads);
+		assert(pool.size() == nb_threads);
+
+		std::vector<int> results(1000, 0);
+		pool.parallelFor(results.size(), [&results](size_t i) { results[i] = static_cast<int>(i) * 2; });
+		for (size_t i = 0; i < results.size(); ++i) {
+			assert(results[i] == static_cast<int>(i) * 2);
+		}
+
+		pool.parallelFor(0, [](size_t) { assert(false); });
+
+		std::atomic<int> nb_calls(0);
+		bool thrown = false;
+		try {
+			pool.parallelFor(100, [&nb_calls](size_t i) {
+				nb_calls += 1;
+				if (i == 10)
+					throw std::runtime_error("task failure");
+			});
+		} catch (const std::runtime_error &) {
+			thrown = true;
+		}
+		assert(thrown);
+		assert(nb_calls <= 100);
+
+		// still usable after a failure
+		std::atomic<int> sum(0);
+		pool.parallelFor(10, [&sum](size_t i) { sum += static_cast<int>(i); });
+		assert(sum == 45);
+	}
+}
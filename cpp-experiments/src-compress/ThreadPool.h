@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running the iterations of parallelFor().
+class ThreadPool {
+public:
+	// nb_threads == 0 uses one thread per hardware thread. The thread calling parallelFor() counts
+	// as one of them, so ThreadPool(1) runs everything on the calling thread.
+	explicit ThreadPool(unsigned int nb_threads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool & operator=(const ThreadPool &) = delete;
+
+	unsigned int size() const {
+		return static_cast<unsigned int>(m_workers.size()) + 1;
+	}
+
+	// Calls task(i) for each i in [0, count) and returns once all of them are done.
+	// The first exception thrown by a task is rethrown here, the iterations not started yet are skipped.
+	void parallelFor(size_t count, const std::function<void(size_t)> & task);
+
+private:
+	void workerLoop();
+	// Runs the pending iterations until there are none left. m_mutex must be held by lock.
+	void runIterations(std::unique_lock<std::mutex> & lock);
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_work_available;
+	std::condition_variable m_work_done;
+	const std::function<void(size_t)> * m_task = nullptr;
+	size_t m_count = 0;
+	size_t m_next = 0;
+	size_t m_nb_done = 0;
+	std::exception_ptr m_error;
+	bool m_stopping = false;
+};
+
+void test_ThreadPool();
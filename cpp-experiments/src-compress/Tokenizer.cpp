@@ -0,0 +1,223 @@
+#include "Tokenizer.h"
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+// ASCII only: the std::is* functions depend on the locale and don't accept negative chars.
+static bool is_lower(char c) {
+	return c >= 'a' && c <= 'z';
+}
+
+static bool is_upper(char c) {
+	return c >= 'A' && c <= 'Z';
+}
+
+static bool is_digit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+static bool is_symbol_char(char c) {
+	return is_lower(c) || is_upper(c) || is_digit(c) || c == '_';
+}
+
+static bool is_blank(char c) {
+	return c == ' ' || c == '\t';
+}
+
+static bool is_space(char c) {
+	return c == ' ';
+}
+
+static bool is_special_char(char c) {
+	return (c > ' ' && c < 127 && !is_symbol_char(c)) || c == '\t';
+}
+
+static bool is_undetermined_char(char c) {
+	return !is_special_char(c) && !is_symbol_char(c) && c != ' ' && c != '\n' && c != '\r';
+}
+
+int Tokenizer::scanWhile(int pos, bool (*predicate)(char)) const {
+	while (pos < m_source.length() && predicate(m_source[pos])) {
+		pos += 1;
+	}
+	return pos;
+}
+
+int Tokenizer::scanComment(int pos) const {
+	assert(m_source[pos] == '/');
+	const int length = m_source.length();
+	if (m_source[pos + 1] == '/') {
+		// up to the end of line, which is left for the NEW_LINE block
+		pos += 2;
+		while (pos < length && m_source[pos] != '\n') {
+			pos += 1;
+		}
+		if (pos < length && m_source[pos - 1] == '\r') {
+			pos -= 1;
+		}
+		return pos;
+	}
+	pos += 2;
+	while (pos < length) {
+		if (m_source[pos] == '*' && pos + 1 < length && m_source[pos + 1] == '/') {
+			return pos + 2;
+		}
+		pos += 1;
+	}
+	return pos;
+}
+
+int Tokenizer::scanString(int pos) const {
+	const char quote = m_source[pos];
+	const int length = m_source.length();
+	pos += 1;
+	while (pos < length) {
+		const char c = m_source[pos];
+		if (c == quote) {
+			return pos + 1;
+		}
+		if (c == '\n' || (c == '\r' && pos + 1 < length && m_source[pos + 1] == '\n')) {
+			// unterminated literal
+			return pos;
+		}
+		if (c == '\\' && pos + 1 < length && m_source[pos + 1] != '\n') {
+			pos += 1;
+		}
+		pos += 1;
+	}
+	return pos;
+}
+
+int Tokenizer::scanSpecialChars(int pos) const {
+	const int length = m_source.length();
+	while (pos < length) {
+		const char c = m_source[pos];
+		if (!is_special_char(c) || c == '"' || c == '\'') {
+			break;
+		}
+		if (c == '/' && pos + 1 < length && (m_source[pos + 1] == '/' || m_source[pos + 1] == '*')) {
+			break;
+		}
+		pos += 1;
+	}
+	return pos;
+}
+
+int Tokenizer::nextScopeDepth(int depth, string_view special_chars) {
+	for (int i = 0; i < special_chars.length(); ++i) {
+		if (special_chars[i] == '{') {
+			depth += 1;
+		} else if (special_chars[i] == '}' && depth > 0) {
+			depth -= 1;
+		}
+	}
+	return depth;
+}
+
+bool Tokenizer::getNextBlock(Block & block) {
+	const int length = m_source.length();
+	if (m_pos >= length) {
+		return false;
+	}
+
+	const int start = m_pos;
+	const char c = m_source[start];
+	const bool at_line_start = m_at_line_start;
+	m_at_line_start = false;
+	int end;
+
+	if (at_line_start && is_blank(c)) {
+		block.type = INDENT_BLOCK;
+		end = scanWhile(start, is_blank);
+	} else if (c == '\n') {
+		block.type = NEW_LINE;
+		end = start + 1;
+		m_at_line_start = true;
+	} else if (c == '\r' && start + 1 < length && m_source[start + 1] == '\n') {
+		block.type = NEW_LINE;
+		end = start + 2;
+		m_at_line_start = true;
+	} else if (is_lower(c) || is_upper(c) || c == '_') {
+		block.type = (m_scope_depth > 0) ? NEW_SYMBOL_NAME_LOCAL_SCOPE : NEW_SYMBOL_NAME_GLOBAL_SCOPE;
+		end = scanWhile(start, is_symbol_char);
+	} else if (is_digit(c)) {
+		block.type = ENCODED_NUMBER;
+		end = scanWhile(start, is_symbol_char);
+	} else if (c == '/' && start + 1 < length && (m_source[start + 1] == '/' || m_source[start + 1] == '*')) {
+		block.type = COMMENT_BLOCK;
+		end = scanComment(start);
+	} else if (c == '"' || c == '\'') {
+		block.type = STRING_BLOCK;
+		end = scanString(start);
+	} else if (c == ' ') {
+		block.type = SEPARATOR;
+		end = scanWhile(start, is_space);
+	} else if (is_special_char(c)) {
+		block.type = SPECIAL_CHAR_BLOCK;
+		end = scanSpecialChars(start);
+	} else {
+		block.type = UNDETERMINED_BLOCK;
+		end = scanWhile(start + 1, is_undetermined_char);
+	}
+
+	assert(end > start);
+	block.text = string_view(m_source.data() + start, end - start);
+	if (block.type == SPECIAL_CHAR_BLOCK) {
+		m_scope_depth = nextScopeDepth(m_scope_depth, block.text);
+	}
+	m_pos = end;
+	return true;
+}
+
+// ----------------------------------------------------------------
+
+struct ExpectedBlock {
+	BLOCK_TYPE type;
+	const char * text;
+};
+
+static void test_tokenize(const char * source, std::vector<ExpectedBlock> expected) {
+	Tokenizer tokenizer(source);
+	Block block;
+	std::string concatenated;
+	for (const ExpectedBlock & expected_block : expected) {
+		assert(tokenizer.getNextBlock(block));
+		assert(block.type == expected_block.type);
+		assert(block.text == expected_block.text);
+		concatenated += block.text.to_string();
+	}
+	assert(!tokenizer.getNextBlock(block));
+	assert(concatenated == source);
+}
+
+void test_Tokenizer() {
+	assert(Tokenizer::nextScopeDepth(0, "{") == 1);
+	assert(Tokenizer::nextScopeDepth(1, "}};") == 0);
+	assert(Tokenizer::nextScopeDepth(2, "){}{") == 3);
+
+	test_tokenize("", {});
+	test_tokenize("int x = 42;\n", {
+		{ NEW_SYMBOL_NAME_GLOBAL_SCOPE, "int" }, { SEPARATOR, " " }, { NEW_SYMBOL_NAME_GLOBAL_SCOPE, "x" },
+		{ SEPARATOR, " " }, { SPECIAL_CHAR_BLOCK, "=" }, { SEPARATOR, " " }, { ENCODED_NUMBER, "42" },
+		{ SPECIAL_CHAR_BLOCK, ";" }, { NEW_LINE, "\n" } });
+	test_tokenize("void f() {\r\n\treturn;\r\n}", {
+		{ NEW_SYMBOL_NAME_GLOBAL_SCOPE, "void" }, { SEPARATOR, " " }, { NEW_SYMBOL_NAME_GLOBAL_SCOPE, "f" },
+		{ SPECIAL_CHAR_BLOCK, "()" }, { SEPARATOR, " " }, { SPECIAL_CHAR_BLOCK, "{" }, { NEW_LINE, "\r\n" },
+		{ INDENT_BLOCK, "\t" }, { NEW_SYMBOL_NAME_LOCAL_SCOPE, "return" }, { SPECIAL_CHAR_BLOCK, ";" },
+		{ NEW_LINE, "\r\n" }, { SPECIAL_CHAR_BLOCK, "}" } });
+	test_tokenize("a/b // c\r\n/* d\n*/x", {
+		{ NEW_SYMBOL_NAME_GLOBAL_SCOPE, "a" }, { SPECIAL_CHAR_BLOCK, "/" }, { NEW_SYMBOL_NAME_GLOBAL_SCOPE, "b" },
+		{ SEPARATOR, " " }, { COMMENT_BLOCK, "// c" }, { NEW_LINE, "\r\n" }, { COMMENT_BLOCK, "/* d\n*/" },
+		{ NEW_SYMBOL_NAME_GLOBAL_SCOPE, "x" } });
+	test_tokenize("s = \"a\\\"b\";'\\'' \"open\n", {
+		{ NEW_SYMBOL_NAME_GLOBAL_SCOPE, "s" }, { SEPARATOR, " " }, { SPECIAL_CHAR_BLOCK, "=" }, { SEPARATOR, " " },
+		{ STRING_BLOCK, "\"a\\\"b\"" }, { SPECIAL_CHAR_BLOCK, ";" }, { STRING_BLOCK, "'\\''" }, { SEPARATOR, " " },
+		{ STRING_BLOCK, "\"open" }, { NEW_LINE, "\n" } });
+	test_tokenize("x\xC3\xA9y\r/*", {
+		{ NEW_SYMBOL_NAME_GLOBAL_SCOPE, "x" }, { UNDETERMINED_BLOCK, "\xC3\xA9" }, { NEW_SYMBOL_NAME_GLOBAL_SCOPE, "y" },
+		{ UNDETERMINED_BLOCK, "\r" }, { COMMENT_BLOCK, "/*" } });
+	test_tokenize("0x1Fu+1.5e3", {
+		{ ENCODED_NUMBER, "0x1Fu" }, { SPECIAL_CHAR_BLOCK, "+" }, { ENCODED_NUMBER, "1" }, { SPECIAL_CHAR_BLOCK, "." },
+		{ ENCODED_NUMBER, "5e3" } });
+}
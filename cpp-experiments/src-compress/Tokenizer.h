@@ -0,0 +1,41 @@
+#pragma once
+
+#include "EncodingTables.h"
+#include "string_view.h"
+
+struct Block {
+	string_view text;
+	BLOCK_TYPE type;
+};
+
+// Splits a C/C++ source buffer into consecutive blocks (the concatenation of the blocks
+// gives back the source). Blocks are slices of the source buffer: nothing is allocated.
+class Tokenizer {
+public:
+	explicit Tokenizer(string_view source) : m_source(source) {
+	}
+
+	// Returns false once the whole source has been consumed.
+	bool getNextBlock(Block & block);
+
+	// Depth of the curly braces seen so far in SPECIAL_CHAR_BLOCK blocks.
+	int scopeDepth() const {
+		return m_scope_depth;
+	}
+
+	// Scope depth after a SPECIAL_CHAR_BLOCK, also used by the decoder to follow the scopes.
+	static int nextScopeDepth(int depth, string_view special_chars);
+
+private:
+	int scanWhile(int pos, bool (*predicate)(char)) const;
+	int scanComment(int pos) const;
+	int scanString(int pos) const;
+	int scanSpecialChars(int pos) const;
+
+	string_view m_source;
+	int m_pos = 0;
+	int m_scope_depth = 0;
+	bool m_at_line_start = true;
+};
+
+void test_Tokenizer();
@@ -0,0 +1,493 @@
+// Corpus benchmark suite (SrcCompressBench project), separate from the micro-benchmarks of
+// "SrcCompress --bench".
+//
+// SrcCompressBench [options] <C++ source files...>
+//   --identifiers <file>  symbol names, one per line (repeatable), other lines are skipped. By
+//                         default, the symbol names of the source files are used.
+//   --warmup <n>          untimed runs before measuring (default 1)
+//   --repetitions <n>     timed runs, the fastest one is reported (default 5)
+//   --json <file>         also writes the results as JSON
+//
+// gzip and zstd are measured on the same files when built with SRC_COMPRESS_WITH_ZLIB (link zlib)
+// and/or SRC_COMPRESS_WITH_ZSTD (link libzstd). Allocations are counted through operator new, so
+// the malloc calls of those libraries are not.
+
+#include "BitStream.h"
+#include "Encoder.h"
+#include "Decoder.h"
+#include "Tokenizer.h"
+#include "Compressor.h"
+#include "string_view.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef SRC_COMPRESS_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef SRC_COMPRESS_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+// ----------------------------------------------------------------
+// Heap allocations made while a benchmark runs.
+
+static std::atomic<size_t> g_nb_allocations(0);
+
+void * operator new(size_t size) {
+	g_nb_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void * memory = std::malloc(size == 0 ? 1 : size))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void * operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void * memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void * memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void * memory, size_t) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void * memory, size_t) noexcept {
+	std::free(memory);
+}
+
+// ----------------------------------------------------------------
+
+struct BenchOptions {
+	std::vector<std::string> source_files;
+	std::vector<std::string> identifier_files;
+	int nb_warmup_runs = 1;
+	int nb_repetitions = 5;
+	std::string json_path;
+};
+
+struct BenchResult {
+	std::string name;
+	double input_bytes;    // per run
+	double nb_symbols;     // per run: symbol names, tokenizer blocks or bit fields depending on the benchmark
+	double output_bits;    // per run: compressed size, 0 when not relevant (decoding)
+	double seconds;        // fastest run
+	double nb_allocations; // per run
+};
+
+// A benchmark run returns the number of bits it produced (0 for decoders).
+typedef std::function<double()> BenchRun;
+
+static BenchResult run_bench(const BenchOptions & options, const std::string & name, double input_bytes, double nb_symbols, const BenchRun & run) {
+	for (int i = 0; i < options.nb_warmup_runs; ++i) {
+		run();
+	}
+
+	BenchResult result = { name, input_bytes, nb_symbols, 0, 0, 0 };
+	for (int i = 0; i < options.nb_repetitions; ++i) {
+		const size_t nb_allocations = g_nb_allocations.load();
+		auto start = std::chrono::steady_clock::now();
+		result.output_bits = run();
+		auto stop = std::chrono::steady_clock::now();
+		result.nb_allocations = static_cast<double>(g_nb_allocations.load() - nb_allocations);
+
+		const double seconds = std::chrono::duration<double>(stop - start).count();
+		if (i == 0 || seconds < result.seconds) {
+			result.seconds = seconds;
+		}
+	}
+	return result;
+}
+
+static double mb_per_second(const BenchResult & result) {
+	return result.input_bytes / result.seconds / 1e6;
+}
+
+static double symbols_per_second(const BenchResult & result) {
+	return result.nb_symbols / result.seconds;
+}
+
+static double bits_per_symbol(const BenchResult & result) {
+	return (result.nb_symbols > 0) ? result.output_bits / result.nb_symbols : 0;
+}
+
+static double allocations_per_mb(const BenchResult & result) {
+	return (result.input_bytes > 0) ? result.nb_allocations / (result.input_bytes / 1e6) : 0;
+}
+
+// ----------------------------------------------------------------
+
+static bool is_symbol_name(const std::string & str) {
+	for (char c : str) {
+		if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'))
+			return false;
+	}
+	return true;
+}
+
+// Lines that are not made of [A-Za-z0-9_] only can't be encoded as symbol names: they are skipped.
+static std::vector<std::string> read_identifiers(const std::string & path) {
+	std::ifstream file(path);
+	if (!file)
+		throw std::runtime_error("Can't open " + path);
+	std::vector<std::string> identifiers;
+	std::string line;
+	size_t nb_skipped = 0;
+	while (std::getline(file, line)) {
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+		if (line.empty())
+			continue;
+		if (is_symbol_name(line)) {
+			identifiers.push_back(line);
+		} else {
+			nb_skipped += 1;
+		}
+	}
+	if (nb_skipped > 0) {
+		std::cerr << path << ": " << nb_skipped << " line(s) skipped, symbol names are made of [A-Za-z0-9_] only\n";
+	}
+	return identifiers;
+}
+
+static std::vector<std::string> extract_identifiers(const std::vector<std::string> & sources) {
+	std::vector<std::string> identifiers;
+	for (const std::string & source : sources) {
+		Tokenizer tokenizer(string_view(source.data(), static_cast<int>(source.size())));
+		Block block;
+		while (tokenizer.getNextBlock(block)) {
+			if (block.type == NEW_SYMBOL_NAME_LOCAL_SCOPE || block.type == NEW_SYMBOL_NAME_GLOBAL_SCOPE) {
+				identifiers.push_back(block.text.to_string());
+			}
+		}
+	}
+	return identifiers;
+}
+
+static size_t count_blocks(const std::vector<std::string> & sources) {
+	size_t nb_blocks = 0;
+	for (const std::string & source : sources) {
+		Tokenizer tokenizer(string_view(source.data(), static_cast<int>(source.size())));
+		Block block;
+		while (tokenizer.getNextBlock(block)) {
+			nb_blocks += 1;
+		}
+	}
+	return nb_blocks;
+}
+
+static void bench_symbol_names(const BenchOptions & options, const std::vector<std::string> & identifiers, std::vector<BenchResult> & results) {
+	double nb_chars = 0;
+	for (const std::string & identifier : identifiers) {
+		nb_chars += identifier.size();
+	}
+
+	std::vector<PackedBits> encoded(identifiers.size());
+	results.push_back(run_bench(options, "symbol_names/encode", nb_chars, static_cast<double>(identifiers.size()), [&]() {
+		double nb_bits = 0;
+		for (size_t i = 0; i < identifiers.size(); ++i) {
+			OutputBitStream stream;
+			string_view str(identifiers[i].data(), static_cast<int>(identifiers[i].size()));
+			Encoder::encodeNextSymbolName(stream, str);
+			nb_bits += stream.sizeInBits();
+			encoded[i] = stream.release();
+		}
+		return nb_bits;
+	}));
+	const double encoded_bits = results.back().output_bits;
+
+	std::vector<char> buffer(1 << 16);
+	BenchResult decode = run_bench(options, "symbol_names/decode", nb_chars, static_cast<double>(identifiers.size()), [&]() {
+		size_t length = 0;
+		for (const PackedBits & bits : encoded) {
+			InputBitStream stream(bits.data.data(), bits.sizeInBits);
+			length += Decoder::decodeNextSymbolName(stream, buffer.data(), buffer.size());
+		}
+		if (length != nb_chars)
+			throw std::runtime_error("symbol name decoding mismatch");
+		return 0.0;
+	});
+	decode.output_bits = encoded_bits;
+	results.push_back(decode);
+}
+
+static void bench_sources(const BenchOptions & options, const std::vector<std::string> & sources, std::vector<BenchResult> & results) {
+	double nb_bytes = 0;
+	for (const std::string & source : sources) {
+		nb_bytes += source.size();
+	}
+	const double nb_blocks = static_cast<double>(count_blocks(sources));
+
+	const std::pair<Compressor::SYMBOL_CODING, const char *> codings[] = {
+		{ Compressor::SYMBOL_CODING_FIXED, "fixed" },
+		{ Compressor::SYMBOL_CODING_HUFFMAN, "huffman" },
+		{ Compressor::SYMBOL_CODING_RANS, "rans" },
+	};
+	for (const auto & coding : codings) {
+		std::vector<PackedBits> compressed(sources.size());
+		results.push_back(run_bench(options, std::string("sources/compress/") + coding.second, nb_bytes, nb_blocks, [&]() {
+			double nb_bits = 0;
+			for (size_t i = 0; i < sources.size(); ++i) {
+				compressed[i] = Compressor::compress(string_view(sources[i].data(), static_cast<int>(sources[i].size())), coding.first);
+				nb_bits += compressed[i].sizeInBits;
+			}
+			return nb_bits;
+		}));
+		const double compressed_bits = results.back().output_bits;
+
+		BenchResult decompress = run_bench(options, std::string("sources/decompress/") + coding.second, nb_bytes, nb_blocks, [&]() {
+			for (size_t i = 0; i < sources.size(); ++i) {
+				InputBitStream stream(compressed[i].data.data(), compressed[i].sizeInBits);
+				if (Compressor::decompress(stream).size() != sources[i].size())
+					throw std::runtime_error("decompression mismatch");
+			}
+			return 0.0;
+		});
+		decompress.output_bits = compressed_bits;
+		results.push_back(decompress);
+	}
+}
+
+// keeps the reads from being optimized away
+static volatile unsigned int g_checksum;
+
+// Fields of 1 to 32 bits, the widths of the symbol codes, payloads and varuints mixed.
+static void bench_bit_streams(const BenchOptions & options, std::vector<BenchResult> & results) {
+	const size_t nb_fields = 1 << 22;
+	std::vector<unsigned char> widths(nb_fields);
+	std::vector<unsigned int> values(nb_fields);
+	unsigned int seed = 12345;
+	double nb_bits = 0;
+	for (size_t i = 0; i < nb_fields; ++i) {
+		seed = seed * 1103515245 + 12345;
+		widths[i] = static_cast<unsigned char>(1 + (seed >> 16) % 32);
+		seed = seed * 1103515245 + 12345;
+		values[i] = seed & static_cast<unsigned int>((uint64_t(1) << widths[i]) - 1);
+		nb_bits += widths[i];
+	}
+
+	PackedBits packed;
+	results.push_back(run_bench(options, "bitstream/write", nb_bits / 8, static_cast<double>(nb_fields), [&]() {
+		OutputBitStream stream;
+		stream.reserve(static_cast<size_t>(nb_bits));
+		for (size_t i = 0; i < nb_fields; ++i) {
+			stream.appendBits(values[i], widths[i]);
+		}
+		packed = stream.release();
+		return static_cast<double>(packed.sizeInBits);
+	}));
+
+	results.push_back(run_bench(options, "bitstream/read", nb_bits / 8, static_cast<double>(nb_fields), [&]() {
+		InputBitStream stream(packed.data.data(), packed.sizeInBits);
+		unsigned int checksum = 0;
+		for (size_t i = 0; i < nb_fields; ++i) {
+			checksum += stream.readBits(widths[i]);
+		}
+		g_checksum = checksum;
+		return 0.0;
+	}));
+}
+
+#ifdef SRC_COMPRESS_WITH_ZLIB
+static void bench_zlib(const BenchOptions & options, const std::vector<std::string> & sources, std::vector<BenchResult> & results) {
+	double nb_bytes = 0;
+	for (const std::string & source : sources) {
+		nb_bytes += source.size();
+	}
+	const double nb_blocks = static_cast<double>(count_blocks(sources));
+
+	std::vector<std::vector<unsigned char>> compressed(sources.size());
+	results.push_back(run_bench(options, "sources/compress/gzip", nb_bytes, nb_blocks, [&]() {
+		double nb_bits = 0;
+		for (size_t i = 0; i < sources.size(); ++i) {
+			uLongf size = compressBound(static_cast<uLong>(sources[i].size()));
+			compressed[i].resize(size);
+			if (compress2(compressed[i].data(), &size, reinterpret_cast<const Bytef *>(sources[i].data()), static_cast<uLong>(sources[i].size()), 6) != Z_OK)
+				throw std::runtime_error("zlib compression failed");
+			compressed[i].resize(size);
+			nb_bits += size * 8.0;
+		}
+		return nb_bits;
+	}));
+	const double compressed_bits = results.back().output_bits;
+
+	std::vector<unsigned char> output;
+	BenchResult decompress = run_bench(options, "sources/decompress/gzip", nb_bytes, nb_blocks, [&]() {
+		for (size_t i = 0; i < sources.size(); ++i) {
+			uLongf size = static_cast<uLongf>(sources[i].size());
+			output.resize(std::max<size_t>(1, size));
+			if (uncompress(output.data(), &size, compressed[i].data(), static_cast<uLong>(compressed[i].size())) != Z_OK || size != sources[i].size())
+				throw std::runtime_error("zlib decompression failed");
+		}
+		return 0.0;
+	});
+	decompress.output_bits = compressed_bits;
+	results.push_back(decompress);
+}
+#endif
+
+#ifdef SRC_COMPRESS_WITH_ZSTD
+static void bench_zstd(const BenchOptions & options, const std::vector<std::string> & sources, std::vector<BenchResult> & results) {
+	double nb_bytes = 0;
+	for (const std::string & source : sources) {
+		nb_bytes += source.size();
+	}
+	const double nb_blocks = static_cast<double>(count_blocks(sources));
+
+	std::vector<std::vector<unsigned char>> compressed(sources.size());
+	results.push_back(run_bench(options, "sources/compress/zstd", nb_bytes, nb_blocks, [&]() {
+		double nb_bits = 0;
+		for (size_t i = 0; i < sources.size(); ++i) {
+			compressed[i].resize(ZSTD_compressBound(sources[i].size()));
+			const size_t size = ZSTD_compress(compressed[i].data(), compressed[i].size(), sources[i].data(), sources[i].size(), 3);
+			if (ZSTD_isError(size))
+				throw std::runtime_error("zstd compression failed");
+			compressed[i].resize(size);
+			nb_bits += size * 8.0;
+		}
+		return nb_bits;
+	}));
+	const double compressed_bits = results.back().output_bits;
+
+	std::vector<char> output;
+	BenchResult decompress = run_bench(options, "sources/decompress/zstd", nb_bytes, nb_blocks, [&]() {
+		for (size_t i = 0; i < sources.size(); ++i) {
+			output.resize(std::max<size_t>(1, sources[i].size()));
+			const size_t size = ZSTD_decompress(output.data(), output.size(), compressed[i].data(), compressed[i].size());
+			if (ZSTD_isError(size) || size != sources[i].size())
+				throw std::runtime_error("zstd decompression failed");
+		}
+		return 0.0;
+	});
+	decompress.output_bits = compressed_bits;
+	results.push_back(decompress);
+}
+#endif
+
+// ----------------------------------------------------------------
+
+static void print_results(const std::vector<BenchResult> & results) {
+	for (const BenchResult & result : results) {
+		std::cout << result.name << "\n"
+			<< "- " << mb_per_second(result) << " MB/s, " << symbols_per_second(result) / 1e6 << " M symbols/s\n"
+			<< "- " << bits_per_symbol(result) << " bits/symbol, " << allocations_per_mb(result) << " allocations/MB\n";
+	}
+}
+
+static std::string json_string(const std::string & str) {
+	std::string quoted = "\"";
+	for (char c : str) {
+		if (c == '"' || c == '\\') {
+			quoted += '\\';
+		}
+		quoted += c;
+	}
+	return quoted + "\"";
+}
+
+static void write_json(const std::string & path, const BenchOptions & options, size_t nb_source_bytes, size_t nb_identifiers, const std::vector<BenchResult> & results) {
+	std::ostringstream json;
+	json << "{\n"
+		<< "  \"corpus\": { \"files\": " << options.source_files.size() << ", \"bytes\": " << nb_source_bytes
+		<< ", \"identifiers\": " << nb_identifiers << " },\n"
+		<< "  \"warmup\": " << options.nb_warmup_runs << ",\n"
+		<< "  \"repetitions\": " << options.nb_repetitions << ",\n"
+		<< "  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); ++i) {
+		const BenchResult & result = results[i];
+		json << "    { \"name\": " << json_string(result.name)
+			<< ", \"seconds\": " << result.seconds
+			<< ", \"mb_per_s\": " << mb_per_second(result)
+			<< ", \"symbols_per_s\": " << symbols_per_second(result)
+			<< ", \"bits_per_symbol\": " << bits_per_symbol(result)
+			<< ", \"ratio\": " << ((result.input_bytes > 0) ? result.output_bits / 8 / result.input_bytes : 0)
+			<< ", \"allocations_per_mb\": " << allocations_per_mb(result) << " }"
+			<< (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	json << "  ]\n}\n";
+	const std::string content = json.str();
+	Compressor::writeFile(path, content.data(), content.size());
+}
+
+static BenchOptions parse_options(int argc, char * argv[]) {
+	BenchOptions options;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		const bool has_value = (i + 1 < argc);
+		if (arg == "--identifiers" && has_value) {
+			options.identifier_files.push_back(argv[++i]);
+		} else if (arg == "--warmup" && has_value) {
+			options.nb_warmup_runs = std::max(0, std::atoi(argv[++i]));
+		} else if (arg == "--repetitions" && has_value) {
+			options.nb_repetitions = std::max(1, std::atoi(argv[++i]));
+		} else if (arg == "--json" && has_value) {
+			options.json_path = argv[++i];
+		} else if (arg.compare(0, 2, "--") == 0) {
+			throw std::runtime_error("Unknown option " + arg);
+		} else {
+			options.source_files.push_back(arg);
+		}
+	}
+	return options;
+}
+
+int main(int argc, char * argv[]) {
+	try {
+		const BenchOptions options = parse_options(argc, argv);
+
+		std::vector<std::string> sources;
+		size_t nb_source_bytes = 0;
+		for (const std::string & path : options.source_files) {
+			sources.push_back(Compressor::readFile(path));
+			nb_source_bytes += sources.back().size();
+		}
+		std::vector<std::string> identifiers;
+		for (const std::string & path : options.identifier_files) {
+			const std::vector<std::string> file_identifiers = read_identifiers(path);
+			identifiers.insert(identifiers.end(), file_identifiers.begin(), file_identifiers.end());
+		}
+		if (identifiers.empty()) {
+			identifiers = extract_identifiers(sources);
+		}
+
+		std::vector<BenchResult> results;
+		if (!identifiers.empty()) {
+			bench_symbol_names(options, identifiers, results);
+		}
+		if (!sources.empty()) {
+			bench_sources(options, sources, results);
+#ifdef SRC_COMPRESS_WITH_ZLIB
+			bench_zlib(options, sources, results);
+#endif
+#ifdef SRC_COMPRESS_WITH_ZSTD
+			bench_zstd(options, sources, results);
+#endif
+		}
+		bench_bit_streams(options, results);
+
+		std::cout << "Corpus: " << sources.size() << " files, " << nb_source_bytes << " bytes, " << identifiers.size() << " identifiers\n";
+		print_results(results);
+		if (!options.json_path.empty()) {
+			write_json(options.json_path, options, nb_source_bytes, identifiers.size(), results);
+		}
+	} catch (const std::exception & error) {
+		std::cerr << error.what() << "\n";
+		return 1;
+	}
+	return 0;
+}
@@ -1,5 +1,8 @@
 #include <cassert>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "string_view.h"
 
@@ -7,6 +10,26 @@
 #include "EncodingTables.h"
 #include "Encoder.h"
 #include "Decoder.h"
+#include "SymbolCodeUnpacker.h"
+#include "CharClassifier.h"
+#include "Tokenizer.h"
+#include "SymbolDictionary.h"
+#include "SymbolHuffmanCode.h"
+#include "SymbolRansCoder.h"
+#include "TextCodec.h"
+#include "IndentModel.h"
+#include "Keywords.h"
+#include "ConstexprEncoder.h"
+#include "Compressor.h"
+#include "ThreadPool.h"
+#include "Archive.h"
+#include "MappedFile.h"
+#include "MappedArchive.h"
+#include "SharedDictionary.h"
+#include "StreamCompressor.h"
+#include "CompressionStatistics.h"
+#include "Sha256.h"
+#include "Benchmark.h"
 
 //template<typename T>
 //class optional {
@@ -19,37 +42,6 @@
 
 
 
-enum BLOCK_TYPE {
-	NEW_SYMBOL_NAME_LOCAL_SCOPE,
-	NEW_SYMBOL_NAME_GLOBAL_SCOPE,
-	SYMBOL_NAME_REFERENCE_LOCAL,
-	SYMBOL_NAME_REFERENCE_GLOBAL,
-
-	//COMMENT_BLOCK,
-	//ENCODED_SYMBOL,
-	//SEPARATOR,
-	//ENCODED_NUMBER,
-	//STRING_BLOCK,
-	//SPECIAL_CHAR_BLOCK,
-	//REPEATER,
-	//UNDETERMINED_BLOCK,
-
-	//INDENT_BLOCK,
-	//NEW_LINE,
-};
-
-struct SymbolName {
-	std::string text;
-	unsigned int id;
-};
-
-struct Block {
-	string_view text;
-	BLOCK_TYPE type;
-};
-
-//Block get_next_block();
-
 
 void test_StringView() {
 	string_view str("abc");
@@ -63,23 +55,126 @@ static void test_symbol_name_encode_decode(const char * text) {
 	string_view str(text);
 	Encoder::encodeNextSymbolName(output, str);
 	assert(str.empty());
-	InputBitStream input(output.toString());
-	assert(input.remainingBits() == output.sizeInBits());
+	const unsigned int size_in_bits = output.sizeInBits();
+	InputBitStream input(output.release());
+	assert(input.remainingBits() == size_in_bits);
 	std::string decoded = Decoder::decodeNextSymbolName(input);
 	assert(decoded == text);
 	assert(input.isEmpty());
 }
 
-int main() {
-	//Block b = get_next_block();
-	//if (b.type == SYMBOL_TEXT) {
-	//	encode_symbol_text(b.text);
-	//}
+// The SharedDictionary whose path is argv[index], if any.
+static std::unique_ptr<SharedDictionary> load_dictionary(int argc, char * argv[], int index) {
+	return std::unique_ptr<SharedDictionary>((index < argc) ? new SharedDictionary(argv[index]) : nullptr);
+}
+
+int main(int argc, char * argv[]) {
+	if ((argc == 4 || argc == 5) && std::string(argv[1]) == "--compress") {
+		Compressor::compressFile(argv[2], argv[3], load_dictionary(argc, argv, 4).get());
+		return 0;
+	}
+	if ((argc == 4 || argc == 5) && std::string(argv[1]) == "--decompress") {
+		Compressor::decompressFile(argv[2], argv[3], load_dictionary(argc, argv, 4).get());
+		return 0;
+	}
+	if (argc >= 3 && std::string(argv[1]) == "--train") {
+		SharedDictionary::trainFile(argv[2], std::vector<std::string>(argv + 3, argv + argc));
+		return 0;
+	}
+	if (argc == 4 && std::string(argv[1]) == "--archive") {
+		Archive::compressFile(argv[2], argv[3]);
+		return 0;
+	}
+	if (argc == 4 && std::string(argv[1]) == "--extract") {
+		Archive::decompressFile(argv[2], argv[3]);
+		return 0;
+	}
+	if (argc == 4 && std::string(argv[1]) == "--stream-compress") {
+		StreamCompressor::compressFile(argv[2], argv[3]);
+		return 0;
+	}
+	if (argc == 4 && std::string(argv[1]) == "--stream-decompress") {
+		StreamCompressor::decompressFile(argv[2], argv[3]);
+		return 0;
+	}
+	if (argc >= 3 && std::string(argv[1]) == "--pack") {
+		MappedArchive::buildFile(argv[2], std::vector<std::string>(argv + 3, argv + argc));
+		return 0;
+	}
+	if (argc >= 4 && std::string(argv[1]) == "--repack") {
+		// only the files that changed since the previous archive are compressed
+		MappedArchive::updateFile(argv[2], argv[3], std::vector<std::string>(argv + 4, argv + argc));
+		return 0;
+	}
+	if (argc >= 4 && std::string(argv[1]) == "--pack-shared") {
+		const SharedDictionary dictionary(argv[2]);
+		MappedArchive::buildFile(argv[3], std::vector<std::string>(argv + 4, argv + argc), &dictionary);
+		return 0;
+	}
+	if ((argc == 4 || argc == 5) && std::string(argv[1]) == "--grep") {
+		// paths of the files of the archive with the symbol name
+		const std::unique_ptr<SharedDictionary> dictionary = load_dictionary(argc, argv, 4);
+		const MappedArchive archive(argv[2]);
+		ThreadPool pool;
+		for (size_t index : archive.findSymbolName(argv[3], pool, dictionary.get())) {
+			const string_view path = archive.path(index);
+			std::cout << std::string(path.data(), path.length()) << "\n";
+		}
+		return 0;
+	}
+	if (argc >= 3 && std::string(argv[1]) == "--stats") {
+		// a JSON array of the statistics of the compression of the source files, one object per symbol coding
+		std::string json = "[\n";
+		for (auto coding : { Compressor::SYMBOL_CODING_FIXED, Compressor::SYMBOL_CODING_HUFFMAN, Compressor::SYMBOL_CODING_RANS,
+			Compressor::SYMBOL_CODING_INTERLEAVED }) {
+			CompressionStatistics statistics;
+			for (int i = 3; i < argc; ++i) {
+				const std::string source = Compressor::readFile(argv[i]);
+				Compressor::compress(string_view(source.data(), static_cast<int>(source.length())), coding, nullptr, statistics);
+			}
+			json += (coding == Compressor::SYMBOL_CODING_FIXED ? "" : ",\n") + statistics.toJson();
+		}
+		json += "\n]\n";
+		Compressor::writeFile(argv[2], json.data(), json.size());
+		return 0;
+	}
+	if ((argc == 5 || argc == 6) && std::string(argv[1]) == "--unpack") {
+		const std::unique_ptr<SharedDictionary> dictionary = load_dictionary(argc, argv, 5);
+		const MappedArchive archive(argv[2]);
+		const size_t index = archive.find(argv[3]);
+		if (index == MappedArchive::NOT_FOUND) {
+			std::cerr << argv[3] << " is not in " << argv[2] << "\n";
+			return 1;
+		}
+		const std::string source = archive.decompress(index, dictionary.get());
+		Compressor::writeFile(argv[4], source.data(), source.size());
+		return 0;
+	}
 
 	test_StringView();
 	test_OutputBitStream();
 	test_InputBitStream();
+	test_CharClassifier();
 	test_Encoder();
+	test_SymbolCodeUnpacker();
+	test_Decoder();
+	test_Tokenizer();
+	test_SymbolDictionary();
+	test_SymbolHuffmanCode();
+	test_SymbolRansCoder();
+	test_TextCodec();
+	test_IndentModel();
+	test_Keywords();
+	test_ConstexprEncoder();
+	test_Compressor();
+	test_ThreadPool();
+	test_Archive();
+	test_Sha256();
+	test_MappedFile();
+	test_MappedArchive();
+	test_SharedDictionary();
+	test_StreamCompressor();
+	test_CompressionStatistics();
 
 	test_symbol_name_encode_decode("ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz_0123456789");
 	test_symbol_name_encode_decode("aClass");
@@ -93,5 +188,9 @@ int main() {
 	test_symbol_name_encode_decode("_1091673");
 	test_symbol_name_encode_decode("_3671091");
 	test_symbol_name_encode_decode("_10911092");
-}
 
+	if (argc > 1 && std::string(argv[1]) == "--bench") {
+		// the remaining arguments are the source files used as corpus
+		run_benchmarks(std::vector<std::string>(argv + 2, argv + argc));
+	}
+}
\ No newline at end of file
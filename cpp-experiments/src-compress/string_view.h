@@ -1,13 +1,21 @@
 #pragma once
 
 #include <string>
+#include <cstring>
 #include <cassert>
 
 class string_view {
 public:
+	string_view() : m_begin(""), m_length(0) {
+	}
+
 	string_view(const char * str) : m_begin(str), m_length(std::strlen(str)) {
 	}
 
+	string_view(const char * str, int length) : m_begin(str), m_length(length) {
+		assert(length >= 0);
+	}
+
 	string_view(const string_view & str, int pos, int nb_char) : m_begin(str.m_begin + pos), m_length(nb_char) {
 		assert(pos >= 0 && nb_char >= 1);
 		assert(pos + nb_char <= str.length());
@@ -25,6 +33,11 @@ public:
 		m_length = 0;
 	}
 
+	// Unlike begin(), can be called on an empty view.
+	const char * data() const {
+		return m_begin;
+	}
+
 	const char * begin() const {
 		assert(m_length > 0);
 		return m_begin;
@@ -54,4 +67,6 @@ private:
 	int m_length;
 };
 
-//bool operator==(const string_view & lhs, const string_view & rhs);
+inline bool operator==(const string_view & lhs, const string_view & rhs) {
+	return lhs.length() == rhs.length() && std::memcmp(lhs.data(), rhs.data(), lhs.length()) == 0;
+}